@@ -0,0 +1,139 @@
+#include "../src/common/integrator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using netproj::Integrator;
+using netproj::MethodType;
+
+namespace {
+
+/**
+ * @brief Benchmarked intervals: the README reference range, a range close to the singularity and a wide one.
+ */
+struct Interval {
+    double a;
+    double b;
+};
+
+constexpr Interval kIntervals[] = {{2.0, 10.0}, {1.05, 1.5}, {10.0, 1000.0}};
+
+/**
+ * @brief Reference li(x) for x > 1: gamma + ln ln x + sum (ln x)^n / (n * n!), all terms positive.
+ */
+double logIntegral(double x) {
+    constexpr double kEulerGamma = 0.57721566490153286061;
+    const double t = std::log(x);
+    double term = 1.0;
+    double sum = 0.0;
+    for (int n = 1; n < 200; ++n) {
+        term *= t / n;
+        const double add = term / n;
+        sum += add;
+        if (add < 1e-17 * sum) {
+            break;
+        }
+    }
+    return kEulerGamma + std::log(t) + sum;
+}
+
+/**
+ * @brief Attach throughput and accuracy counters shared by all integrator benchmarks.
+ * @param nodes Evaluations of f(x) per iteration.
+ */
+void setCounters(benchmark::State &state, double nodes, const Interval &iv, double value) {
+    state.counters["nodes"] = nodes;
+    state.counters["nodes_per_s"] = benchmark::Counter(nodes, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["ns_per_node"] = benchmark::Counter(
+        nodes * 1e-9, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["abs_error"] = std::abs(value - (logIntegral(iv.b) - logIntegral(iv.a)));
+}
+
+/**
+ * @brief Args: method (1-3), step exponent k (h = 10^-k), interval index.
+ */
+void BM_Integrate(benchmark::State &state) {
+    const MethodType method = netproj::parseMethod(static_cast<int>(state.range(0)));
+    const double h = std::pow(10.0, -static_cast<double>(state.range(1)));
+    const Interval &iv = kIntervals[state.range(2)];
+
+    double value = 0.0;
+    for (auto _ : state) {
+        value = Integrator::integrate(iv.a, iv.b, h, method);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetLabel(netproj::methodName(method).toStdString());
+    setCounters(state, static_cast<double>(Integrator::evaluationCount(iv.a, iv.b, h, method)), iv, value);
+}
+
+/**
+ * @brief Args: method (1-3), step exponent k, interval index, threads. Splits like a client does for one unit.
+ */
+void BM_IntegrateThreads(benchmark::State &state) {
+    const MethodType method = netproj::parseMethod(static_cast<int>(state.range(0)));
+    const double h = std::pow(10.0, -static_cast<double>(state.range(1)));
+    const Interval &iv = kIntervals[state.range(2)];
+    const int threads = static_cast<int>(state.range(3));
+
+    const std::vector<netproj::Segment> segments = Integrator::partition(iv.a, iv.b, h, threads);
+    std::vector<double> partial(segments.size());
+    // Every thread integrates its own segment, so e.g. Simpson evaluates the shared ends of segments twice.
+    double nodes = 0.0;
+    for (const netproj::Segment &s : segments) {
+        nodes += static_cast<double>(Integrator::evaluationCount(s.a, s.b, h, method));
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(segments.size());
+
+    double value = 0.0;
+    for (auto _ : state) {
+        pool.clear();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            pool.emplace_back([&, i]() {
+                partial[i] = Integrator::integrate(segments[i].a, segments[i].b, h, method);
+            });
+        }
+        value = 0.0;
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+            value += partial[i];
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetLabel(netproj::methodName(method).toStdString());
+    setCounters(state, nodes, iv, value);
+}
+
+void integrateArgs(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"method", "step_exp", "interval"});
+    for (int method = 1; method <= 3; ++method) {
+        for (int k = 3; k <= 6; ++k) {
+            for (int iv = 0; iv < static_cast<int>(std::size(kIntervals)); ++iv) {
+                // Keep each iteration around a second or less.
+                if (Integrator::stepCount(kIntervals[iv].a, kIntervals[iv].b, std::pow(10.0, -k)) <= 100000000) {
+                    b->Args({method, k, iv});
+                }
+            }
+        }
+    }
+}
+
+void threadArgs(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"method", "step_exp", "interval", "threads"});
+    const int hw = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int method = 1; method <= 3; ++method) {
+        for (int t = 1; t <= hw; t *= 2) {
+            b->Args({method, 6, 0, t});
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_Integrate)->Apply(integrateArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IntegrateThreads)->Apply(threadArgs)->Unit(benchmark::kMillisecond)->UseRealTime();
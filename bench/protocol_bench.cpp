@@ -0,0 +1,265 @@
+#include "../src/common/alloc_counter.h"
+#include "../src/common/frame_decoder.h"
+#include "../src/common/message_codec.h"
+#include "../src/common/message_io.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace netproj;
+
+namespace {
+
+HelloMsg sampleHello() {
+    HelloMsg m;
+    m.cores = 16;
+    m.workerId = "worker-node-17.cluster.local";
+    return m;
+}
+
+TaskMsg sampleTask() {
+    TaskMsg m;
+    m.a = 2.0;
+    m.b = 2.5;
+    m.h = 1e-7;
+    m.clientIndex = 3;
+    m.clientCount = 8;
+    m.jobId = 42;
+    m.unitId = 4242;
+    return m;
+}
+
+ResultMsg sampleResult(int blocks) {
+    ResultMsg m;
+    m.jobId = 42;
+    m.unitId = 4242;
+    m.value = 0.3141592653589793;
+    m.computeMs = 12.5;
+    for (int i = 0; i < blocks; ++i) {
+        m.blockSums.push_back(m.value / blocks);
+    }
+    return m;
+}
+
+CancelMsg sampleCancel() {
+    CancelMsg m;
+    m.jobId = 42;
+    m.unitId = 4242;
+    return m;
+}
+
+SubmitMsg sampleSubmit() {
+    SubmitMsg m;
+    m.requestId = 7;
+    m.tenant = "physics";
+    m.priority = JobPriority::Interactive;
+    m.a = 2.0;
+    m.b = 10.0;
+    m.h = 1e-6;
+    return m;
+}
+
+JobResultMsg sampleJobResult() {
+    JobResultMsg m;
+    m.requestId = 7;
+    m.jobId = 42;
+    m.value = 5.120435;
+    m.elapsedMs = 120;
+    m.dispatchMs = 1;
+    m.computeMs = 800.0;
+    m.networkMs = 3.5;
+    m.units = 16;
+    m.workerComputeMs.insert("worker-1", 400.0);
+    m.workerComputeMs.insert("worker-2", 400.0);
+    return m;
+}
+
+/**
+ * @brief Report messages/s, allocations and bytes per message for a loop that handled one message per iteration.
+ */
+void setMessageCounters(benchmark::State &state, std::size_t allocations, qsizetype bytes) {
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_msg"] = static_cast<double>(bytes);
+    if (allocationCountingSupported()) {
+        state.counters["allocs_per_msg"] =
+            benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    }
+}
+
+template <class Msg>
+void BM_Serialize(benchmark::State &state, Msg msg, QByteArray (*serialize)(const Msg &)) {
+    qsizetype bytes = 0;
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        const QByteArray payload = serialize(msg);
+        bytes = payload.size();
+        benchmark::DoNotOptimize(payload.constData());
+    }
+    setMessageCounters(state, allocationCount() - before, bytes);
+}
+
+void BM_Parse(benchmark::State &state, QByteArray payload) {
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        const ParsedMessage pm = parseMessage(payload);
+        benchmark::DoNotOptimize(pm.ok);
+    }
+    setMessageCounters(state, allocationCount() - before, payload.size());
+}
+
+template <class Msg>
+void BM_CodecSerialize(benchmark::State &state, MessageType type, Msg msg) {
+    MessageCodec codec;
+    qsizetype bytes = codec.serialize(type, msg).size();
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        const QByteArray &payload = codec.serialize(type, msg);
+        bytes = payload.size();
+        benchmark::DoNotOptimize(payload.constData());
+    }
+    setMessageCounters(state, allocationCount() - before, bytes);
+}
+
+void BM_CodecParse(benchmark::State &state, QByteArray payload) {
+    MessageCodec codec;
+    codec.parse(payload);
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        const ParsedMessage &pm = codec.parse(payload);
+        benchmark::DoNotOptimize(pm.ok);
+    }
+    setMessageCounters(state, allocationCount() - before, payload.size());
+}
+
+/**
+ * @brief A stream of frames encoded TASK messages, cut into reads of chunk bytes (0 = all frames in one read).
+ */
+std::vector<QByteArray> frameReads(qsizetype chunk, int frames, qsizetype *streamSize) {
+    QByteArray stream;
+    for (int i = 0; i < frames; ++i) {
+        stream.append(FrameDecoder::encode(serializeTask(sampleTask())));
+    }
+    std::vector<QByteArray> reads;
+    const qsizetype step = (chunk > 0) ? chunk : stream.size();
+    for (qsizetype off = 0; off < stream.size(); off += step) {
+        reads.push_back(stream.mid(off, step));
+    }
+    *streamSize = stream.size();
+    return reads;
+}
+
+void setFrameCounters(benchmark::State &state, int frames, qsizetype streamSize, std::size_t allocations) {
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.SetBytesProcessed(state.iterations() * streamSize);
+    if (allocationCountingSupported()) {
+        state.counters["allocs_per_msg"] = benchmark::Counter(static_cast<double>(allocations) / frames,
+                                                              benchmark::Counter::kAvgIterations);
+    }
+}
+
+/**
+ * @brief Args: read size in bytes (0 = all frames in one read), frames per batch.
+ *
+ * Small reads model fragmentation on a congested link, one large read models many frames coalesced by TCP.
+ */
+void BM_FrameDecode(benchmark::State &state) {
+    const int frames = static_cast<int>(state.range(1));
+    qsizetype streamSize = 0;
+    const std::vector<QByteArray> reads = frameReads(static_cast<qsizetype>(state.range(0)), frames, &streamSize);
+
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        FrameDecoder decoder;
+        QByteArray payload;
+        int got = 0;
+        for (const QByteArray &r : reads) {
+            decoder.append(r);
+            while (decoder.next(&payload)) {
+                ++got;
+            }
+        }
+        benchmark::DoNotOptimize(got);
+    }
+    setFrameCounters(state, frames, streamSize, allocationCount() - before);
+}
+
+/**
+ * @brief Like BM_FrameDecode, but as FramedSocket reads: into prepareAppend() and out through nextView(), with one
+ * decoder for the whole connection.
+ */
+void BM_FrameDecodeInPlace(benchmark::State &state) {
+    const int frames = static_cast<int>(state.range(1));
+    qsizetype streamSize = 0;
+    const std::vector<QByteArray> reads = frameReads(static_cast<qsizetype>(state.range(0)), frames, &streamSize);
+
+    FrameDecoder decoder;
+    QByteArray payload;
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        int got = 0;
+        for (const QByteArray &r : reads) {
+            std::memcpy(decoder.prepareAppend(r.size()), r.constData(), static_cast<std::size_t>(r.size()));
+            decoder.commitAppend(r.size());
+            while (decoder.nextView(&payload)) {
+                ++got;
+            }
+        }
+        benchmark::DoNotOptimize(got);
+    }
+    setFrameCounters(state, frames, streamSize, allocationCount() - before);
+}
+
+void BM_FrameEncode(benchmark::State &state) {
+    const QByteArray payload = serializeTask(sampleTask());
+    const std::size_t before = allocationCount();
+    for (auto _ : state) {
+        const QByteArray frame = FrameDecoder::encode(payload);
+        benchmark::DoNotOptimize(frame.constData());
+    }
+    setMessageCounters(state, allocationCount() - before, payload.size() + FrameDecoder::kHeaderSize);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_Serialize, hello, sampleHello(), &serializeHello);
+BENCHMARK_CAPTURE(BM_Serialize, task, sampleTask(), &serializeTask);
+BENCHMARK_CAPTURE(BM_Serialize, result, sampleResult(0), &serializeResult);
+BENCHMARK_CAPTURE(BM_Serialize, result_32_blocks, sampleResult(32), &serializeResult);
+BENCHMARK_CAPTURE(BM_Serialize, cancel, sampleCancel(), &serializeCancel);
+BENCHMARK_CAPTURE(BM_Serialize, submit, sampleSubmit(), &serializeSubmit);
+BENCHMARK_CAPTURE(BM_Serialize, job_result, sampleJobResult(), &serializeJobResult);
+
+BENCHMARK_CAPTURE(BM_Parse, hello, serializeHello(sampleHello()));
+BENCHMARK_CAPTURE(BM_Parse, task, serializeTask(sampleTask()));
+BENCHMARK_CAPTURE(BM_Parse, result, serializeResult(sampleResult(0)));
+BENCHMARK_CAPTURE(BM_Parse, result_32_blocks, serializeResult(sampleResult(32)));
+BENCHMARK_CAPTURE(BM_Parse, cancel, serializeCancel(sampleCancel()));
+BENCHMARK_CAPTURE(BM_Parse, submit, serializeSubmit(sampleSubmit()));
+BENCHMARK_CAPTURE(BM_Parse, job_result, serializeJobResult(sampleJobResult()));
+
+BENCHMARK_CAPTURE(BM_CodecSerialize, task, MessageType::Task, sampleTask());
+BENCHMARK_CAPTURE(BM_CodecSerialize, result_32_blocks, MessageType::Result, sampleResult(32));
+BENCHMARK_CAPTURE(BM_CodecParse, task, serializeTask(sampleTask()));
+BENCHMARK_CAPTURE(BM_CodecParse, result_32_blocks, serializeResult(sampleResult(32)));
+
+BENCHMARK(BM_FrameEncode);
+BENCHMARK(BM_FrameDecode)
+    ->ArgNames({"read", "frames"})
+    ->Args({1, 64})
+    ->Args({7, 64})
+    ->Args({64, 64})
+    ->Args({1460, 64})
+    ->Args({0, 1})
+    ->Args({0, 64})
+    ->Args({0, 1024});
+BENCHMARK(BM_FrameDecodeInPlace)
+    ->ArgNames({"read", "frames"})
+    ->Args({1, 64})
+    ->Args({7, 64})
+    ->Args({64, 64})
+    ->Args({1460, 64})
+    ->Args({0, 1})
+    ->Args({0, 64})
+    ->Args({0, 1024});
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * @file netproj.h
+ * @brief C interface of the netproj library: the integration engine and a job-submission client.
+ *
+ * The interface is plain C with opaque handles, so it can be called from C, C++ built with another compiler or
+ * standard library, and any language with a C FFI. Structures passed in and out start with struct_size, which the
+ * caller sets to sizeof the structure it was compiled against; later versions only append fields and honour the
+ * caller's size, so binaries built against an older header keep working.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(NETPROJ_BUILDING_LIBRARY)
+#define NETPROJ_EXPORT __declspec(dllexport)
+#elif defined(NETPROJ_SHARED)
+#define NETPROJ_EXPORT __declspec(dllimport)
+#else
+#define NETPROJ_EXPORT
+#endif
+#else
+#define NETPROJ_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Version of this interface; incremented when functions or structure fields are added. */
+#define NETPROJ_API_VERSION 1
+
+/**
+ * @brief Result of a call. On anything but NETPROJ_OK, netproj_last_error() describes the failure.
+ */
+typedef enum netproj_status {
+    NETPROJ_OK = 0,
+    NETPROJ_ERR_INVALID_ARGUMENT = 1, ///< Bad bounds, step, method or a null pointer.
+    NETPROJ_ERR_CONNECT = 2,          ///< The server could not be reached.
+    NETPROJ_ERR_IO = 3,               ///< The connection failed or was closed.
+    NETPROJ_ERR_TIMEOUT = 4,          ///< No answer within the timeout; the client must be closed.
+    NETPROJ_ERR_PROTOCOL = 5,         ///< The server sent something the library does not understand.
+    NETPROJ_ERR_INTERNAL = 6
+} netproj_status;
+
+/** @brief Integration method; values match the wire protocol and net_submit's job lines. */
+typedef enum netproj_method {
+    NETPROJ_METHOD_MIDPOINT = 1,
+    NETPROJ_METHOD_TRAPEZOIDS = 2,
+    NETPROJ_METHOD_SIMPSON = 3
+} netproj_method;
+
+/** @brief Scheduling class of a submitted job. */
+typedef enum netproj_priority {
+    NETPROJ_PRIORITY_BATCH = 0,
+    NETPROJ_PRIORITY_NORMAL = 1,
+    NETPROJ_PRIORITY_INTERACTIVE = 2
+} netproj_priority;
+
+/** @brief Final status of a submitted job, as reported by the server. */
+typedef enum netproj_job_status {
+    NETPROJ_JOB_OK = 0,
+    NETPROJ_JOB_FAILED = 1,
+    NETPROJ_JOB_CANCELLED = 2,
+    NETPROJ_JOB_REJECTED = 3, ///< Refused by admission control.
+    NETPROJ_JOB_DEFERRED = 4  ///< Queue saturated; submit again after retry_after_ms.
+} netproj_job_status;
+
+/**
+ * @brief Version of the library actually loaded (NETPROJ_API_VERSION it was built with).
+ */
+NETPROJ_EXPORT int netproj_api_version(void);
+
+/**
+ * @brief Static description of a status, e.g. "connection failed".
+ */
+NETPROJ_EXPORT const char *netproj_status_string(netproj_status status);
+
+/**
+ * @brief Description of the last failed call on this thread; valid until the thread's next failing call.
+ */
+NETPROJ_EXPORT const char *netproj_last_error(void);
+
+/**
+ * @brief Integrate 1/ln(x) on [a,b] with step h in the calling thread.
+ *
+ * @param value Receives the integral on success.
+ * @return NETPROJ_ERR_INVALID_ARGUMENT if h <= 0, a bound is not finite or [a,b] contains x = 1.
+ */
+NETPROJ_EXPORT netproj_status netproj_integrate(double a, double b, double h, netproj_method method, double *value);
+
+/**
+ * @brief Number of steps of length h on [a,b], the unit of work the server schedules by (0 if h <= 0).
+ */
+NETPROJ_EXPORT uint64_t netproj_step_count(double a, double b, double h);
+
+/**
+ * @brief Connection to a server running in service mode.
+ *
+ * A client is not thread-safe: use it from the thread that opened it. Open one client per thread to submit in
+ * parallel; the server schedules their jobs together.
+ */
+typedef struct netproj_client netproj_client;
+
+/**
+ * @brief Connect to host:port, waiting at most timeout_ms (<= 0: wait indefinitely).
+ *
+ * @param client Receives the new client on success, NULL otherwise.
+ */
+NETPROJ_EXPORT netproj_status netproj_client_open(const char *host, uint16_t port, int timeout_ms,
+                                                  netproj_client **client);
+
+/**
+ * @brief Disconnect and free the client. Accepts NULL.
+ */
+NETPROJ_EXPORT void netproj_client_close(netproj_client *client);
+
+/**
+ * @brief Job to submit.
+ */
+typedef struct netproj_job {
+    size_t struct_size; ///< sizeof(netproj_job).
+    double a;
+    double b;
+    double h;
+    netproj_method method;
+    netproj_priority priority;
+    const char *tenant; ///< Admission-control tenant (UTF-8); NULL for "default".
+} netproj_job;
+
+/**
+ * @brief Outcome of a submitted job.
+ */
+typedef struct netproj_job_result {
+    size_t struct_size; ///< sizeof(netproj_job_result).
+    uint64_t job_id;
+    netproj_job_status status;
+    double value;
+    int64_t elapsed_ms;     ///< Submission to completion on the server.
+    int64_t retry_after_ms; ///< Hint for NETPROJ_JOB_DEFERRED.
+    double compute_ms;      ///< Worker compute time summed over units.
+    uint32_t units;         ///< Units the job was split into.
+    char error[256];        ///< Server's reason for a failed, rejected or deferred job (UTF-8, truncated).
+} netproj_job_result;
+
+/**
+ * @brief Submit a job and wait for its result, at most timeout_ms (<= 0: wait indefinitely).
+ *
+ * NETPROJ_OK means the server answered; whether the job succeeded is result->status.
+ * After NETPROJ_ERR_IO or NETPROJ_ERR_TIMEOUT the client is unusable and must be closed.
+ */
+NETPROJ_EXPORT netproj_status netproj_client_submit(netproj_client *client, const netproj_job *job,
+                                                    netproj_job_result *result, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
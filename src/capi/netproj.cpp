@@ -0,0 +1,286 @@
+#include "../../include/netproj/netproj.h"
+
+#include "../common/frame_decoder.h"
+#include "../common/integrator.h"
+#include "../common/message_codec.h"
+
+#include <QDeadlineTimer>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Blocking connection behind the opaque handle. Uses the socket's waitFor*() calls, so no event loop or
+ * QCoreApplication is needed in the embedding process.
+ */
+struct netproj_client {
+    QTcpSocket socket;
+    netproj::FrameDecoder decoder;
+    netproj::MessageCodec codec;
+    quint64 nextRequestId = 1;
+    bool broken = false;
+};
+
+/**
+ * @brief Whether field of the caller's structure s lies within the struct_size the caller passed.
+ */
+#define NETPROJ_HAS_FIELD(s, type, field) ((s)->struct_size >= offsetof(type, field) + sizeof((s)->field))
+
+namespace {
+
+/**
+ * @brief Sizes of the structures in API version 1. Callers may pass these or more (a newer header); fields added
+ * after version 1 are only read or written if NETPROJ_HAS_FIELD().
+ */
+constexpr size_t kJobSizeV1 = offsetof(netproj_job, tenant) + sizeof(netproj_job::tenant);
+constexpr size_t kJobResultSizeV1 = offsetof(netproj_job_result, error) + sizeof(netproj_job_result::error);
+
+thread_local std::string t_lastError;
+
+netproj_status fail(netproj_status status, const QString &error) {
+    t_lastError = error.toStdString();
+    return status;
+}
+
+int waitMs(const QDeadlineTimer &deadline) {
+    return deadline.isForever() ? -1 : static_cast<int>(std::max<qint64>(deadline.remainingTime(), 0));
+}
+
+/**
+ * @brief Failure of a blocking socket call: a timeout or a lost connection. Either way the stream may be cut
+ * mid-frame, so the client cannot be used again.
+ */
+netproj_status socketFailure(netproj_client *client, const QDeadlineTimer &deadline) {
+    client->broken = true;
+    if (deadline.hasExpired()) {
+        return fail(NETPROJ_ERR_TIMEOUT, "timed out waiting for the server");
+    }
+    return fail(NETPROJ_ERR_IO, client->socket.errorString());
+}
+
+bool toMethod(netproj_method m, netproj::MethodType *out) {
+    switch (m) {
+    case NETPROJ_METHOD_MIDPOINT:
+        *out = netproj::MethodType::MidpointRectangles;
+        return true;
+    case NETPROJ_METHOD_TRAPEZOIDS:
+        *out = netproj::MethodType::Trapezoids;
+        return true;
+    case NETPROJ_METHOD_SIMPSON:
+        *out = netproj::MethodType::Simpson;
+        return true;
+    }
+    return false;
+}
+
+bool toPriority(netproj_priority p, netproj::JobPriority *out) {
+    switch (p) {
+    case NETPROJ_PRIORITY_BATCH:
+        *out = netproj::JobPriority::Batch;
+        return true;
+    case NETPROJ_PRIORITY_NORMAL:
+        *out = netproj::JobPriority::Normal;
+        return true;
+    case NETPROJ_PRIORITY_INTERACTIVE:
+        *out = netproj::JobPriority::Interactive;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Fill the fields of out that the caller's struct_size covers; fields it does not know stay zero.
+ */
+void fillResult(const netproj::JobResultMsg &r, netproj_job_result *out) {
+    const size_t size = out->struct_size;
+    std::memset(out, 0, size);
+    out->struct_size = size;
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, job_id)) {
+        out->job_id = r.jobId;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, status)) {
+        out->status = static_cast<netproj_job_status>(r.status);
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, value)) {
+        out->value = r.value;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, elapsed_ms)) {
+        out->elapsed_ms = r.elapsedMs;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, retry_after_ms)) {
+        out->retry_after_ms = r.retryAfterMs;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, compute_ms)) {
+        out->compute_ms = r.computeMs;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, units)) {
+        out->units = r.units;
+    }
+    if (NETPROJ_HAS_FIELD(out, netproj_job_result, error)) {
+        const QByteArray error = r.error.toUtf8();
+        std::memcpy(out->error, error.constData(),
+                    std::min<size_t>(static_cast<size_t>(error.size()), sizeof(out->error) - 1));
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int netproj_api_version(void) {
+    return NETPROJ_API_VERSION;
+}
+
+const char *netproj_status_string(netproj_status status) {
+    switch (status) {
+    case NETPROJ_OK:
+        return "ok";
+    case NETPROJ_ERR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case NETPROJ_ERR_CONNECT:
+        return "connection failed";
+    case NETPROJ_ERR_IO:
+        return "connection lost";
+    case NETPROJ_ERR_TIMEOUT:
+        return "timed out";
+    case NETPROJ_ERR_PROTOCOL:
+        return "protocol error";
+    case NETPROJ_ERR_INTERNAL:
+        return "internal error";
+    }
+    return "unknown status";
+}
+
+const char *netproj_last_error(void) {
+    return t_lastError.c_str();
+}
+
+netproj_status netproj_integrate(double a, double b, double h, netproj_method method, double *value) {
+    netproj::MethodType m;
+    if (!value || !toMethod(method, &m)) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, !value ? "value is NULL" : "unknown method");
+    }
+    // No exception may cross the C boundary.
+    try {
+        *value = netproj::Integrator::integrate(a, b, h, m);
+        return NETPROJ_OK;
+    } catch (const std::invalid_argument &e) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, e.what());
+    } catch (const std::exception &e) {
+        return fail(NETPROJ_ERR_INTERNAL, e.what());
+    } catch (...) {
+        return fail(NETPROJ_ERR_INTERNAL, "unknown exception");
+    }
+}
+
+uint64_t netproj_step_count(double a, double b, double h) {
+    return h > 0.0 ? netproj::Integrator::stepCount(a, b, h) : 0;
+}
+
+netproj_status netproj_client_open(const char *host, uint16_t port, int timeout_ms, netproj_client **client) {
+    if (!client) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, "client is NULL");
+    }
+    *client = nullptr;
+    if (!host || port == 0) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, "missing host or port");
+    }
+    try {
+        auto *c = new netproj_client;
+        c->socket.connectToHost(QString::fromUtf8(host), port);
+        if (!c->socket.waitForConnected(timeout_ms > 0 ? timeout_ms : -1)) {
+            const QString error = c->socket.errorString();
+            delete c;
+            return fail(NETPROJ_ERR_CONNECT, error);
+        }
+        c->socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        *client = c;
+        return NETPROJ_OK;
+    } catch (const std::exception &e) {
+        return fail(NETPROJ_ERR_INTERNAL, e.what());
+    }
+}
+
+void netproj_client_close(netproj_client *client) {
+    if (!client) {
+        return;
+    }
+    client->socket.disconnectFromHost();
+    if (client->socket.state() != QAbstractSocket::UnconnectedState) {
+        client->socket.waitForDisconnected(1000);
+    }
+    delete client;
+}
+
+netproj_status netproj_client_submit(netproj_client *client, const netproj_job *job, netproj_job_result *result,
+                                     int timeout_ms) {
+    if (!client || !job || !result) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, "client, job or result is NULL");
+    }
+    if (job->struct_size < kJobSizeV1 || result->struct_size < kJobResultSizeV1) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, "struct_size not set");
+    }
+    if (client->broken) {
+        return fail(NETPROJ_ERR_IO, "client failed earlier and must be closed");
+    }
+
+    netproj::SubmitMsg m;
+    if (!toMethod(job->method, &m.method) || !toPriority(job->priority, &m.priority)) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, "unknown method or priority");
+    }
+    try {
+        netproj::Integrator::validate(job->a, job->b, job->h);
+    } catch (const std::invalid_argument &e) {
+        return fail(NETPROJ_ERR_INVALID_ARGUMENT, e.what());
+    }
+    m.requestId = client->nextRequestId++;
+    m.tenant = job->tenant ? QString::fromUtf8(job->tenant) : QString("default");
+    m.a = job->a;
+    m.b = job->b;
+    m.h = job->h;
+
+    const QDeadlineTimer deadline =
+        (timeout_ms > 0) ? QDeadlineTimer(timeout_ms) : QDeadlineTimer(QDeadlineTimer::Forever);
+    const QByteArray &payload = client->codec.serialize(netproj::MessageType::Submit, m);
+    char header[netproj::FrameDecoder::kHeaderSize];
+    qToBigEndian(static_cast<quint32>(payload.size()), header);
+    client->socket.write(header, netproj::FrameDecoder::kHeaderSize);
+    client->socket.write(payload.constData(), payload.size());
+    while (client->socket.bytesToWrite() > 0) {
+        if (!client->socket.waitForBytesWritten(waitMs(deadline))) {
+            return socketFailure(client, deadline);
+        }
+    }
+
+    QByteArray frame;
+    for (;;) {
+        while (client->decoder.nextView(&frame)) {
+            const netproj::ParsedMessage &pm = client->codec.parse(frame);
+            if (!pm.ok) {
+                client->broken = true;
+                return fail(NETPROJ_ERR_PROTOCOL, pm.parseError);
+            }
+            if (pm.env.type == netproj::MessageType::Error) {
+                return fail(NETPROJ_ERR_PROTOCOL, "server error: " + pm.error.text);
+            }
+            if (pm.env.type == netproj::MessageType::JobResult && pm.jobResult.requestId == m.requestId) {
+                fillResult(pm.jobResult, result);
+                return NETPROJ_OK;
+            }
+        }
+        if (!client->socket.waitForReadyRead(waitMs(deadline))) {
+            return socketFailure(client, deadline);
+        }
+        const qint64 avail = client->socket.bytesAvailable();
+        const qint64 got = client->socket.read(client->decoder.prepareAppend(avail), avail);
+        client->decoder.commitAppend(std::max<qint64>(got, 0));
+    }
+}
+
+} // extern "C"
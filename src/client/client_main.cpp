@@ -1,25 +1,93 @@
+#include "../common/async_log.h"
 #include "../common/framed_socket.h"
+#include "../common/hw_counters.h"
 #include "../common/integrator.h"
+#include "../common/message_codec.h"
 #include "../common/message_io.h"
+#include "../common/process_stats.h"
+#include "../common/tracing.h"
 
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QHostAddress>
+#include <QQueue>
+#include <QSysInfo>
 #include <QTextStream>
+#include <QThreadPool>
 #include <QTcpSocket>
+#include <QTimer>
 #include <QtConcurrent/QtConcurrent>
 
-#include <vector>
+#include <cmath>
 #include <exception>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#ifdef NETPROJ_COUNT_ALLOCATIONS
+#include "../common/alloc_counter.h"
+#endif
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 namespace netproj {
 
-static double integrateChunk(double a, double b, double h, MethodType method) {
-    return Integrator::integrate(a, b, h, method);
+/**
+ * @brief Segments per thread. More segments than threads let a cancellation take effect quickly.
+ */
+static constexpr int kSegmentsPerThread = 4;
+
+/**
+ * @brief When and on which thread a segment was computed (traced units) and its hardware counts (with
+ * --hw-counters).
+ */
+struct SegmentStats {
+    qint64 startUs = 0;
+    qint64 endUs = 0;
+    quint32 thread = 0;
+    bool counted = false;
+    HwCounts hw;
+};
+
+/**
+ * @brief Integrate one segment; failures are reported as NaN so they never escape a pool thread.
+ */
+static double integrateSegment(const Segment &s, double h, MethodType method) {
+    try {
+        return Integrator::integrate(s.a, s.b, h, method);
+    } catch (...) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+#ifdef Q_OS_UNIX
+/**
+ * @brief Socket pair used to forward SIGTERM from the signal handler to the event loop.
+ */
+static int g_termFd[2] = {-1, -1};
+
+static void onTermSignal(int) {
+    const char c = 1;
+    [[maybe_unused]] const ssize_t n = ::write(g_termFd[0], &c, 1);
 }
+#endif
 
 /**
- * @brief Client application that connects to server, computes assigned integral chunk and sends result back.
+ * @brief Client application that connects to server, computes assigned work units and sends results back.
+ *
+ * The client stays connected and serves units until the server closes the connection. On SIGTERM it drains:
+ * it tells the server to stop assigning units, finishes the current unit (or after the drain timeout hands back
+ * the completed part of it) and exits, so workers can be replaced without losing compute.
  */
 class ClientApp : public QObject {
     Q_OBJECT
@@ -31,8 +99,73 @@ public:
         : QObject(parent) {
         connect(&m_socket, &QTcpSocket::connected, this, &ClientApp::onConnected);
         connect(&m_socket, &QTcpSocket::errorOccurred, this, &ClientApp::onError);
+        connect(&m_watcher, &QFutureWatcher<double>::finished, this, &ClientApp::onComputeFinished);
+        connect(&m_watcher, &QFutureWatcher<double>::resultReadyAt, this, &ClientApp::onSegmentReady);
+
+        m_drainTimer.setSingleShot(true);
+        connect(&m_drainTimer, &QTimer::timeout, this, &ClientApp::checkpoint);
+    }
+
+    /**
+     * @brief Compute with this many threads (and report them as cores) instead of all hardware threads.
+     */
+    void setThreads(int threads) {
+        m_threads = std::max(1, threads);
+        QThreadPool::globalInstance()->setMaxThreadCount(m_threads);
+    }
+
+    /**
+     * @brief Set how long a drain waits for the current unit before handing back its completed part.
+     */
+    void setDrainTimeout(int ms) { m_drainTimeoutMs = std::max(0, ms); }
+
+    /**
+     * @brief Count hardware events (cycles, instructions, cache and branch misses) of every segment.
+     *
+     * Stays off with a warning if the PMU cannot be used on this machine.
+     */
+    void setHwCounters(bool enabled) {
+        m_hwCounters = false;
+        if (!enabled) {
+            return;
+        }
+        const QString why = ThreadHwCounters::probe();
+        if (!why.isEmpty()) {
+            qWarning() << "Hardware counters unavailable:" << why;
+            return;
+        }
+        m_hwCounters = true;
+    }
+
+    /**
+     * @brief Drain on SIGTERM (POSIX only).
+     */
+    void installTermHandler() {
+#ifdef Q_OS_UNIX
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, g_termFd) != 0) {
+            qWarning() << "Cannot create signal socket pair, SIGTERM will not drain";
+            return;
+        }
+        auto *notifier = new QSocketNotifier(g_termFd[1], QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this]() {
+            char c = 0;
+            [[maybe_unused]] const ssize_t n = ::read(g_termFd[1], &c, 1);
+            drain();
+        });
+
+        struct sigaction sa = {};
+        sa.sa_handler = onTermSignal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        ::sigaction(SIGTERM, &sa, nullptr);
+#endif
     }
 
+    /**
+     * @brief Set the stable worker identifier reported in HELLO (used by the server for throughput profiles).
+     */
+    void setWorkerId(const QString &id) { m_workerId = id; }
+
     /**
      * @brief Connect to server by host and port.
      */
@@ -58,27 +191,54 @@ private slots:
         connect(m_framed, &FramedSocket::frameReceived, this, &ClientApp::onFrame);
         connect(m_framed, &FramedSocket::disconnected, this, &ClientApp::onDisconnected);
 
-        const quint32 cores = static_cast<quint32>(std::max(1, QThread::idealThreadCount()));
+        const quint32 cores = static_cast<quint32>(m_threads);
         HelloMsg hello;
         hello.cores = cores;
+        hello.workerId = m_workerId;
 
         m_framed->sendFrame(serializeHello(hello));
-        qInfo() << "Sent HELLO, cores=" << cores;
+        qInfo() << "Sent HELLO, cores=" << cores << ", id=" << m_workerId;
     }
 
     /**
-     * @brief Frame handler (TASK, ERROR).
+     * @brief Frame handler (TASK, CANCEL, ERROR).
      */
     void onFrame(const QByteArray &payload) {
-        const auto pm = parseMessage(payload);
+        const qint64 receivedUs = traceClockUs();
+        const ParsedMessage &pm = m_codec.parse(payload);
         if (!pm.ok) {
             qWarning() << "Failed to parse server message:" << pm.parseError;
             return;
         }
 
+        if (pm.env.type == MessageType::Ping) {
+            PongMsg pong;
+            pong.seq = pm.ping.seq;
+            pong.serverUs = pm.ping.serverUs;
+            pong.receivedUs = receivedUs;
+            pong.sentUs = traceClockUs();
+            m_framed->sendFrame(m_codec.serialize(MessageType::Pong, pong));
+            return;
+        }
+
         if (pm.env.type == MessageType::Task) {
-            qInfo() << "TASK received:" << pm.task.a << pm.task.b << "h=" << pm.task.h;
-            computeAndSend(pm.task);
+            qCDebug(lcMessages) << "TASK received: job" << pm.task.jobId << "unit" << pm.task.unitId << ":" << pm.task.a
+                                << pm.task.b << "h=" << pm.task.h;
+            if (m_draining) {
+                // Assigned before the server saw DRAIN.
+                sendCancelled(pm.task);
+                return;
+            }
+            if (pm.task.flags & TaskTrace) {
+                m_receivedUs.insert(pm.task.unitId, receivedUs);
+            }
+            m_queue.enqueue(pm.task);
+            startNext();
+            return;
+        }
+
+        if (pm.env.type == MessageType::Cancel) {
+            cancel(pm.cancel);
             return;
         }
 
@@ -106,59 +266,337 @@ private slots:
         qCritical() << "Socket error:" << m_socket.errorString();
     }
 
-private:
     /**
-     * @brief Compute assigned integral task using multiple CPU cores and send result.
+     * @brief Remember a finished segment so a drain can hand back the completed part of the unit.
      */
-    void computeAndSend(const TaskMsg &task) {
-        try {
-            const int threads = std::max(1, QThread::idealThreadCount());
+    void onSegmentReady(int index) {
+        if (index >= 0 && index < m_segmentValues.size()) {
+            m_segmentValues[index] = m_watcher.future().resultAt(index);
+        }
+    }
 
-            const double len = task.b - task.a;
-            const double part = len / static_cast<double>(threads);
+    /**
+     * @brief Drain timeout: stop the current unit and hand back what has been computed.
+     */
+    void checkpoint() {
+        if (m_current && !m_cancelRequested) {
+            qInfo() << "Drain timeout, checkpointing unit" << m_current->unitId;
+            m_checkpointRequested = true;
+            m_watcher.future().cancel();
+        }
+    }
 
-            std::vector<QFuture<double>> futures;
-            futures.reserve(static_cast<size_t>(threads));
+    /**
+     * @brief All segments of the current unit are done (or the computation was cancelled).
+     */
+    void onComputeFinished() {
+        const qint64 doneUs = traceClockUs();
+        if (!m_current) {
+            return;
+        }
+        const TaskMsg task = *m_current;
+        m_current.reset();
 
-            QElapsedTimer timer;
-            timer.start();
+        if (m_cancelRequested) {
+            qCDebug(lcMessages) << "Unit" << task.unitId << "cancelled after" << m_timer.elapsed() << "ms";
+            sendCancelled(task);
+            startNext();
+            return;
+        }
+        if (m_checkpointRequested) {
+            sendPartial(task);
+            startNext();
+            return;
+        }
 
-            for (int i = 0; i < threads; ++i) {
-                const double a = task.a + static_cast<double>(i) * part;
-                const double b = (i + 1 == threads) ? task.b : (a + part);
-                futures.push_back(QtConcurrent::run(&integrateChunk, a, b, task.h, task.method));
-            }
+        const QFuture<double> f = m_watcher.future();
+        QVector<double> blockSums(static_cast<qsizetype>(m_blockCount), 0.0);
+        bool ok = (f.resultCount() == static_cast<int>(m_segments.size()));
+        for (int i = 0; ok && i < f.resultCount(); ++i) {
+            const double v = f.resultAt(i);
+            ok = std::isfinite(v);
+            blockSums[m_segmentBlock[static_cast<size_t>(i)]] += v;
+        }
+        double sum = 0.0;
+        for (const double v : blockSums) {
+            sum += v;
+        }
 
-            double sum = 0.0;
-            for (auto &f : futures) {
-                f.waitForFinished();
-                sum += f.result();
-            }
+        if (!ok) {
+            qCritical() << "Computation failed for unit" << task.unitId;
+            ErrorMsg err;
+            err.text = "Integration produced a non-finite value";
+            m_framed->sendFrame(serializeError(err));
+            startNext();
+            return;
+        }
 
-            const qint64 ms = timer.elapsed();
-            qInfo() << "Computed local sum=" << sum << ", time=" << ms << "ms";
+        ResultMsg r;
+        r.jobId = task.jobId;
+        r.unitId = task.unitId;
+        r.value = sum;
+        r.computeMs = static_cast<double>(m_timer.nsecsElapsed()) / 1e6;
+        r.telemetry = telemetry(task, m_segments.size());
+        qCDebug(lcMessages) << "Computed local sum=" << sum << ", time=" << r.computeMs << "ms, cpu="
+                            << r.telemetry.cpuMs << "ms, evaluations=" << r.telemetry.evaluations;
+        if (task.verifyBlocks > 0) {
+            r.blockSums = blockSums;
+        }
+        if (task.flags & TaskTrace) {
+            r.trace = traceSpans(task, doneUs);
+        }
+        m_framed->sendFrame(m_codec.serialize(MessageType::Result, r));
+        qCDebug(lcMessages) << "Sent RESULT";
+#ifdef NETPROJ_COUNT_ALLOCATIONS
+        qCDebug(lcMessages) << "Heap allocations so far:" << allocationCount();
+#endif
+
+        startNext();
+    }
+
+private:
+    /**
+     * @brief Start computing the next queued unit using multiple CPU cores (asynchronously).
+     */
+    void startNext() {
+        if (m_current) {
+            return;
+        }
+        if (m_draining) {
+            while (!m_queue.isEmpty()) {
+                sendCancelled(m_queue.dequeue());
+            }
+            qInfo() << "Drained, disconnecting";
+            m_drainTimer.stop();
+            m_socket.disconnectFromHost();
+            return;
+        }
+        if (m_queue.isEmpty()) {
+            return;
+        }
+        const TaskMsg task = m_queue.dequeue();
 
-            ResultMsg r;
-            r.value = sum;
-            m_framed->sendFrame(serializeResult(r));
-            qInfo() << "Sent RESULT";
+        try {
+            Integrator::validate(task.a, task.b, task.h);
         } catch (const std::exception &e) {
             qCritical() << "Computation failed:" << e.what();
             ErrorMsg err;
             err.text = QString::fromUtf8(e.what());
             m_framed->sendFrame(serializeError(err));
-        } catch (...) {
-            qCritical() << "Computation failed: unknown exception";
-            ErrorMsg err;
-            err.text = "unknown exception";
-            m_framed->sendFrame(serializeError(err));
+            startNext();
+            return;
+        }
+
+        // Verification blocks (if requested) are split further so every thread has several segments.
+        const int threads = m_threads;
+        const std::vector<Segment> blocks = (task.verifyBlocks > 0)
+            ? Integrator::partition(task.a, task.b, task.h, static_cast<int>(task.verifyBlocks))
+            : std::vector<Segment>{Segment{task.a, task.b}};
+        const int perBlock = std::max(1, (threads * kSegmentsPerThread + static_cast<int>(blocks.size()) - 1) /
+                                             static_cast<int>(blocks.size()));
+
+        m_segments.clear();
+        m_segmentBlock.clear();
+        m_blockCount = blocks.size();
+        for (size_t bi = 0; bi < blocks.size(); ++bi) {
+            for (const Segment &s : Integrator::partition(blocks[bi].a, blocks[bi].b, task.h, perBlock)) {
+                m_segments.push_back(s);
+                m_segmentBlock.push_back(static_cast<int>(bi));
+            }
+        }
+        m_segmentValues = QVector<double>(static_cast<qsizetype>(m_segments.size()),
+                                          std::numeric_limits<double>::quiet_NaN());
+        m_current = task;
+        m_cancelRequested = false;
+        m_checkpointRequested = false;
+        m_timer.start();
+        m_cpuStartMs = processCpuMs();
+        m_startUs = traceClockUs();
+        const bool traced = (task.flags & TaskTrace) != 0;
+        const bool counted = m_hwCounters;
+        m_segmentStats = (traced || counted) ? std::make_shared<std::vector<SegmentStats>>(m_segments.size()) : nullptr;
+
+        // Segments are mapped by index so each one's timing and counts can be recorded in place.
+        m_segmentIndices.resize(m_segments.size());
+        std::iota(m_segmentIndices.begin(), m_segmentIndices.end(), 0);
+        const double h = task.h;
+        const MethodType method = task.method;
+        m_watcher.setFuture(QtConcurrent::mapped(
+            m_segmentIndices, [segments = m_segments, stats = m_segmentStats, traced, counted, h, method](int i) {
+                const qint64 startUs = traced ? traceClockUs() : 0;
+                ThreadHwCounters *hw = counted ? &ThreadHwCounters::current() : nullptr;
+                const HwCounts before = hw ? hw->read() : HwCounts{};
+                const double v = integrateSegment(segments[static_cast<size_t>(i)], h, method);
+                if (stats) {
+                    SegmentStats &s = (*stats)[static_cast<size_t>(i)];
+                    if (hw && hw->available()) {
+                        s.hw = hw->read() - before;
+                        s.counted = true;
+                    }
+                    if (traced) {
+                        s.startUs = startUs;
+                        s.endUs = traceClockUs();
+                        s.thread = traceThreadId();
+                    }
+                }
+                return v;
+            }));
+    }
+
+    /**
+     * @brief Telemetry of the current unit covering its first segments segments.
+     */
+    TaskTelemetry telemetry(const TaskMsg &task, size_t segments) const {
+        TaskTelemetry t;
+        t.cpuMs = processCpuMs() - m_cpuStartMs;
+        t.threads = static_cast<quint32>(m_threads);
+        for (size_t i = 0; i < segments && i < m_segments.size(); ++i) {
+            t.evaluations += Integrator::evaluationCount(m_segments[i].a, m_segments[i].b, task.h, task.method);
+        }
+        t.kernel = Integrator::kernelName(task.method);
+        t.peakRssKb = peakRssKb();
+        if (m_hwCounters && m_segmentStats) {
+            HwCounts hw;
+            t.hwCounters = segments > 0;
+            for (size_t i = 0; i < segments && i < m_segmentStats->size(); ++i) {
+                const SegmentStats &s = (*m_segmentStats)[i];
+                t.hwCounters = t.hwCounters && s.counted;
+                hw += s.hw;
+            }
+            if (t.hwCounters) {
+                t.cycles = hw.cycles;
+                t.instructions = hw.instructions;
+                t.cacheMisses = hw.cacheMisses;
+                t.branchMisses = hw.branchMisses;
+            }
+        }
+        return t;
+    }
+
+    /**
+     * @brief Spans of a traced unit: receive (arrival to compute start), one per segment and send (compute done
+     * to result serialized).
+     */
+    QVector<TraceSpan> traceSpans(const TaskMsg &task, qint64 doneUs) {
+        QVector<TraceSpan> spans;
+        const qint64 receivedUs = m_receivedUs.take(task.unitId);
+        if (receivedUs > 0) {
+            spans.push_back(TraceSpan{"receive", 0, receivedUs, m_startUs - receivedUs});
+        }
+        for (size_t i = 0; i < m_segmentStats->size(); ++i) {
+            const SegmentStats &t = (*m_segmentStats)[i];
+            spans.push_back(
+                TraceSpan{"segment " + QString::number(static_cast<int>(i)), t.thread, t.startUs, t.endUs - t.startUs});
+        }
+        spans.push_back(TraceSpan{"send", 0, doneUs, traceClockUs() - doneUs});
+        return spans;
+    }
+
+    /**
+     * @brief Abandon a queued or running unit on server request.
+     */
+    void cancel(const CancelMsg &m) {
+        if (m_current && m_current->unitId == m.unitId) {
+            qCDebug(lcMessages) << "CANCEL received for running unit" << m.unitId;
+            m_cancelRequested = true;
+            m_watcher.future().cancel();
+            return;
+        }
+        for (int i = 0; i < m_queue.size(); ++i) {
+            if (m_queue[i].unitId == m.unitId) {
+                qCDebug(lcMessages) << "CANCEL received for queued unit" << m.unitId;
+                sendCancelled(m_queue.takeAt(i));
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Start draining (first SIGTERM); a second one checkpoints the current unit immediately.
+     */
+    void drain() {
+        if (m_draining) {
+            checkpoint();
+            return;
+        }
+        m_draining = true;
+        qInfo() << "Draining: no new units, current unit gets" << m_drainTimeoutMs << "ms";
+        if (!m_framed) {
+            QCoreApplication::quit();
+            return;
+        }
+        DrainMsg m;
+        m.deadlineMs = static_cast<quint32>(m_drainTimeoutMs);
+        m_framed->sendFrame(serializeDrain(m));
+        if (m_current) {
+            m_drainTimer.start(m_drainTimeoutMs);
+        }
+        startNext();
+    }
+
+    /**
+     * @brief Hand back the leading segments of a stopped unit that finished; the server requeues the rest.
+     */
+    void sendPartial(const TaskMsg &task) {
+        int done = 0;
+        double sum = 0.0;
+        while (done < m_segmentValues.size() && std::isfinite(m_segmentValues[done])) {
+            sum += m_segmentValues[done];
+            ++done;
         }
 
-        m_socket.disconnectFromHost();
+        ResultMsg r;
+        r.jobId = task.jobId;
+        r.unitId = task.unitId;
+        r.flags = ResultPartial;
+        r.value = sum;
+        r.computeMs = static_cast<double>(m_timer.nsecsElapsed()) / 1e6;
+        r.doneSteps = (done > 0) ? Integrator::stepCount(task.a, m_segments[static_cast<size_t>(done - 1)].b, task.h) : 0;
+        r.telemetry = telemetry(task, static_cast<size_t>(done));
+        m_framed->sendFrame(m_codec.serialize(MessageType::Result, r));
+        qInfo() << "Sent partial RESULT for unit" << task.unitId << ":" << done << "of" << m_segmentValues.size()
+                << "segments," << r.doneSteps << "steps";
+    }
+
+    /**
+     * @brief Acknowledge cancellation of a unit.
+     */
+    void sendCancelled(const TaskMsg &task) {
+        m_receivedUs.remove(task.unitId);
+        ResultMsg r;
+        r.jobId = task.jobId;
+        r.unitId = task.unitId;
+        r.flags = ResultCancelled;
+        m_framed->sendFrame(m_codec.serialize(MessageType::Result, r));
     }
 
     QTcpSocket m_socket;
     FramedSocket *m_framed = nullptr;
+    MessageCodec m_codec; ///< Parses TASK and serializes RESULT without per-message allocations.
+    QString m_workerId;
+    int m_threads = std::max(1, QThread::idealThreadCount());
+
+    QQueue<TaskMsg> m_queue;
+    std::optional<TaskMsg> m_current;
+    std::vector<Segment> m_segments;
+    std::vector<int> m_segmentBlock;
+    std::vector<int> m_segmentIndices;
+    size_t m_blockCount = 1;
+    QFutureWatcher<double> m_watcher;
+    QVector<double> m_segmentValues;
+    QElapsedTimer m_timer;
+    double m_cpuStartMs = 0.0;
+    bool m_cancelRequested = false;
+    bool m_checkpointRequested = false;
+
+    QHash<quint64, qint64> m_receivedUs; ///< Arrival of traced units on the trace clock.
+    qint64 m_startUs = 0;
+    std::shared_ptr<std::vector<SegmentStats>> m_segmentStats;
+    bool m_hwCounters = false;
+
+    bool m_draining = false;
+    int m_drainTimeoutMs = 30000;
+    QTimer m_drainTimer;
 };
 
 } // namespace netproj
@@ -173,6 +611,16 @@ int main(int argc, char *argv[]) {
 
     const QStringList args = QCoreApplication::arguments();
     const bool pause = args.contains("--pause");
+    const bool hwCounters = args.contains("--hw-counters");
+
+    netproj::LogLevel logLevel = netproj::LogLevel::Info;
+    const int logIdx = args.indexOf("--log-level");
+    if (logIdx >= 0 && (logIdx + 1 >= args.size() || !netproj::parseLogLevel(args[logIdx + 1], &logLevel))) {
+        qCritical() << "Invalid --log-level (expected debug, info, warning or error)";
+        return 1;
+    }
+    const netproj::AsyncLog log(logLevel, args.contains("--log-json") ? netproj::LogFormat::Json
+                                                                      : netproj::LogFormat::Text);
 
     QString host;
     quint16 port = 0;
@@ -190,6 +638,12 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    QString workerId = QSysInfo::machineHostName();
+    const int idIdx = args.indexOf("--id");
+    if (idIdx >= 0 && idIdx + 1 < args.size()) {
+        workerId = args[idIdx + 1];
+    }
+
     if (host.trimmed().isEmpty()) {
         out << "Enter server host: " << Qt::flush;
         host = in.readLine().trimmed();
@@ -205,7 +659,36 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    int drainTimeoutMs = 30000;
+    const int drainIdx = args.indexOf("--drain-timeout");
+    if (drainIdx >= 0 && drainIdx + 1 < args.size()) {
+        bool ok = false;
+        drainTimeoutMs = args[drainIdx + 1].toInt(&ok);
+        if (!ok || drainTimeoutMs < 0) {
+            qCritical() << "Invalid --drain-timeout";
+            return 1;
+        }
+    }
+
+    int threads = 0;
+    const int threadsIdx = args.indexOf("--threads");
+    if (threadsIdx >= 0 && threadsIdx + 1 < args.size()) {
+        bool ok = false;
+        threads = args[threadsIdx + 1].toInt(&ok);
+        if (!ok || threads <= 0) {
+            qCritical() << "Invalid --threads";
+            return 1;
+        }
+    }
+
     netproj::ClientApp client;
+    client.setWorkerId(workerId);
+    if (threads > 0) {
+        client.setThreads(threads);
+    }
+    client.setDrainTimeout(drainTimeoutMs);
+    client.setHwCounters(hwCounters);
+    client.installTermHandler();
     client.connectTo(host, port);
 
     const int rc = app.exec();
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace netproj {
+
+/**
+ * @brief Heap allocations (malloc, calloc, realloc and operator new) made by the process so far.
+ *
+ * Counting interposes the C allocator, which also sees Qt's container allocations; it is only available with
+ * glibc. Elsewhere the count stays 0.
+ */
+std::size_t allocationCount();
+
+/**
+ * @brief Whether allocationCount() actually counts on this platform.
+ */
+bool allocationCountingSupported();
+
+} // namespace netproj
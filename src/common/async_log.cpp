@@ -0,0 +1,271 @@
+#include "async_log.h"
+
+#include "spsc_ring.h"
+#include "tracing.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace netproj {
+
+Q_LOGGING_CATEGORY(lcMessages, "netproj.messages", QtInfoMsg)
+
+/**
+ * @brief Records each logging thread can buffer before messages are dropped.
+ */
+static constexpr size_t kRingCapacity = 4096;
+
+/**
+ * @brief Longest time a record waits in a ring before the writer picks it up.
+ */
+static constexpr int kFlushIntervalMs = 20;
+
+namespace {
+
+struct LogRecord {
+    quint64 seq = 0;
+    qint64 timeMs = 0;
+    quint32 thread = 0;
+    QtMsgType type = QtDebugMsg;
+    const char *category = nullptr; ///< Category names are string literals with static lifetime.
+    QString message;
+};
+
+using LogRing = SpscRing<LogRecord>;
+
+/**
+ * @brief Process-wide logger state. Rings outlive both their threads and the AsyncLog instance; the writer frees
+ * the ring of an exited thread once it is drained.
+ */
+struct LogState {
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stop = false;
+
+    std::atomic<quint64> seq{0};
+    std::atomic<quint64> dropped{0};
+    std::atomic<bool> active{false};
+    LogLevel level = LogLevel::Info;
+    LogFormat format = LogFormat::Text;
+    FILE *out = stderr;
+    QtMessageHandler previous = nullptr;
+    std::thread writer;
+};
+
+LogState &state() {
+    static LogState s;
+    return s;
+}
+
+LogRing &threadRing() {
+    thread_local const std::shared_ptr<LogRing> ring = [] {
+        auto r = std::make_shared<LogRing>(kRingCapacity);
+        LogState &s = state();
+        const std::lock_guard<std::mutex> lock(s.ringsMutex);
+        s.rings.push_back(r);
+        return r;
+    }();
+    return *ring;
+}
+
+int severity(QtMsgType type) {
+    switch (type) {
+    case QtDebugMsg:
+        return 0;
+    case QtInfoMsg:
+        return 1;
+    case QtWarningMsg:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+const char *levelName(QtMsgType type) {
+    switch (type) {
+    case QtDebugMsg:
+        return "debug";
+    case QtInfoMsg:
+        return "info";
+    case QtWarningMsg:
+        return "warning";
+    case QtCriticalMsg:
+        return "error";
+    default:
+        return "fatal";
+    }
+}
+
+QByteArray formatRecord(const LogRecord &r, LogFormat format) {
+    const QString ts = QDateTime::fromMSecsSinceEpoch(r.timeMs).toUTC().toString(Qt::ISODateWithMs);
+    const bool named = r.category && qstrcmp(r.category, "default") != 0;
+    if (format == LogFormat::Json) {
+        QJsonObject o{{"ts", ts},
+                      {"level", levelName(r.type)},
+                      {"thread", static_cast<qint64>(r.thread)},
+                      {"msg", r.message}};
+        if (named) {
+            o.insert("category", QString::fromLatin1(r.category));
+        }
+        return QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n';
+    }
+    QByteArray line = ts.toUtf8() + ' ' + QByteArray(levelName(r.type)).toUpper().leftJustified(7) + " [" +
+                      QByteArray::number(r.thread) + "] ";
+    if (named) {
+        line += QByteArray(r.category) + ": ";
+    }
+    return line + r.message.toUtf8() + '\n';
+}
+
+/**
+ * @brief Move every buffered record out of the rings (oldest first) and write them.
+ */
+void drainRings(LogState &s, std::vector<LogRecord> &batch) {
+    batch.clear();
+    {
+        const std::lock_guard<std::mutex> lock(s.ringsMutex);
+        for (auto it = s.rings.begin(); it != s.rings.end();) {
+            LogRecord r;
+            while ((*it)->pop(&r)) {
+                batch.push_back(std::move(r));
+            }
+            // Only the registry still refers to the ring of an exited thread.
+            it = (it->use_count() == 1 && (*it)->empty()) ? s.rings.erase(it) : it + 1;
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+    std::sort(batch.begin(), batch.end(), [](const LogRecord &a, const LogRecord &b) {
+        return a.seq < b.seq;
+    });
+    QByteArray text;
+    for (const LogRecord &r : batch) {
+        text += formatRecord(r, s.format);
+    }
+    std::fwrite(text.constData(), 1, static_cast<size_t>(text.size()), s.out);
+    std::fflush(s.out);
+}
+
+void writerLoop() {
+    LogState &s = state();
+    std::vector<LogRecord> batch;
+    quint64 reportedDrops = 0;
+    for (;;) {
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(s.wakeMutex);
+            s.wake.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs), [&s] {
+                return s.stop;
+            });
+            stopping = s.stop;
+        }
+        drainRings(s, batch);
+        const quint64 drops = s.dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            const LogRecord r{0, QDateTime::currentMSecsSinceEpoch(), traceThreadId(), QtWarningMsg, "netproj.log",
+                              QString::number(drops - reportedDrops) + " messages dropped (ring full)"};
+            const QByteArray line = formatRecord(r, s.format);
+            std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), s.out);
+            std::fflush(s.out);
+            reportedDrops = drops;
+        }
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void handleMessage(QtMsgType type, const QMessageLogContext &context, const QString &message) {
+    LogState &s = state();
+    if (type == QtFatalMsg) {
+        // The process aborts right after the handler returns, so this one is written synchronously.
+        LogRecord r{0, QDateTime::currentMSecsSinceEpoch(), traceThreadId(), type, context.category, message};
+        const QByteArray line = formatRecord(r, s.format);
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), s.out);
+        std::fflush(s.out);
+        return;
+    }
+    if (severity(type) < static_cast<int>(s.level)) {
+        return;
+    }
+    LogRecord r{s.seq.fetch_add(1, std::memory_order_relaxed), QDateTime::currentMSecsSinceEpoch(), traceThreadId(),
+                type,  context.category, message};
+    if (!threadRing().push(std::move(r))) {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        s.wake.notify_one();
+    }
+}
+
+} // namespace
+
+bool parseLogLevel(const QString &name, LogLevel *level) {
+    static const char *const names[] = {"debug", "info", "warning", "error"};
+    for (int i = 0; i < 4; ++i) {
+        if (name == QLatin1String(names[i])) {
+            *level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+AsyncLog::AsyncLog(LogLevel level, LogFormat format, FILE *out) {
+    LogState &s = state();
+    Q_ASSERT(!s.active.load());
+    s.level = level;
+    s.format = format;
+    s.out = out;
+    s.stop = false;
+    s.writer = std::thread(writerLoop);
+    s.active.store(true);
+
+    QString rules;
+    if (level == LogLevel::Debug) {
+        rules = QStringLiteral("netproj.*.debug=true");
+    } else if (level >= LogLevel::Warning) {
+        rules = QStringLiteral("*.debug=false\n*.info=false");
+        if (level == LogLevel::Error) {
+            rules += QStringLiteral("\n*.warning=false");
+        }
+    }
+    if (!rules.isEmpty()) {
+        QLoggingCategory::setFilterRules(rules);
+    }
+    s.previous = qInstallMessageHandler(handleMessage);
+}
+
+AsyncLog::~AsyncLog() {
+    LogState &s = state();
+    qInstallMessageHandler(s.previous);
+    {
+        const std::lock_guard<std::mutex> lock(s.wakeMutex);
+        s.stop = true;
+    }
+    s.wake.notify_one();
+    s.writer.join();
+    s.active.store(false);
+}
+
+quint64 AsyncLog::dropped() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace netproj
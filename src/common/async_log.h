@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QLoggingCategory>
+#include <QString>
+
+#include <cstdio>
+
+namespace netproj {
+
+/**
+ * @brief Per-message protocol traffic (TASK, RESULT, CANCEL, per-unit telemetry); off unless --log-level debug.
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcMessages)
+
+/**
+ * @brief Minimum severity written to the log.
+ */
+enum class LogLevel { Debug, Info, Warning, Error };
+
+/**
+ * @brief Log line format.
+ */
+enum class LogFormat {
+    Text, ///< "time LEVEL [thread] category: message"
+    Json  ///< One JSON object per line with ts, level, thread, category and msg.
+};
+
+/**
+ * @brief Parse "debug", "info", "warning" or "error".
+ */
+bool parseLogLevel(const QString &name, LogLevel *level);
+
+/**
+ * @brief Asynchronous sink for all Qt log messages of the process while an instance exists.
+ *
+ * Installs a Qt message handler that only stamps each message (wall time, sequence number, thread) and moves it
+ * into a lock-free ring of the calling thread; a background thread merges the rings in sequence order, formats the
+ * records and writes them out. Logging threads never block on I/O or a lock. When a thread's ring is full its
+ * messages are dropped and the writer reports how many. Levels below the minimum are filtered by
+ * QLoggingCategory rules, so disabled qCDebug() statements do not even format their arguments.
+ */
+class AsyncLog {
+public:
+    /**
+     * @brief Start the writer and install the message handler.
+     * @param out Destination stream, stderr by default.
+     */
+    explicit AsyncLog(LogLevel level, LogFormat format = LogFormat::Text, FILE *out = stderr);
+
+    /**
+     * @brief Write out everything logged so far and restore the previous message handler.
+     */
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog &) = delete;
+    AsyncLog &operator=(const AsyncLog &) = delete;
+
+    /**
+     * @brief Messages dropped because a thread's ring was full.
+     */
+    static quint64 dropped();
+};
+
+} // namespace netproj
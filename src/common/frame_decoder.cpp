@@ -0,0 +1,87 @@
+#include "frame_decoder.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+namespace netproj {
+
+QByteArray FrameDecoder::encode(const QByteArray &payload) {
+    QByteArray frame(kHeaderSize + payload.size(), Qt::Uninitialized);
+    qToBigEndian(static_cast<quint32>(payload.size()), frame.data());
+    if (!payload.isEmpty()) {
+        std::memcpy(frame.data() + kHeaderSize, payload.constData(), static_cast<size_t>(payload.size()));
+    }
+    return frame;
+}
+
+void FrameDecoder::append(const QByteArray &data) {
+    if (m_offset == m_buffer.size()) {
+        // Everything consumed: reuse the incoming buffer instead of copying it.
+        m_buffer = data;
+        m_offset = 0;
+        return;
+    }
+    if (m_offset > 0) {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(data);
+}
+
+char *FrameDecoder::prepareAppend(qsizetype maxSize) {
+    const qsizetype rest = m_buffer.size() - m_offset;
+    if (m_offset > 0) {
+        // Move the unfinished frame to the front in place; QByteArray::remove() may give up capacity.
+        if (rest > 0) {
+            std::memmove(m_buffer.data(), m_buffer.constData() + m_offset, static_cast<size_t>(rest));
+        }
+        m_offset = 0;
+    }
+    m_buffer.resize(rest + maxSize);
+    m_reserved = maxSize;
+    return m_buffer.data() + rest;
+}
+
+void FrameDecoder::commitAppend(qsizetype size) {
+    // prepareAppend() left the buffer maxSize bytes longer than its content.
+    m_buffer.resize(m_buffer.size() - m_reserved + size);
+    m_reserved = 0;
+}
+
+bool FrameDecoder::next(QByteArray *payload) {
+    qsizetype offset = 0;
+    qsizetype size = 0;
+    if (!take(&offset, &size)) {
+        return false;
+    }
+    *payload = m_buffer.mid(offset, size);
+    return true;
+}
+
+bool FrameDecoder::nextView(QByteArray *payload) {
+    qsizetype offset = 0;
+    qsizetype size = 0;
+    if (!take(&offset, &size)) {
+        return false;
+    }
+    *payload = QByteArray::fromRawData(m_buffer.constData() + offset, size);
+    return true;
+}
+
+bool FrameDecoder::take(qsizetype *offset, qsizetype *size) {
+    const qsizetype avail = m_buffer.size() - m_offset;
+    if (avail < kHeaderSize) {
+        return false;
+    }
+    const qsizetype length = qFromBigEndian<quint32>(m_buffer.constData() + m_offset);
+    if (avail < kHeaderSize + length) {
+        return false;
+    }
+    *offset = m_offset + kHeaderSize;
+    *size = length;
+    m_offset += kHeaderSize + length;
+    return true;
+}
+
+} // namespace netproj
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief Length-prefixed framing without any I/O.
+ *
+ * Each frame is encoded as:
+ * - 4 bytes (quint32, big-endian as written by QDataStream) payload size
+ * - payload bytes
+ *
+ * Bytes may be appended in arbitrary chunks; complete payloads are taken out in order.
+ */
+class FrameDecoder {
+public:
+    /**
+     * @brief Size of the frame header in bytes.
+     */
+    static constexpr qsizetype kHeaderSize = 4;
+
+    /**
+     * @brief Encode one payload as a frame.
+     */
+    static QByteArray encode(const QByteArray &payload);
+
+    /**
+     * @brief Append received bytes.
+     */
+    void append(const QByteArray &data);
+
+    /**
+     * @brief Make room for up to maxSize more bytes and return where to write them; then call commitAppend().
+     *
+     * Unlike append(), the bytes are read straight into the decoder's buffer, which keeps its capacity, so reading
+     * a stream does not allocate once the buffer has grown to the largest read.
+     */
+    char *prepareAppend(qsizetype maxSize);
+
+    /**
+     * @brief Keep size bytes of those written after prepareAppend().
+     */
+    void commitAppend(qsizetype size);
+
+    /**
+     * @brief Take the next complete payload.
+     * @return false if no complete frame is buffered.
+     */
+    bool next(QByteArray *payload);
+
+    /**
+     * @brief Like next(), but payload refers to the decoder's buffer instead of a copy.
+     *
+     * The payload is only valid until the next append; copy it to keep it longer.
+     */
+    bool nextView(QByteArray *payload);
+
+    /**
+     * @brief Number of buffered bytes not yet returned.
+     */
+    qsizetype buffered() const { return m_buffer.size() - m_offset; }
+
+private:
+    /**
+     * @brief Consume the next complete frame and return where its payload lies in m_buffer.
+     */
+    bool take(qsizetype *offset, qsizetype *size);
+
+    QByteArray m_buffer;
+    qsizetype m_offset = 0; ///< Consumed prefix of m_buffer, dropped lazily so coalesced frames are not shifted one by one.
+    qsizetype m_reserved = 0; ///< Bytes made room for by prepareAppend() and not yet committed.
+};
+
+} // namespace netproj
@@ -1,6 +1,9 @@
 #include "framed_socket.h"
 
-#include <QDataStream>
+#include <QPointer>
+#include <QtEndian>
+
+#include <algorithm>
 
 namespace netproj {
 
@@ -13,21 +16,48 @@ FramedSocket::FramedSocket(QTcpSocket *socket, QObject *parent)
 }
 
 void FramedSocket::sendFrame(const QByteArray &payload) {
-    QByteArray frame;
-    frame.reserve(static_cast<int>(sizeof(quint32) + payload.size()));
-
-    QDataStream out(&frame, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-    out << static_cast<quint32>(payload.size());
-    frame.append(payload);
-
-    m_socket->write(frame);
+    if (m_tap) {
+        m_tap(true, payload);
+    }
+    // Header and payload are copied into the socket's write buffer, which keeps its chunk between writes, instead of
+    // being assembled in a new frame. The const char * overload of write() never shares payload's data.
+    char header[FrameDecoder::kHeaderSize];
+    qToBigEndian(static_cast<quint32>(payload.size()), header);
+    m_socket->write(header, FrameDecoder::kHeaderSize);
+    m_socket->write(payload.constData(), payload.size());
     m_socket->flush();
+    if (m_counters) {
+        m_counters->framesOut += 1;
+        m_counters->bytesOut += static_cast<quint64>(FrameDecoder::kHeaderSize + payload.size());
+    }
 }
 
 void FramedSocket::onReadyRead() {
-    m_buffer.append(m_socket->readAll());
-    while (tryConsumeOneFrame()) {
+    // Read straight into the decoder and hand out payloads that point into its buffer, so a steady stream of frames
+    // does not allocate once the buffer has grown to the largest read.
+    qint64 bytes = 0;
+    for (qint64 avail = m_socket->bytesAvailable(); avail > 0; avail = m_socket->bytesAvailable()) {
+        const qint64 got = m_socket->read(m_decoder.prepareAppend(avail), avail);
+        m_decoder.commitAppend(std::max<qint64>(got, 0));
+        if (got <= 0) {
+            break;
+        }
+        bytes += got;
+    }
+    if (m_counters) {
+        m_counters->bytesIn += static_cast<quint64>(bytes);
+    }
+    // A receiver may destroy this socket (e.g. its owner) in reaction to a frame; stop before touching the decoder.
+    const QPointer<FramedSocket> self(this);
+    QByteArray payload;
+    while (self && m_decoder.nextView(&payload)) {
+        if (m_counters) {
+            m_counters->framesIn += 1;
+        }
+        if (m_tap) {
+            m_tap(false, payload);
+        }
+        emit frameReceived(payload);
     }
 }
 
@@ -35,29 +65,4 @@ void FramedSocket::onDisconnected() {
     emit disconnected();
 }
 
-bool FramedSocket::tryConsumeOneFrame() {
-    if (m_expectedSize == 0) {
-        if (m_buffer.size() < static_cast<int>(sizeof(quint32))) {
-            return false;
-        }
-
-        QDataStream in(m_buffer);
-        in.setVersion(QDataStream::Qt_6_5);
-        in >> m_expectedSize;
-
-        m_buffer.remove(0, static_cast<int>(sizeof(quint32)));
-    }
-
-    if (m_buffer.size() < static_cast<int>(m_expectedSize)) {
-        return false;
-    }
-
-    QByteArray payload = m_buffer.left(static_cast<int>(m_expectedSize));
-    m_buffer.remove(0, static_cast<int>(m_expectedSize));
-    m_expectedSize = 0;
-
-    emit frameReceived(payload);
-    return true;
-}
-
 } // namespace netproj
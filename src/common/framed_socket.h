@@ -1,16 +1,31 @@
 #pragma once
 
+#include "frame_decoder.h"
+
 #include <QObject>
 #include <QTcpSocket>
 
+#include <functional>
+
 namespace netproj {
 
 /**
- * @brief Small helper around QTcpSocket that implements length-prefixed framing.
- *
- * Each frame is encoded as:
- * - 4 bytes (quint32, QDataStream) payload size
- * - payload bytes
+ * @brief Traffic totals shared by several framed sockets.
+ */
+struct FrameCounters {
+    quint64 framesIn = 0;
+    quint64 framesOut = 0;
+    quint64 bytesIn = 0;
+    quint64 bytesOut = 0;
+};
+
+/**
+ * @brief Observer of every payload passing through a framed socket; outbound is true for sent frames.
+ */
+using FrameTap = std::function<void(bool outbound, const QByteArray &payload)>;
+
+/**
+ * @brief Small helper around QTcpSocket that implements length-prefixed framing (see FrameDecoder).
  */
 class FramedSocket : public QObject {
     Q_OBJECT
@@ -27,6 +42,16 @@ public:
      */
     QTcpSocket *socket() const { return m_socket; }
 
+    /**
+     * @brief Also count traffic into counters (nullptr stops counting); counters must outlive the socket.
+     */
+    void setCounters(FrameCounters *counters) { m_counters = counters; }
+
+    /**
+     * @brief Show every payload sent and received to tap (an empty function removes it).
+     */
+    void setFrameTap(FrameTap tap) { m_tap = std::move(tap); }
+
     /**
      * @brief Send one framed payload.
      */
@@ -35,6 +60,9 @@ public:
 signals:
     /**
      * @brief Emitted when a full payload frame has been received.
+     *
+     * payload points into the socket's receive buffer and is only valid during the emission: parse it in the slot
+     * or copy it with QByteArray(payload.constData(), payload.size()).
      */
     void frameReceived(const QByteArray &payload);
 
@@ -49,10 +77,9 @@ private slots:
 
 private:
     QTcpSocket *m_socket = nullptr;
-    QByteArray m_buffer;
-    quint32 m_expectedSize = 0;
-
-    bool tryConsumeOneFrame();
+    FrameDecoder m_decoder;
+    FrameCounters *m_counters = nullptr;
+    FrameTap m_tap;
 };
 
 } // namespace netproj
@@ -0,0 +1,102 @@
+#include "hw_counters.h"
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace netproj {
+
+#ifdef Q_OS_LINUX
+static int openEvent(quint64 config, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (groupFd < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+ThreadHwCounters::ThreadHwCounters() {
+    for (int &fd : m_fds) {
+        fd = -1;
+    }
+#ifdef Q_OS_LINUX
+    static const quint64 configs[kEvents] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                             PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    m_fds[0] = openEvent(configs[0], -1);
+    if (m_fds[0] < 0) {
+        m_error = errno;
+        return;
+    }
+    // Members of the leader's group; an event the CPU lacks just stays closed and reads as zero.
+    for (int i = 1; i < kEvents; ++i) {
+        m_fds[i] = openEvent(configs[i], m_fds[0]);
+    }
+    ::ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+ThreadHwCounters::~ThreadHwCounters() {
+#ifdef Q_OS_LINUX
+    for (const int fd : m_fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+ThreadHwCounters &ThreadHwCounters::current() {
+    thread_local ThreadHwCounters counters;
+    return counters;
+}
+
+QString ThreadHwCounters::probe() {
+#ifdef Q_OS_LINUX
+    const ThreadHwCounters &c = current();
+    if (c.available()) {
+        return QString();
+    }
+    QString why = QString::fromLocal8Bit(std::strerror(c.m_error));
+    if (c.m_error == EACCES || c.m_error == EPERM) {
+        why += " (check /proc/sys/kernel/perf_event_paranoid)";
+    } else if (c.m_error == ENOENT || c.m_error == EOPNOTSUPP) {
+        why += " (no hardware PMU, e.g. in a virtual machine)";
+    }
+    return why;
+#else
+    return QStringLiteral("perf_event_open is only available on Linux");
+#endif
+}
+
+HwCounts ThreadHwCounters::read() const {
+    HwCounts out;
+#ifdef Q_OS_LINUX
+    quint64 *fields[kEvents] = {&out.cycles, &out.instructions, &out.cacheMisses, &out.branchMisses};
+    for (int i = 0; i < kEvents; ++i) {
+        quint64 v[3] = {0, 0, 0}; // value, time enabled, time running
+        if (m_fds[i] < 0 || ::read(m_fds[i], v, sizeof(v)) != static_cast<ssize_t>(sizeof(v))) {
+            continue;
+        }
+        // Scale up when the PMU was shared with other events for part of the time.
+        *fields[i] = (v[2] > 0 && v[2] < v[1])
+            ? static_cast<quint64>(static_cast<double>(v[0]) * static_cast<double>(v[1]) / static_cast<double>(v[2]))
+            : v[0];
+    }
+#endif
+    return out;
+}
+
+} // namespace netproj
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief Hardware event counts of a code region.
+ */
+struct HwCounts {
+    quint64 cycles = 0;
+    quint64 instructions = 0;
+    quint64 cacheMisses = 0;
+    quint64 branchMisses = 0;
+
+    /**
+     * @brief Instructions per cycle (0 without cycles).
+     */
+    double ipc() const { return (cycles > 0) ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0; }
+
+    /**
+     * @brief Events per 1000 instructions (e.g. cache MPKI).
+     */
+    double perKiloInstruction(quint64 events) const {
+        return (instructions > 0) ? 1e3 * static_cast<double>(events) / static_cast<double>(instructions) : 0.0;
+    }
+
+    HwCounts &operator+=(const HwCounts &o) {
+        cycles += o.cycles;
+        instructions += o.instructions;
+        cacheMisses += o.cacheMisses;
+        branchMisses += o.branchMisses;
+        return *this;
+    }
+
+    HwCounts operator-(const HwCounts &o) const {
+        return HwCounts{cycles - o.cycles, instructions - o.instructions, cacheMisses - o.cacheMisses,
+                        branchMisses - o.branchMisses};
+    }
+};
+
+/**
+ * @brief Hardware performance counters (perf_event_open) of the calling thread, opened on first use.
+ *
+ * Each thread has its own counter group covering cycles, instructions, last-level cache misses and branch
+ * mispredictions in user space. Counts are scaled when the kernel multiplexes the PMU. Where the PMU cannot be
+ * used (not Linux, perf_event_paranoid too strict, virtual machines without a PMU) available() is false and
+ * read() returns zeros.
+ */
+class ThreadHwCounters {
+public:
+    /**
+     * @brief Counters of the calling thread.
+     */
+    static ThreadHwCounters &current();
+
+    /**
+     * @brief Try to open counters on the calling thread.
+     * @return Empty string if counters work, otherwise why not.
+     */
+    static QString probe();
+
+    ThreadHwCounters(const ThreadHwCounters &) = delete;
+    ThreadHwCounters &operator=(const ThreadHwCounters &) = delete;
+    ~ThreadHwCounters();
+
+    /**
+     * @brief Whether the counters are open.
+     */
+    bool available() const { return m_fds[0] >= 0; }
+
+    /**
+     * @brief Counts since the counters were opened.
+     */
+    HwCounts read() const;
+
+private:
+    ThreadHwCounters();
+
+    static constexpr int kEvents = 4;
+    int m_fds[kEvents];
+    int m_error = 0;
+};
+
+} // namespace netproj
@@ -1,8 +1,11 @@
 #include "integrator.h"
 
+#include <QSysInfo>
 #include <QtGlobal>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 
 namespace netproj {
@@ -17,16 +20,26 @@ bool Integrator::intervalContainsSingularity(double a, double b) {
     return lo <= 1.0 && 1.0 <= hi;
 }
 
-double Integrator::integrate(double a, double b, double h, MethodType method) {
+void Integrator::validate(double a, double b, double h) {
     if (!(h > 0.0)) {
         throw std::invalid_argument("Step h must be > 0");
     }
-    if (a == b) {
-        return 0.0;
+    if (!std::isfinite(a) || !std::isfinite(b) || !std::isfinite(h)) {
+        throw std::invalid_argument("Integration parameters must be finite");
     }
-    if (intervalContainsSingularity(a, b)) {
+    if (!(std::abs(b - a) / h <= static_cast<double>(kMaxSteps))) {
+        throw std::invalid_argument("Too many integration steps");
+    }
+    if (a != b && intervalContainsSingularity(a, b)) {
         throw std::invalid_argument("Integration interval contains x=1 singularity");
     }
+}
+
+double Integrator::integrate(double a, double b, double h, MethodType method) {
+    validate(a, b, h);
+    if (a == b) {
+        return 0.0;
+    }
 
     switch (method) {
     case MethodType::MidpointRectangles:
@@ -42,10 +55,80 @@ double Integrator::integrate(double a, double b, double h, MethodType method) {
 
 /**
  * @brief Compute number of full steps of length h on [a,b] (floor).
+ *
+ * A tiny relative tolerance keeps boundaries produced as a + k*h from losing their last step to rounding.
  */
 static inline quint64 stepsCount(double a, double b, double h) {
-    const double len = std::abs(b - a);
-    return static_cast<quint64>(std::floor(len / h));
+    const double n = std::floor(std::abs(b - a) / h * (1.0 + 1e-12));
+    // Saturate instead of converting an out-of-range double; validate() rejects such jobs anyway.
+    return n < 18446744073709551616.0 ? static_cast<quint64>(n) : std::numeric_limits<quint64>::max();
+}
+
+quint64 Integrator::stepCount(double a, double b, double h) {
+    if (!(h > 0.0)) {
+        return 0;
+    }
+    return stepsCount(a, b, h);
+}
+
+std::vector<Segment> Integrator::partition(double a, double b, double h, int parts) {
+    std::vector<Segment> out;
+    const quint64 n = stepCount(a, b, h);
+    const quint64 pairs = n / 2;
+    const quint64 count = std::max<quint64>(1, std::min<quint64>(static_cast<quint64>(std::max(1, parts)), pairs));
+
+    const double step = (b > a) ? h : -h;
+    out.reserve(static_cast<size_t>(count));
+
+    double cursor = a;
+    for (quint64 i = 0; i < count; ++i) {
+        Segment s;
+        s.a = cursor;
+        if (i + 1 == count) {
+            s.b = b;
+        } else {
+            const quint64 endPair = pairs * (i + 1) / count;
+            s.b = a + static_cast<double>(2 * endPair) * step;
+        }
+        cursor = s.b;
+        out.push_back(s);
+    }
+    return out;
+}
+
+quint64 Integrator::evaluationCount(double a, double b, double h, MethodType method) {
+    if (a == b || !(h > 0.0)) {
+        return 0;
+    }
+    const quint64 n = stepsCount(a, b, h);
+    switch (method) {
+    case MethodType::MidpointRectangles:
+        return n;
+    case MethodType::Trapezoids:
+        return 2 * n;
+    case MethodType::Simpson:
+        // Fewer than two steps fall back to trapezoids; an odd last step is dropped.
+        return (n < 2) ? 2 * n : (n - n % 2) + 1;
+    default:
+        return 0;
+    }
+}
+
+QString Integrator::kernelName(MethodType method) {
+    // Built once: workers stamp it on every RESULT, and a shared copy does not allocate.
+    static const QString arch = "/" + QSysInfo::buildCpuArchitecture();
+    static const QString names[] = {methodName(MethodType::MidpointRectangles) + arch,
+                                    methodName(MethodType::Trapezoids) + arch, methodName(MethodType::Simpson) + arch};
+    switch (method) {
+    case MethodType::MidpointRectangles:
+        return names[0];
+    case MethodType::Trapezoids:
+        return names[1];
+    case MethodType::Simpson:
+        return names[2];
+    default:
+        return methodName(method) + arch;
+    }
 }
 
 double Integrator::integrateMidpoint(double a, double b, double h) {
@@ -4,13 +4,28 @@
 
 #include <QtGlobal>
 
+#include <vector>
+
 namespace netproj {
 
+/**
+ * @brief Sub-interval [a,b] of an integration range.
+ */
+struct Segment {
+    double a = 0.0;
+    double b = 0.0;
+};
+
 /**
  * @brief Numerical integrator for f(x)=1/ln(x).
  */
 class Integrator {
 public:
+    /**
+     * @brief Largest step count of a job, so step counts and grid indices stay exact in a double.
+     */
+    static constexpr quint64 kMaxSteps = quint64(1) << 53;
+
     /**
      * @brief Integrate f(x)=1/ln(x) on [a,b] with step h using selected method.
      *
@@ -23,6 +38,37 @@ public:
      */
     static double integrate(double a, double b, double h, MethodType method);
 
+    /**
+     * @brief Check integration parameters.
+     *
+     * @throws std::invalid_argument If h <= 0, bounds are not finite, the interval has more than kMaxSteps steps
+     * or contains x=1.
+     */
+    static void validate(double a, double b, double h);
+
+    /**
+     * @brief Number of full steps of length h on [a,b], i.e. the amount of work a task represents.
+     */
+    static quint64 stepCount(double a, double b, double h);
+
+    /**
+     * @brief Split [a,b] into at most parts segments whose inner boundaries lie on the step grid a + k*h.
+     *
+     * Inner segments have an even number of steps, so integrating the segments separately and summing gives the
+     * same nodes (and for Simpson the same weights) as integrating [a,b] at once. The last segment ends exactly at b.
+     */
+    static std::vector<Segment> partition(double a, double b, double h, int parts);
+
+    /**
+     * @brief Number of integrand evaluations integrate(a, b, h, method) performs.
+     */
+    static quint64 evaluationCount(double a, double b, double h, MethodType method);
+
+    /**
+     * @brief Name of the kernel integrate() runs for method in this build, e.g. "simpson/x86_64".
+     */
+    static QString kernelName(MethodType method);
+
 private:
     /**
      * @brief Function value f(x)=1/ln(x).
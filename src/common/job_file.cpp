@@ -0,0 +1,214 @@
+#include "job_file.h"
+
+#include "integrator.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStringList>
+
+#include <exception>
+
+namespace netproj {
+
+namespace {
+
+/**
+ * @brief Method of a JSON job, given as a number or a string (see parseMethodName()).
+ */
+bool parseMethodValue(const QJsonValue &v, MethodType *out) {
+    if (v.isDouble()) {
+        return parseMethodName(QString::number(v.toDouble()), out);
+    }
+    return v.isString() && parseMethodName(v.toString(), out);
+}
+
+bool parseJsonJobs(const QByteArray &data, std::vector<SubmitMsg> *jobs, QString *error) {
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isArray()) {
+        *error = "expected a JSON array of jobs: " + parseError.errorString();
+        return false;
+    }
+    const QJsonArray array = doc.array();
+    for (int i = 0; i < array.size(); ++i) {
+        const QJsonObject o = array[i].toObject();
+        const QString where = "job " + QString::number(i + 1) + ": ";
+        SubmitMsg m;
+        m.tenant = "default";
+        if (!o.value("a").isDouble() || !o.value("b").isDouble() || !o.value("h").isDouble()) {
+            *error = where + "\"a\", \"b\" and \"h\" must be numbers";
+            return false;
+        }
+        m.a = o.value("a").toDouble();
+        m.b = o.value("b").toDouble();
+        m.h = o.value("h").toDouble();
+        if (o.contains("method") && !parseMethodValue(o.value("method"), &m.method)) {
+            *error = where + "unknown method";
+            return false;
+        }
+        if (o.contains("tenant")) {
+            m.tenant = o.value("tenant").toString();
+        }
+        if (o.contains("priority") && !parsePriority(o.value("priority").toString(), &m.priority)) {
+            *error = where + "unknown priority (expected batch, normal or interactive)";
+            return false;
+        }
+        jobs->push_back(m);
+    }
+    return true;
+}
+
+} // namespace
+
+QString csvField(const QString &s) {
+    if (!s.contains(',') && !s.contains('"') && !s.contains('\n')) {
+        return s;
+    }
+    QString quoted = s;
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+bool parseJobLine(const QString &line, SubmitMsg *m, QString *error) {
+    const QStringList parts = line.trimmed().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    if (parts.size() < 4) {
+        *error = "expected \"A B h method\"";
+        return false;
+    }
+    bool okA = false;
+    bool okB = false;
+    bool okH = false;
+    m->a = parts[0].toDouble(&okA);
+    m->b = parts[1].toDouble(&okB);
+    m->h = parts[2].toDouble(&okH);
+    if (!okA || !okB || !okH || !(m->h > 0.0)) {
+        *error = "invalid number in \"" + line + "\"";
+        return false;
+    }
+    if (!parseMethodName(parts[3], &m->method)) {
+        *error = "unknown method " + parts[3] + " (expected 1-3 or a name)";
+        return false;
+    }
+    return true;
+}
+
+bool parseJobFile(const QByteArray &data, std::vector<SubmitMsg> *jobs, QString *error) {
+    std::vector<SubmitMsg> parsed;
+    if (data.trimmed().startsWith('[')) {
+        if (!parseJsonJobs(data, &parsed, error)) {
+            return false;
+        }
+    } else {
+        const QStringList lines = QString::fromUtf8(data).split('\n');
+        for (int i = 0; i < lines.size(); ++i) {
+            const QString line = lines[i].trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            SubmitMsg m;
+            m.tenant = "default";
+            QString lineError;
+            if (!parseJobLine(line, &m, &lineError)) {
+                *error = "line " + QString::number(i + 1) + ": " + lineError;
+                return false;
+            }
+            parsed.push_back(m);
+        }
+    }
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        try {
+            Integrator::validate(parsed[i].a, parsed[i].b, parsed[i].h);
+        } catch (const std::exception &e) {
+            *error = "job " + QString::number(i + 1) + ": " + QString::fromUtf8(e.what());
+            return false;
+        }
+    }
+    if (parsed.empty()) {
+        *error = "no jobs";
+        return false;
+    }
+    *jobs = std::move(parsed);
+    return true;
+}
+
+QByteArray jobResultsCsv(const std::vector<JobFileResult> &results) {
+    QString out = "index,a,b,h,method,tenant,priority,job_id,status,value,elapsed_ms,dispatch_ms,compute_ms,"
+                  "network_ms,cpu_ms,units,workers,evaluations,requeued_units,error\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SubmitMsg &j = results[i].job;
+        const JobResultMsg &r = results[i].result;
+        const QStringList row = {QString::number(i + 1),
+                                 QString::number(j.a, 'g', 17),
+                                 QString::number(j.b, 'g', 17),
+                                 QString::number(j.h, 'g', 17),
+                                 methodName(j.method),
+                                 csvField(j.tenant),
+                                 priorityName(j.priority),
+                                 QString::number(r.jobId),
+                                 jobStatusName(r.status),
+                                 QString::number(r.value, 'g', 17),
+                                 QString::number(r.elapsedMs),
+                                 QString::number(r.dispatchMs),
+                                 QString::number(r.computeMs),
+                                 QString::number(r.networkMs),
+                                 QString::number(r.cpuMs),
+                                 QString::number(r.units),
+                                 QString::number(r.workerComputeMs.size()),
+                                 QString::number(r.evaluations),
+                                 QString::number(r.requeuedUnits),
+                                 csvField(r.error)};
+        out += row.join(',') + "\n";
+    }
+    return out.toUtf8();
+}
+
+QJsonObject jobResultJson(const JobFileResult &result) {
+    const SubmitMsg &j = result.job;
+    const JobResultMsg &r = result.result;
+    QJsonObject o;
+    o.insert("a", j.a);
+    o.insert("b", j.b);
+    o.insert("h", j.h);
+    o.insert("method", methodName(j.method));
+    o.insert("tenant", j.tenant);
+    o.insert("priority", priorityName(j.priority));
+    o.insert("job_id", static_cast<qint64>(r.jobId));
+    o.insert("status", jobStatusName(r.status));
+    o.insert("value", r.value);
+    o.insert("elapsed_ms", r.elapsedMs);
+    o.insert("dispatch_ms", r.dispatchMs);
+    o.insert("compute_ms", r.computeMs);
+    o.insert("network_ms", r.networkMs);
+    o.insert("cpu_ms", r.cpuMs);
+    o.insert("units", static_cast<qint64>(r.units));
+    o.insert("workers", static_cast<qint64>(r.workerComputeMs.size()));
+    o.insert("evaluations", static_cast<qint64>(r.evaluations));
+    o.insert("requeued_units", static_cast<qint64>(r.requeuedUnits));
+    if (!r.error.isEmpty()) {
+        o.insert("error", r.error);
+    }
+    return o;
+}
+
+QByteArray jobResultsJson(const std::vector<JobFileResult> &results) {
+    QJsonArray array;
+    for (size_t i = 0; i < results.size(); ++i) {
+        QJsonObject o = jobResultJson(results[i]);
+        o.insert("index", static_cast<qint64>(i + 1));
+        array.append(o);
+    }
+    return QJsonDocument(array).toJson(QJsonDocument::Indented);
+}
+
+bool saveJobResults(const QString &path, const std::vector<JobFileResult> &results) {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    f.write(path.endsWith(".json", Qt::CaseInsensitive) ? jobResultsJson(results) : jobResultsCsv(results));
+    return f.commit();
+}
+
+} // namespace netproj
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "protocol.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief Parse "A B h method" job line into a submission; method is 1-3 or a name (see parseMethodName()).
+ * @return false with error set if the line is malformed.
+ */
+bool parseJobLine(const QString &line, SubmitMsg *m, QString *error);
+
+/**
+ * @brief Parse a job file into submissions (tenant "default", priority normal unless given).
+ *
+ * Either one "A B h method" job per line, skipping blank lines and lines starting with '#', or a JSON array of
+ * objects {"a", "b", "h", "method", "tenant", "priority"} where method is 1-3 or a name ("simpson") and tenant and
+ * priority are optional. Every job is validated like the server would, so a sweep fails before it starts.
+ * @return false with error set (naming the line or array index) if any job is malformed.
+ */
+bool parseJobFile(const QByteArray &data, std::vector<SubmitMsg> *jobs, QString *error);
+
+/**
+ * @brief One job of a job file with its result.
+ */
+struct JobFileResult {
+    SubmitMsg job;
+    JobResultMsg result;
+};
+
+/**
+ * @brief CSV field, quoted if it contains a separator, quote or line break.
+ */
+QString csvField(const QString &s);
+
+/**
+ * @brief Results as CSV: the job, its outcome and timing columns, one row per job in file order (index from 1).
+ */
+QByteArray jobResultsCsv(const std::vector<JobFileResult> &results);
+
+/**
+ * @brief One result as a JSON object with the fields of the CSV columns except the index; "error" only if set.
+ */
+QJsonObject jobResultJson(const JobFileResult &result);
+
+/**
+ * @brief Results as a JSON array of objects with the same fields as the CSV columns.
+ */
+QByteArray jobResultsJson(const std::vector<JobFileResult> &results);
+
+/**
+ * @brief Write results to path, as JSON if it ends in ".json" and as CSV otherwise.
+ */
+bool saveJobResults(const QString &path, const std::vector<JobFileResult> &results);
+
+} // namespace netproj
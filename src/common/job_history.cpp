@@ -0,0 +1,330 @@
+#include "job_history.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+
+namespace netproj {
+
+static constexpr char kMagic[4] = {'N', 'P', 'J', 'H'};
+
+static constexpr MethodType kMethods[] = {MethodType::MidpointRectangles, MethodType::Trapezoids,
+                                          MethodType::Simpson};
+
+QByteArray JobHistoryLog::header() {
+    QByteArray h(kHeaderSize, Qt::Uninitialized);
+    for (int i = 0; i < 4; ++i) {
+        h.data()[i] = kMagic[i];
+    }
+    qToBigEndian(kFormatVersion, h.data() + 4);
+    qToBigEndian(quint16(0), h.data() + 6);
+    return h;
+}
+
+bool JobHistoryLog::checkHeader(const char *data, qsizetype size, QString *error) {
+    if (size < kHeaderSize || QByteArray::fromRawData(data, 4) != QByteArray(kMagic, 4)) {
+        *error = QStringLiteral("not a job history");
+        return false;
+    }
+    const quint16 format = qFromBigEndian<quint16>(data + 4);
+    if (format != kFormatVersion) {
+        *error = "unsupported job history format " + QString::number(format);
+        return false;
+    }
+    return true;
+}
+
+QByteArray JobHistoryLog::encode(const JobRecord &r) {
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << r.finishedMs << r.jobId << r.a << r.b << r.h << static_cast<quint8>(r.method) << r.tenant
+        << static_cast<quint8>(r.priority) << static_cast<quint8>(r.status) << r.value << r.errorEstimate << r.error
+        << r.elapsedMs << r.dispatchMs << r.computeMs << r.networkMs << r.cpuMs << r.units << r.evaluations
+        << r.requeuedUnits << r.workerComputeMs << r.workerEvaluations;
+
+    QByteArray frame(kFrameHeaderSize, Qt::Uninitialized);
+    qToBigEndian(static_cast<quint32>(body.size()), frame.data());
+    qToBigEndian(qChecksum(body), frame.data() + 4);
+    frame += body;
+    return frame;
+}
+
+qsizetype JobHistoryLog::decode(const char *data, qsizetype size, JobRecord *r) {
+    if (size < kFrameHeaderSize) {
+        return 0;
+    }
+    const quint32 bodySize = qFromBigEndian<quint32>(data);
+    if (bodySize > static_cast<quint64>(size - kFrameHeaderSize)) {
+        return 0;
+    }
+    // Decodes straight from the mapped file; only strings and maps are copied out.
+    const QByteArray body = QByteArray::fromRawData(data + kFrameHeaderSize, static_cast<qsizetype>(bodySize));
+    if (qChecksum(body) != qFromBigEndian<quint16>(data + 4)) {
+        return 0;
+    }
+
+    QDataStream in(body);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint8 method = 0;
+    quint8 priority = 0;
+    quint8 status = 0;
+    in >> r->finishedMs >> r->jobId >> r->a >> r->b >> r->h >> method >> r->tenant >> priority >> status >> r->value >>
+        r->errorEstimate >> r->error >> r->elapsedMs >> r->dispatchMs >> r->computeMs >> r->networkMs >> r->cpuMs >>
+        r->units >> r->evaluations >> r->requeuedUnits >> r->workerComputeMs >> r->workerEvaluations;
+    if (in.status() != QDataStream::Ok || method < static_cast<quint8>(MethodType::MidpointRectangles) ||
+        method > static_cast<quint8>(MethodType::Simpson) || priority > static_cast<quint8>(JobPriority::Interactive) ||
+        status > static_cast<quint8>(JobStatus::Deferred)) {
+        return 0;
+    }
+    r->method = static_cast<MethodType>(method);
+    r->priority = static_cast<JobPriority>(priority);
+    r->status = static_cast<JobStatus>(status);
+    return kFrameHeaderSize + static_cast<qsizetype>(bodySize);
+}
+
+JobHistoryIndex::IntervalKey JobHistoryIndex::keyOf(double a, double b, MethodType method) {
+    IntervalKey k;
+    // Adding 0.0 folds -0.0 into +0.0 so both hash alike.
+    k.lo = std::min(a, b) + 0.0;
+    k.hi = std::max(a, b) + 0.0;
+    k.method = method;
+    return k;
+}
+
+void JobHistoryIndex::add(qint64 offset, const JobRecord &r) {
+    Entry e;
+    e.offset = offset;
+    // Clamped so the time index stays sorted even if the wall clock stepped back between two jobs.
+    e.finishedMs = std::max(r.finishedMs, lastFinishedMs());
+    e.h = r.h;
+    e.method = r.method;
+    e.status = r.status;
+    e.tenant = r.tenant;
+    e.value = (r.b < r.a) ? -r.value : r.value;
+    m_byInterval[keyOf(r.a, r.b, r.method)].push_back(static_cast<int>(m_entries.size()));
+    m_entries.push_back(e);
+}
+
+qint64 JobHistoryIndex::lastFinishedMs() const {
+    return m_entries.empty() ? std::numeric_limits<qint64>::min() : m_entries.back().finishedMs;
+}
+
+bool JobHistoryIndex::matches(const Entry &e, const JobHistoryQuery &q) const {
+    return e.finishedMs >= q.sinceMs && e.finishedMs < q.untilMs && (!q.h || e.h == *q.h) &&
+           (!q.method || e.method == *q.method) && (!q.status || e.status == *q.status) &&
+           (q.tenant.isEmpty() || e.tenant == q.tenant);
+}
+
+std::vector<qint64> JobHistoryIndex::find(const JobHistoryQuery &q) const {
+    std::vector<int> hits;
+    if (q.interval) {
+        for (const MethodType m : kMethods) {
+            const auto it = m_byInterval.constFind(keyOf(q.interval->first, q.interval->second, m));
+            if (it == m_byInterval.constEnd()) {
+                continue;
+            }
+            for (const int i : *it) {
+                if (matches(m_entries[static_cast<size_t>(i)], q)) {
+                    hits.push_back(i);
+                }
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+    } else {
+        const auto first = std::lower_bound(m_entries.begin(), m_entries.end(), q.sinceMs,
+                                            [](const Entry &e, qint64 t) { return e.finishedMs < t; });
+        for (auto it = first; it != m_entries.end() && it->finishedMs < q.untilMs; ++it) {
+            if (matches(*it, q)) {
+                hits.push_back(static_cast<int>(it - m_entries.begin()));
+            }
+        }
+    }
+    if (q.limit > 0 && hits.size() > static_cast<size_t>(q.limit)) {
+        hits.erase(hits.begin(), hits.end() - q.limit);
+    }
+
+    std::vector<qint64> offsets;
+    offsets.reserve(hits.size());
+    for (const int i : hits) {
+        offsets.push_back(m_entries[static_cast<size_t>(i)].offset);
+    }
+    return offsets;
+}
+
+qint64 JobHistoryIndex::latestOk(double a, double b, double h, MethodType method) const {
+    const auto it = m_byInterval.constFind(keyOf(a, b, method));
+    if (it == m_byInterval.constEnd()) {
+        return -1;
+    }
+    for (auto i = it->crbegin(); i != it->crend(); ++i) {
+        const Entry &e = m_entries[static_cast<size_t>(*i)];
+        if (e.h == h && e.status == JobStatus::Ok) {
+            return e.offset;
+        }
+    }
+    return -1;
+}
+
+double JobHistoryIndex::errorEstimate(const JobRecord &r) const {
+    const auto it = m_byInterval.constFind(keyOf(r.a, r.b, r.method));
+    if (r.status != JobStatus::Ok || it == m_byInterval.constEnd()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const Entry *other = nullptr;
+    for (auto i = it->crbegin(); i != it->crend(); ++i) {
+        const Entry &e = m_entries[static_cast<size_t>(*i)];
+        if (e.status != JobStatus::Ok || e.h == r.h) {
+            continue;
+        }
+        if (!other || std::abs(std::log(e.h / r.h)) < std::abs(std::log(other->h / r.h))) {
+            other = &e;
+        }
+    }
+    if (!other) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    // I(h) = I + C*h^p and I(h') = I + C*h'^p give C*h^p = (I(h) - I(h')) / (1 - (h'/h)^p).
+    const double p = (r.method == MethodType::Simpson) ? 4.0 : 2.0;
+    const double value = (r.b < r.a) ? -r.value : r.value;
+    return std::abs(value - other->value) / std::abs(1.0 - std::pow(other->h / r.h, p));
+}
+
+JobHistory::~JobHistory() {
+    close();
+}
+
+bool JobHistory::open(const QString &path, Mode mode) {
+    close();
+    m_error.clear();
+    m_index = JobHistoryIndex();
+    m_file.setFileName(path);
+    if (!m_file.open(mode == Mode::Append ? QIODevice::ReadWrite : QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (mode == Mode::Append && m_file.size() == 0 &&
+        (m_file.write(JobHistoryLog::header()) != JobHistoryLog::kHeaderSize || !m_file.flush())) {
+        m_error = m_file.errorString();
+        close();
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    m_map = (fileSize >= JobHistoryLog::kHeaderSize) ? m_file.map(0, fileSize) : nullptr;
+    m_mapped = m_map ? fileSize : 0;
+    const char *data = reinterpret_cast<const char *>(m_map);
+    if (!m_map) {
+        m_error = (fileSize >= JobHistoryLog::kHeaderSize) ? m_file.errorString() : QStringLiteral("not a job history");
+        close();
+        return false;
+    }
+    if (!JobHistoryLog::checkHeader(data, fileSize, &m_error)) {
+        close();
+        return false;
+    }
+
+    qint64 offset = JobHistoryLog::kHeaderSize;
+    JobRecord r;
+    while (offset < fileSize) {
+        const qsizetype n = JobHistoryLog::decode(data + offset, fileSize - offset, &r);
+        if (n == 0) {
+            break;
+        }
+        m_index.add(offset, r);
+        offset += n;
+    }
+    m_size = offset;
+    if (offset < fileSize) {
+        qWarning() << "Job history" << path << ": ignoring" << fileSize - offset << "bytes of a torn or corrupt record";
+        // Appending after the damage would hide every new record from the next scan.
+        if (mode == Mode::Append && !m_file.resize(offset)) {
+            m_error = m_file.errorString();
+            close();
+            return false;
+        }
+    }
+    if (mode == Mode::Append) {
+        m_file.seek(m_size);
+    }
+    return true;
+}
+
+bool JobHistory::append(JobRecord r) {
+    if (!m_file.isOpen() || !m_file.isWritable()) {
+        m_error = QStringLiteral("job history is not open for appending");
+        return false;
+    }
+    r.finishedMs = std::max(r.finishedMs, m_index.lastFinishedMs());
+    if (std::isnan(r.errorEstimate)) {
+        r.errorEstimate = m_index.errorEstimate(r);
+    }
+    const QByteArray frame = JobHistoryLog::encode(r);
+    if (m_file.write(frame) != frame.size() || !m_file.flush()) {
+        m_error = m_file.errorString();
+        // Cut a partial frame off again, or the next scan stops in front of it.
+        m_file.resize(m_size);
+        m_file.seek(m_size);
+        return false;
+    }
+    m_index.add(m_size, r);
+    m_size += frame.size();
+    return true;
+}
+
+bool JobHistory::read(qint64 offset, JobRecord *r) {
+    const auto decodeMapped = [this, offset, r]() {
+        return m_map && offset < m_mapped &&
+               JobHistoryLog::decode(reinterpret_cast<const char *>(m_map) + offset, m_mapped - offset, r) > 0;
+    };
+    if (decodeMapped()) {
+        return true;
+    }
+    if (m_mapped >= m_size) {
+        return false;
+    }
+    // Appended since the file was mapped.
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+    m_map = m_file.map(0, m_size);
+    m_mapped = m_map ? m_size : 0;
+    return decodeMapped();
+}
+
+std::vector<JobRecord> JobHistory::query(const JobHistoryQuery &q) {
+    std::vector<JobRecord> records;
+    for (const qint64 offset : m_index.find(q)) {
+        JobRecord r;
+        if (read(offset, &r)) {
+            records.push_back(r);
+        }
+    }
+    return records;
+}
+
+std::optional<JobRecord> JobHistory::latestOk(double a, double b, double h, MethodType method) {
+    const qint64 offset = m_index.latestOk(a, b, h, method);
+    JobRecord r;
+    if (offset < 0 || !read(offset, &r)) {
+        return std::nullopt;
+    }
+    return r;
+}
+
+void JobHistory::close() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapped = 0;
+    m_size = 0;
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+} // namespace netproj
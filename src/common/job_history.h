@@ -0,0 +1,240 @@
+#pragma once
+
+#include "protocol.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief Completed job as kept in the job history.
+ */
+struct JobRecord {
+    qint64 finishedMs = 0; ///< Wall clock, milliseconds since the epoch.
+    quint64 jobId = 0;
+    double a = 0.0;
+    double b = 0.0;
+    double h = 0.0;
+    MethodType method = MethodType::Simpson;
+    QString tenant;
+    JobPriority priority = JobPriority::Normal;
+    JobStatus status = JobStatus::Ok;
+    double value = 0.0;
+    double errorEstimate = std::numeric_limits<double>::quiet_NaN(); ///< Absolute; NaN if unknown.
+    QString error;
+    qint64 elapsedMs = 0;
+    qint64 dispatchMs = -1;
+    double computeMs = 0.0;
+    double networkMs = 0.0;
+    double cpuMs = 0.0;
+    quint32 units = 0;
+    quint64 evaluations = 0;
+    quint32 requeuedUnits = 0;
+    QMap<QString, double> workerComputeMs;
+    QMap<QString, quint64> workerEvaluations;
+};
+
+/**
+ * @brief Selects records of the job history; every set criterion must match.
+ */
+struct JobHistoryQuery {
+    qint64 sinceMs = std::numeric_limits<qint64>::min(); ///< Finished at or after.
+    qint64 untilMs = std::numeric_limits<qint64>::max(); ///< Finished before.
+    std::optional<QPair<double, double>> interval;       ///< Either orientation.
+    std::optional<double> h;
+    std::optional<MethodType> method;
+    std::optional<JobStatus> status;
+    QString tenant; ///< Empty: any.
+    int limit = 0;  ///< Keep only the newest limit matches (0: all).
+};
+
+/**
+ * @brief Binary job history format, without any I/O.
+ *
+ * A history starts with the 4 byte magic "NPJH", a quint16 format version and a reserved quint16 (big-endian).
+ * Each record follows as a quint32 body size and the quint16 CRC-16 of the body (big-endian), then the body in
+ * QDataStream format. Records are only ever appended; a torn or corrupt record ends the history.
+ */
+class JobHistoryLog {
+public:
+    static constexpr quint16 kFormatVersion = 1;
+    static constexpr qsizetype kHeaderSize = 8;
+    static constexpr qsizetype kFrameHeaderSize = 6;
+
+    /**
+     * @brief History header of the current format.
+     */
+    static QByteArray header();
+
+    /**
+     * @brief Check the header of data.
+     * @return false with error set if data is no history of this format.
+     */
+    static bool checkHeader(const char *data, qsizetype size, QString *error);
+
+    /**
+     * @brief Record with its frame header.
+     */
+    static QByteArray encode(const JobRecord &r);
+
+    /**
+     * @brief Decode the framed record at data.
+     * @return Size of the frame, or 0 if it is truncated or corrupt.
+     */
+    static qsizetype decode(const char *data, qsizetype size, JobRecord *r);
+};
+
+/**
+ * @brief In-memory index of a job history by finish time and by parameters.
+ *
+ * Records are added in finish-time order with the offset of their frame, so time ranges are found by binary
+ * search; the interval and method of each record lead to its runs at every step size.
+ */
+class JobHistoryIndex {
+public:
+    /**
+     * @brief Index the record r stored at offset; records are added in the order they were appended.
+     */
+    void add(qint64 offset, const JobRecord &r);
+
+    /**
+     * @brief Offsets of the records matching q, oldest first.
+     */
+    std::vector<qint64> find(const JobHistoryQuery &q) const;
+
+    /**
+     * @brief Offset of the newest successful run of exactly this computation (either orientation), or -1.
+     */
+    qint64 latestOk(double a, double b, double h, MethodType method) const;
+
+    /**
+     * @brief Absolute error of r estimated by Richardson extrapolation, NaN without a usable run to compare.
+     *
+     * Compares r with the newest successful run of the same interval and method at the nearest other step size,
+     * assuming the leading error term C*h^p of the method (p = 2 for rectangles and trapezoids, 4 for Simpson).
+     */
+    double errorEstimate(const JobRecord &r) const;
+
+    /**
+     * @brief Indexed records.
+     */
+    int size() const { return static_cast<int>(m_entries.size()); }
+
+    /**
+     * @brief Finish time of the newest record (minimum of qint64 if empty).
+     */
+    qint64 lastFinishedMs() const;
+
+private:
+    /**
+     * @brief Interval (ordered) and method; the step size is not part of it.
+     */
+    struct IntervalKey {
+        double lo = 0.0;
+        double hi = 0.0;
+        MethodType method = MethodType::Simpson;
+
+        bool operator==(const IntervalKey &o) const { return lo == o.lo && hi == o.hi && method == o.method; }
+    };
+    friend size_t qHash(const IntervalKey &key, size_t seed) {
+        return qHashMulti(seed, key.lo, key.hi, static_cast<quint8>(key.method));
+    }
+
+    /**
+     * @brief What queries need of a record without decoding it.
+     */
+    struct Entry {
+        qint64 offset = 0;
+        qint64 finishedMs = 0;
+        double h = 0.0;
+        MethodType method = MethodType::Simpson;
+        JobStatus status = JobStatus::Ok;
+        QString tenant;
+        double value = 0.0; ///< Oriented from lo to hi.
+    };
+
+    static IntervalKey keyOf(double a, double b, MethodType method);
+    bool matches(const Entry &e, const JobHistoryQuery &q) const;
+
+    std::vector<Entry> m_entries;                  ///< In finish-time order.
+    QHash<IntervalKey, QVector<int>> m_byInterval; ///< Entry indices, oldest first.
+};
+
+/**
+ * @brief Append-only job history file, memory-mapped for queries.
+ *
+ * The server appends one record per completed job; net_history and the result cache query it. Opening a history
+ * scans it once to build the index, dropping a torn last record left by a killed writer.
+ */
+class JobHistory {
+public:
+    enum class Mode {
+        ReadOnly,
+        Append ///< Create the file if needed.
+    };
+
+    ~JobHistory();
+
+    /**
+     * @brief Open the history at path and index it.
+     * @return false (see error()) if it cannot be opened or is no job history.
+     */
+    bool open(const QString &path, Mode mode = Mode::Append);
+
+    /**
+     * @brief Whether a history is open.
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+
+    /**
+     * @brief Why open() or append() failed.
+     */
+    const QString &error() const { return m_error; }
+
+    /**
+     * @brief Append r, stamped with an error estimate from earlier runs and a finish time not before the last one.
+     */
+    bool append(JobRecord r);
+
+    /**
+     * @brief Records matching q, oldest first (maps records appended since the last query).
+     */
+    std::vector<JobRecord> query(const JobHistoryQuery &q);
+
+    /**
+     * @brief Newest successful run of exactly this computation (either orientation).
+     */
+    std::optional<JobRecord> latestOk(double a, double b, double h, MethodType method);
+
+    /**
+     * @brief Records in the history.
+     */
+    int size() const { return m_index.size(); }
+
+    /**
+     * @brief Unmap and close the history.
+     */
+    void close();
+
+private:
+    bool read(qint64 offset, JobRecord *r);
+
+    QFile m_file;
+    uchar *m_map = nullptr; ///< Mapped prefix of the file, remapped when a query reaches past it.
+    qint64 m_mapped = 0;
+    qint64 m_size = 0; ///< End of the last valid record.
+    JobHistoryIndex m_index;
+    QString m_error;
+};
+
+} // namespace netproj
@@ -0,0 +1,43 @@
+#include "message_codec.h"
+
+#include <cstring>
+
+namespace netproj {
+
+MessageCodec::MessageCodec() {
+    // Unbuffered: a buffered QIODevice drops its read-ahead chunk on every seek and allocates a new one.
+    m_outDevice.setBuffer(&m_outBuffer);
+    m_outDevice.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    m_out.setDevice(&m_outDevice);
+    m_out.setVersion(QDataStream::Qt_6_5);
+
+    m_inDevice.setBuffer(&m_inBuffer);
+    m_inDevice.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    m_in.setDevice(&m_inDevice);
+    m_in.setVersion(QDataStream::Qt_6_5);
+}
+
+void MessageCodec::beginWrite() {
+    m_outDevice.seek(0);
+    m_out.resetStatus();
+}
+
+const QByteArray &MessageCodec::endWrite() {
+    // A longer earlier message leaves bytes behind this one; resize() keeps the capacity.
+    m_outBuffer.resize(m_outDevice.pos());
+    return m_outBuffer;
+}
+
+const ParsedMessage &MessageCodec::parse(const QByteArray &payload) {
+    // Copied rather than shared: the buffer keeps its capacity, and payload may point into a FrameDecoder.
+    m_inBuffer.resize(payload.size());
+    if (!payload.isEmpty()) {
+        std::memcpy(m_inBuffer.data(), payload.constData(), static_cast<size_t>(payload.size()));
+    }
+    m_inDevice.seek(0);
+    m_in.resetStatus();
+    readMessage(m_in, &m_parsed);
+    return m_parsed;
+}
+
+} // namespace netproj
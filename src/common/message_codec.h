@@ -0,0 +1,56 @@
+#pragma once
+
+#include "message_io.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+
+namespace netproj {
+
+/**
+ * @brief Serializes and parses messages with buffers kept from one message to the next.
+ *
+ * serialize*() and parseMessage() build a new QByteArray, QDataStream (with its QBuffer) and ParsedMessage for every
+ * message. A codec keeps them, so once its buffers have grown to the largest message and its strings to the longest
+ * one, serializing and parsing TASK and RESULT does not allocate. A codec belongs to one thread.
+ */
+class MessageCodec {
+public:
+    MessageCodec();
+    MessageCodec(const MessageCodec &) = delete;
+    MessageCodec &operator=(const MessageCodec &) = delete;
+
+    /**
+     * @brief Serialize a message body of given type into the codec's payload buffer (Envelope + message body).
+     * @return Payload, valid until the next serialize(); pass it to FramedSocket::sendFrame().
+     */
+    template <typename Msg>
+    const QByteArray &serialize(MessageType type, const Msg &m) {
+        beginWrite();
+        Envelope e;
+        e.type = type;
+        m_out << e << m;
+        return endWrite();
+    }
+
+    /**
+     * @brief Parse a payload into the codec's message.
+     * @return Parsed message, valid until the next parse().
+     */
+    const ParsedMessage &parse(const QByteArray &payload);
+
+private:
+    void beginWrite();
+    const QByteArray &endWrite();
+
+    QByteArray m_outBuffer;
+    QBuffer m_outDevice;
+    QDataStream m_out;
+    QByteArray m_inBuffer;
+    QBuffer m_inDevice;
+    QDataStream m_in;
+    ParsedMessage m_parsed;
+};
+
+} // namespace netproj
@@ -8,55 +8,87 @@
 namespace netproj {
 
 /**
- * @brief Serialize HelloMsg into payload bytes (Envelope + message body).
+ * @brief Serialize a message body of given type into payload bytes (Envelope + message body).
  */
-inline QByteArray serializeHello(const HelloMsg &m) {
+template <typename Msg>
+inline QByteArray serializeMessage(MessageType type, const Msg &m) {
     QByteArray buf;
     QDataStream out(&buf, QIODevice::WriteOnly);
     out.setVersion(QDataStream::Qt_6_5);
     Envelope e;
-    e.type = MessageType::Hello;
+    e.type = type;
     out << e << m;
     return buf;
 }
 
+/**
+ * @brief Serialize HelloMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializeHello(const HelloMsg &m) {
+    return serializeMessage(MessageType::Hello, m);
+}
+
 /**
  * @brief Serialize TaskMsg into payload bytes (Envelope + message body).
  */
 inline QByteArray serializeTask(const TaskMsg &m) {
-    QByteArray buf;
-    QDataStream out(&buf, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-    Envelope e;
-    e.type = MessageType::Task;
-    out << e << m;
-    return buf;
+    return serializeMessage(MessageType::Task, m);
 }
 
 /**
  * @brief Serialize ResultMsg into payload bytes (Envelope + message body).
  */
 inline QByteArray serializeResult(const ResultMsg &m) {
-    QByteArray buf;
-    QDataStream out(&buf, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-    Envelope e;
-    e.type = MessageType::Result;
-    out << e << m;
-    return buf;
+    return serializeMessage(MessageType::Result, m);
 }
 
 /**
  * @brief Serialize ErrorMsg into payload bytes (Envelope + message body).
  */
 inline QByteArray serializeError(const ErrorMsg &m) {
-    QByteArray buf;
-    QDataStream out(&buf, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-    Envelope e;
-    e.type = MessageType::Error;
-    out << e << m;
-    return buf;
+    return serializeMessage(MessageType::Error, m);
+}
+
+/**
+ * @brief Serialize CancelMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializeCancel(const CancelMsg &m) {
+    return serializeMessage(MessageType::Cancel, m);
+}
+
+/**
+ * @brief Serialize DrainMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializeDrain(const DrainMsg &m) {
+    return serializeMessage(MessageType::Drain, m);
+}
+
+/**
+ * @brief Serialize PingMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializePing(const PingMsg &m) {
+    return serializeMessage(MessageType::Ping, m);
+}
+
+/**
+ * @brief Serialize PongMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializePong(const PongMsg &m) {
+    return serializeMessage(MessageType::Pong, m);
+}
+
+/**
+ * @brief Serialize SubmitMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializeSubmit(const SubmitMsg &m) {
+    return serializeMessage(MessageType::Submit, m);
+}
+
+/**
+ * @brief Serialize JobResultMsg into payload bytes (Envelope + message body).
+ */
+inline QByteArray serializeJobResult(const JobResultMsg &m) {
+    return serializeMessage(MessageType::JobResult, m);
 }
 
 /**
@@ -68,57 +100,90 @@ struct ParsedMessage {
     TaskMsg task;
     ResultMsg result;
     ErrorMsg error;
+    CancelMsg cancel;
+    DrainMsg drain;
+    PingMsg ping;
+    PongMsg pong;
+    SubmitMsg submit;
+    JobResultMsg jobResult;
     bool ok = false;
     QString parseError;
 };
 
 /**
- * @brief Parse a payload buffer into a typed message.
- *
- * @param buf Raw payload bytes (must start with Envelope).
- * @return ParsedMessage with ok flag and parseError in case of failure.
+ * @brief Read Envelope and message body from in into pm; other members of pm keep their values.
  */
-inline ParsedMessage parseMessage(const QByteArray &buf) {
-    ParsedMessage pm;
-
-    QDataStream in(buf);
-    in.setVersion(QDataStream::Qt_6_5);
+inline void readMessage(QDataStream &in, ParsedMessage *pm) {
+    pm->ok = false;
 
-    in >> pm.env;
+    in >> pm->env;
     if (in.status() != QDataStream::Ok) {
-        pm.parseError = "QDataStream status not OK after reading envelope";
-        return pm;
+        pm->parseError = "QDataStream status not OK after reading envelope";
+        return;
     }
 
-    if (pm.env.magic != kProtocolMagic || pm.env.version != kProtocolVersion) {
-        pm.parseError = "Protocol magic/version mismatch";
-        return pm;
+    if (pm->env.magic != kProtocolMagic || pm->env.version != kProtocolVersion) {
+        pm->parseError = "Protocol magic/version mismatch";
+        return;
     }
 
-    switch (pm.env.type) {
+    switch (pm->env.type) {
     case MessageType::Hello:
-        in >> pm.hello;
+        in >> pm->hello;
         break;
     case MessageType::Task:
-        in >> pm.task;
+        in >> pm->task;
         break;
     case MessageType::Result:
-        in >> pm.result;
+        in >> pm->result;
         break;
     case MessageType::Error:
-        in >> pm.error;
+        in >> pm->error;
+        break;
+    case MessageType::Cancel:
+        in >> pm->cancel;
+        break;
+    case MessageType::Drain:
+        in >> pm->drain;
+        break;
+    case MessageType::Ping:
+        in >> pm->ping;
+        break;
+    case MessageType::Pong:
+        in >> pm->pong;
+        break;
+    case MessageType::Submit:
+        in >> pm->submit;
+        break;
+    case MessageType::JobResult:
+        in >> pm->jobResult;
         break;
     default:
-        pm.parseError = "Unknown message type";
-        return pm;
+        pm->parseError = "Unknown message type";
+        return;
     }
 
     if (in.status() != QDataStream::Ok) {
-        pm.parseError = "QDataStream status not OK after reading message body";
-        return pm;
+        pm->parseError = "QDataStream status not OK after reading message body";
+        return;
     }
 
-    pm.ok = true;
+    pm->parseError.clear();
+    pm->ok = true;
+}
+
+/**
+ * @brief Parse a payload buffer into a typed message.
+ *
+ * @param buf Raw payload bytes (must start with Envelope).
+ * @return ParsedMessage with ok flag and parseError in case of failure.
+ */
+inline ParsedMessage parseMessage(const QByteArray &buf) {
+    ParsedMessage pm;
+
+    QDataStream in(buf);
+    in.setVersion(QDataStream::Qt_6_5);
+    readMessage(in, &pm);
     return pm;
 }
 
@@ -0,0 +1,63 @@
+#include "process_stats.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace netproj {
+
+#if defined(Q_OS_WIN)
+static double fileTimeMs(const FILETIME &t) {
+    const quint64 ticks = (static_cast<quint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    return static_cast<double>(ticks) / 1e4; // 100 ns ticks
+}
+#endif
+
+double processCpuMs() {
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        return 0.0;
+    }
+    return fileTimeMs(kernel) + fileTimeMs(user);
+#elif defined(Q_OS_UNIX)
+    rusage ru = {};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        return 0.0;
+    }
+    const auto ms = [](const timeval &tv) {
+        return static_cast<double>(tv.tv_sec) * 1e3 + static_cast<double>(tv.tv_usec) / 1e3;
+    };
+    return ms(ru.ru_utime) + ms(ru.ru_stime);
+#else
+    return 0.0;
+#endif
+}
+
+quint64 peakRssKb() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return 0;
+    }
+    return static_cast<quint64>(pmc.PeakWorkingSetSize) / 1024;
+#elif defined(Q_OS_UNIX)
+    rusage ru = {};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        return 0;
+    }
+#if defined(Q_OS_MACOS)
+    return static_cast<quint64>(ru.ru_maxrss) / 1024; // bytes on macOS
+#else
+    return static_cast<quint64>(ru.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
+
+} // namespace netproj
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief CPU time (user + system, all threads) consumed by this process so far, in milliseconds.
+ */
+double processCpuMs();
+
+/**
+ * @brief Peak resident memory of this process in KiB (0 if unknown).
+ */
+quint64 peakRssKb();
+
+} // namespace netproj
@@ -2,7 +2,9 @@
 
 #include <QtGlobal>
 #include <QDataStream>
+#include <QMap>
 #include <QString>
+#include <QVector>
 
 namespace netproj {
 
@@ -14,7 +16,7 @@ static constexpr quint32 kProtocolMagic = 0x4E50524A; // 'NPRJ'
 /**
  * @brief Protocol version.
  */
-static constexpr quint16 kProtocolVersion = 1;
+static constexpr quint16 kProtocolVersion = 12;
 
 /**
  * @brief Message types supported by the wire protocol.
@@ -23,7 +25,13 @@ enum class MessageType : quint8 {
     Hello = 1,
     Task = 2,
     Result = 3,
-    Error = 4
+    Error = 4,
+    Submit = 5,
+    JobResult = 6,
+    Cancel = 7,
+    Drain = 8,
+    Ping = 9,
+    Pong = 10
 };
 
 /**
@@ -36,10 +44,54 @@ enum class MethodType : quint8 {
 };
 
 /**
- * @brief Client greeting containing number of available CPU cores.
+ * @brief Job priority classes. Higher classes are always scheduled first and may preempt lower ones.
+ */
+enum class JobPriority : quint8 {
+    Batch = 0,
+    Normal = 1,
+    Interactive = 2
+};
+
+/**
+ * @brief Final status of a submitted job.
+ */
+enum class JobStatus : quint8 {
+    Ok = 0,
+    Failed = 1,
+    Cancelled = 2,
+    Rejected = 3, ///< Refused by admission control; retrying will not help under current capacity.
+    Deferred = 4  ///< Not accepted now because the queue is saturated; retry after retryAfterMs.
+};
+
+/**
+ * @brief Flags of ResultMsg.
+ */
+enum ResultFlag : quint8 {
+    ResultCancelled = 0x01, ///< Unit was cancelled by the server before completion; value is meaningless.
+    ResultPartial = 0x02    ///< Worker is leaving; value covers only the first doneSteps steps of the unit.
+};
+
+/**
+ * @brief Bit flags of TaskMsg.
+ */
+enum TaskFlag : quint8 {
+    TaskTrace = 0x01 ///< Record trace spans of the unit and return them in ResultMsg::trace.
+};
+
+/**
+ * @brief Bit flags of HelloMsg.
+ */
+enum HelloFlag : quint8 {
+    HelloCoordinator = 0x01 ///< Peer coordinator lending its worker pool; cores is the pool's total.
+};
+
+/**
+ * @brief Client greeting containing number of available CPU cores and a stable worker identifier.
  */
 struct HelloMsg {
     quint32 cores = 0;
+    QString workerId;
+    quint8 flags = 0;
 };
 
 /**
@@ -52,13 +104,120 @@ struct TaskMsg {
     MethodType method = MethodType::Simpson;
     quint32 clientIndex = 0;
     quint32 clientCount = 0;
+    quint64 jobId = 0;
+    quint64 unitId = 0;
+    quint32 verifyBlocks = 0; ///< If > 0, report per-block sums of Integrator::partition(a, b, h, verifyBlocks).
+    quint8 flags = 0;
 };
 
 /**
- * @brief Client computation result.
+ * @brief Timed span recorded by a worker, in microseconds of the worker's monotonic trace clock.
+ */
+struct TraceSpan {
+    QString name;
+    quint32 thread = 0; ///< 0: event loop thread, otherwise a compute thread.
+    qint64 startUs = 0;
+    qint64 durUs = 0;
+};
+
+/**
+ * @brief How a worker computed a unit.
+ */
+struct TaskTelemetry {
+    double cpuMs = 0.0;       ///< Process CPU time (all threads) spent while the unit ran.
+    quint32 threads = 0;      ///< Compute threads available to the unit.
+    quint64 evaluations = 0;  ///< Integrand evaluations.
+    QString kernel;           ///< Integration kernel, see Integrator::kernelName().
+    quint64 peakRssKb = 0;    ///< Peak resident memory of the worker process.
+    bool hwCounters = false;  ///< Whether the hardware counters below were measured.
+    quint64 cycles = 0;       ///< CPU cycles of the compute threads (user space).
+    quint64 instructions = 0; ///< Retired instructions of the compute threads.
+    quint64 cacheMisses = 0;  ///< Last-level cache misses of the compute threads.
+    quint64 branchMisses = 0; ///< Mispredicted branches of the compute threads.
+};
+
+/**
+ * @brief Client computation result for one work unit.
  */
 struct ResultMsg {
+    quint64 jobId = 0;
+    quint64 unitId = 0;
+    quint8 flags = 0;
+    double value = 0.0;
+    QVector<double> blockSums; ///< Partial sums per verification block (empty unless requested by the task).
+    quint64 doneSteps = 0;     ///< With ResultPartial: steps from the unit start covered by value.
+    double computeMs = 0.0;    ///< Wall time the worker spent computing the unit.
+    QVector<TraceSpan> trace;  ///< Spans of the unit if the task asked for them (TaskTrace).
+    TaskTelemetry telemetry;
+};
+
+/**
+ * @brief Server request to abandon a running work unit (preemption or job cancellation).
+ */
+struct CancelMsg {
+    quint64 jobId = 0;
+    quint64 unitId = 0;
+};
+
+/**
+ * @brief Worker announcement that it is shutting down: it takes no new units and hands back its current one.
+ */
+struct DrainMsg {
+    quint32 deadlineMs = 0; ///< Time after which the current unit is returned partially computed.
+};
+
+/**
+ * @brief Clock probe sent by the server to a worker.
+ */
+struct PingMsg {
+    quint32 seq = 0;
+    qint64 serverUs = 0; ///< Server trace clock when sent.
+};
+
+/**
+ * @brief Worker answer to PingMsg, stamped with the worker's trace clock.
+ */
+struct PongMsg {
+    quint32 seq = 0;
+    qint64 serverUs = 0;  ///< Copied from PingMsg.
+    qint64 receivedUs = 0; ///< Worker clock when the ping arrived.
+    qint64 sentUs = 0;     ///< Worker clock when the pong was sent.
+};
+
+/**
+ * @brief Job submission sent by a submitter connection.
+ */
+struct SubmitMsg {
+    quint64 requestId = 0;
+    QString tenant;
+    JobPriority priority = JobPriority::Normal;
+    double a = 0.0;
+    double b = 0.0;
+    double h = 0.0;
+    MethodType method = MethodType::Simpson;
+};
+
+/**
+ * @brief Final result of a submitted job, sent back to the submitter.
+ */
+struct JobResultMsg {
+    quint64 requestId = 0;
+    quint64 jobId = 0;
+    JobStatus status = JobStatus::Ok;
     double value = 0.0;
+    qint64 elapsedMs = 0;
+    QString error;
+    qint64 retryAfterMs = 0;
+    qint64 dispatchMs = -1;                   ///< From submission to the first unit sent to a worker (-1 if none).
+    double computeMs = 0.0;                   ///< Worker compute time summed over accepted units.
+    double networkMs = 0.0;                   ///< Unit round trip minus compute time, summed over accepted units.
+    quint32 units = 0;                        ///< Accepted units.
+    QMap<QString, double> workerComputeMs;    ///< Compute time per worker id.
+    double cpuMs = 0.0;                       ///< Worker CPU time summed over accepted units.
+    quint64 evaluations = 0;                  ///< Integrand evaluations summed over accepted units.
+    QMap<QString, quint64> workerEvaluations; ///< Integrand evaluations per worker id.
+    quint32 requeuedUnits = 0;                ///< Units handed out again after being lost or cancelled.
+    quint64 requeuedSteps = 0;                ///< Steps of those units.
 };
 
 /**
@@ -99,7 +258,7 @@ inline QDataStream &operator>>(QDataStream &in, Envelope &e) {
  * @brief Serialize HelloMsg to QDataStream.
  */
 inline QDataStream &operator<<(QDataStream &out, const HelloMsg &m) {
-    out << m.cores;
+    out << m.cores << m.workerId << m.flags;
     return out;
 }
 
@@ -107,7 +266,7 @@ inline QDataStream &operator<<(QDataStream &out, const HelloMsg &m) {
  * @brief Deserialize HelloMsg from QDataStream.
  */
 inline QDataStream &operator>>(QDataStream &in, HelloMsg &m) {
-    in >> m.cores;
+    in >> m.cores >> m.workerId >> m.flags;
     return in;
 }
 
@@ -115,7 +274,8 @@ inline QDataStream &operator>>(QDataStream &in, HelloMsg &m) {
  * @brief Serialize TaskMsg to QDataStream.
  */
 inline QDataStream &operator<<(QDataStream &out, const TaskMsg &m) {
-    out << m.a << m.b << m.h << static_cast<quint8>(m.method) << m.clientIndex << m.clientCount;
+    out << m.a << m.b << m.h << static_cast<quint8>(m.method) << m.clientIndex << m.clientCount << m.jobId
+        << m.unitId << m.verifyBlocks << m.flags;
     return out;
 }
 
@@ -124,16 +284,52 @@ inline QDataStream &operator<<(QDataStream &out, const TaskMsg &m) {
  */
 inline QDataStream &operator>>(QDataStream &in, TaskMsg &m) {
     quint8 method = 0;
-    in >> m.a >> m.b >> m.h >> method >> m.clientIndex >> m.clientCount;
+    in >> m.a >> m.b >> m.h >> method >> m.clientIndex >> m.clientCount >> m.jobId >> m.unitId >> m.verifyBlocks
+        >> m.flags;
     m.method = static_cast<MethodType>(method);
     return in;
 }
 
+/**
+ * @brief Serialize TraceSpan to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const TraceSpan &s) {
+    out << s.name << s.thread << s.startUs << s.durUs;
+    return out;
+}
+
+/**
+ * @brief Deserialize TraceSpan from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, TraceSpan &s) {
+    in >> s.name >> s.thread >> s.startUs >> s.durUs;
+    return in;
+}
+
+/**
+ * @brief Serialize TaskTelemetry to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const TaskTelemetry &t) {
+    out << t.cpuMs << t.threads << t.evaluations << t.kernel << t.peakRssKb << t.hwCounters << t.cycles
+        << t.instructions << t.cacheMisses << t.branchMisses;
+    return out;
+}
+
+/**
+ * @brief Deserialize TaskTelemetry from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, TaskTelemetry &t) {
+    in >> t.cpuMs >> t.threads >> t.evaluations >> t.kernel >> t.peakRssKb >> t.hwCounters >> t.cycles
+        >> t.instructions >> t.cacheMisses >> t.branchMisses;
+    return in;
+}
+
 /**
  * @brief Serialize ResultMsg to QDataStream.
  */
 inline QDataStream &operator<<(QDataStream &out, const ResultMsg &m) {
-    out << m.value;
+    out << m.jobId << m.unitId << m.flags << m.value << m.blockSums << m.doneSteps << m.computeMs << m.trace
+        << m.telemetry;
     return out;
 }
 
@@ -141,7 +337,8 @@ inline QDataStream &operator<<(QDataStream &out, const ResultMsg &m) {
  * @brief Deserialize ResultMsg from QDataStream.
  */
 inline QDataStream &operator>>(QDataStream &in, ResultMsg &m) {
-    in >> m.value;
+    in >> m.jobId >> m.unitId >> m.flags >> m.value >> m.blockSums >> m.doneSteps >> m.computeMs >> m.trace
+        >> m.telemetry;
     return in;
 }
 
@@ -161,4 +358,267 @@ inline QDataStream &operator>>(QDataStream &in, ErrorMsg &m) {
     return in;
 }
 
+/**
+ * @brief Serialize DrainMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const DrainMsg &m) {
+    out << m.deadlineMs;
+    return out;
+}
+
+/**
+ * @brief Deserialize DrainMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, DrainMsg &m) {
+    in >> m.deadlineMs;
+    return in;
+}
+
+/**
+ * @brief Serialize CancelMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const CancelMsg &m) {
+    out << m.jobId << m.unitId;
+    return out;
+}
+
+/**
+ * @brief Deserialize CancelMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, CancelMsg &m) {
+    in >> m.jobId >> m.unitId;
+    return in;
+}
+
+/**
+ * @brief Serialize PingMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const PingMsg &m) {
+    out << m.seq << m.serverUs;
+    return out;
+}
+
+/**
+ * @brief Deserialize PingMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, PingMsg &m) {
+    in >> m.seq >> m.serverUs;
+    return in;
+}
+
+/**
+ * @brief Serialize PongMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const PongMsg &m) {
+    out << m.seq << m.serverUs << m.receivedUs << m.sentUs;
+    return out;
+}
+
+/**
+ * @brief Deserialize PongMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, PongMsg &m) {
+    in >> m.seq >> m.serverUs >> m.receivedUs >> m.sentUs;
+    return in;
+}
+
+/**
+ * @brief Serialize SubmitMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const SubmitMsg &m) {
+    out << m.requestId << m.tenant << static_cast<quint8>(m.priority) << m.a << m.b << m.h
+        << static_cast<quint8>(m.method);
+    return out;
+}
+
+/**
+ * @brief Deserialize SubmitMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, SubmitMsg &m) {
+    quint8 priority = 0;
+    quint8 method = 0;
+    in >> m.requestId >> m.tenant >> priority >> m.a >> m.b >> m.h >> method;
+    m.priority = static_cast<JobPriority>(priority);
+    m.method = static_cast<MethodType>(method);
+    return in;
+}
+
+/**
+ * @brief Serialize JobResultMsg to QDataStream.
+ */
+inline QDataStream &operator<<(QDataStream &out, const JobResultMsg &m) {
+    out << m.requestId << m.jobId << static_cast<quint8>(m.status) << m.value << m.elapsedMs << m.error
+        << m.retryAfterMs << m.dispatchMs << m.computeMs << m.networkMs << m.units << m.workerComputeMs << m.cpuMs
+        << m.evaluations << m.workerEvaluations << m.requeuedUnits << m.requeuedSteps;
+    return out;
+}
+
+/**
+ * @brief Deserialize JobResultMsg from QDataStream.
+ */
+inline QDataStream &operator>>(QDataStream &in, JobResultMsg &m) {
+    quint8 status = 0;
+    in >> m.requestId >> m.jobId >> status >> m.value >> m.elapsedMs >> m.error >> m.retryAfterMs >> m.dispatchMs
+        >> m.computeMs >> m.networkMs >> m.units >> m.workerComputeMs >> m.cpuMs >> m.evaluations
+        >> m.workerEvaluations >> m.requeuedUnits >> m.requeuedSteps;
+    m.status = static_cast<JobStatus>(status);
+    return in;
+}
+
+/**
+ * @brief Parse method id from user input (1=midpoint, 2=trapezoids, 3=Simpson; anything else is Simpson).
+ */
+inline MethodType parseMethod(int v) {
+    switch (v) {
+    case 1:
+        return MethodType::MidpointRectangles;
+    case 2:
+        return MethodType::Trapezoids;
+    case 3:
+        return MethodType::Simpson;
+    default:
+        return MethodType::Simpson;
+    }
+}
+
+/**
+ * @brief Get method name for logging.
+ */
+inline QString methodName(MethodType m) {
+    switch (m) {
+    case MethodType::MidpointRectangles:
+        return "midpoint_rectangles";
+    case MethodType::Trapezoids:
+        return "trapezoids";
+    case MethodType::Simpson:
+        return "simpson";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Parse method from user input: its id (1-3) as in job lines, or its methodName() ("simpson").
+ * @return false if it is neither.
+ */
+inline bool parseMethodName(const QString &name, MethodType *out) {
+    const QString n = name.trimmed().toLower();
+    bool isId = false;
+    const int id = n.toInt(&isId);
+    if (isId) {
+        if (id < 1 || id > 3) {
+            return false;
+        }
+        *out = parseMethod(id);
+        return true;
+    }
+    for (MethodType m : {MethodType::MidpointRectangles, MethodType::Trapezoids, MethodType::Simpson}) {
+        if (n == methodName(m)) {
+            *out = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parse priority class name ("batch", "normal", "interactive").
+ * @return false if the name is unknown.
+ */
+inline bool parsePriority(const QString &name, JobPriority *out) {
+    const QString n = name.trimmed().toLower();
+    if (n == "batch") {
+        *out = JobPriority::Batch;
+    } else if (n == "normal") {
+        *out = JobPriority::Normal;
+    } else if (n == "interactive") {
+        *out = JobPriority::Interactive;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get priority class name for logging.
+ */
+inline QString priorityName(JobPriority p) {
+    switch (p) {
+    case JobPriority::Batch:
+        return "batch";
+    case JobPriority::Normal:
+        return "normal";
+    case JobPriority::Interactive:
+        return "interactive";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Get job status name for logging.
+ */
+inline QString jobStatusName(JobStatus s) {
+    switch (s) {
+    case JobStatus::Ok:
+        return "ok";
+    case JobStatus::Failed:
+        return "failed";
+    case JobStatus::Cancelled:
+        return "cancelled";
+    case JobStatus::Rejected:
+        return "rejected";
+    case JobStatus::Deferred:
+        return "deferred";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Parse job status name as printed by jobStatusName() ("ok", "failed", ...).
+ * @return false if the name is unknown.
+ */
+inline bool parseJobStatus(const QString &name, JobStatus *out) {
+    const QString n = name.trimmed().toLower();
+    for (JobStatus s :
+         {JobStatus::Ok, JobStatus::Failed, JobStatus::Cancelled, JobStatus::Rejected, JobStatus::Deferred}) {
+        if (n == jobStatusName(s)) {
+            *out = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get message type name for logging and metrics.
+ */
+inline QString messageTypeName(MessageType t) {
+    switch (t) {
+    case MessageType::Hello:
+        return "hello";
+    case MessageType::Task:
+        return "task";
+    case MessageType::Result:
+        return "result";
+    case MessageType::Error:
+        return "error";
+    case MessageType::Submit:
+        return "submit";
+    case MessageType::JobResult:
+        return "job_result";
+    case MessageType::Cancel:
+        return "cancel";
+    case MessageType::Drain:
+        return "drain";
+    case MessageType::Ping:
+        return "ping";
+    case MessageType::Pong:
+        return "pong";
+    default:
+        return "unknown";
+    }
+}
+
 } // namespace netproj
@@ -0,0 +1,152 @@
+#include "session_log.h"
+
+#include "protocol.h"
+#include "tracing.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace netproj {
+
+static constexpr char kMagic[4] = {'N', 'P', 'S', 'L'};
+static constexpr qsizetype kFlushBytes = 64 * 1024;
+static constexpr qint64 kFlushIntervalUs = SessionRecorder::kFlushIntervalMs * qint64(1000);
+
+static void appendVarint(QByteArray *out, quint64 v) {
+    while (v >= 0x80) {
+        out->append(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out->append(static_cast<char>(v));
+}
+
+QByteArray SessionLog::header() {
+    QByteArray h(kHeaderSize, Qt::Uninitialized);
+    for (int i = 0; i < 4; ++i) {
+        h.data()[i] = kMagic[i];
+    }
+    qToBigEndian(kFormatVersion, h.data() + 4);
+    qToBigEndian(kProtocolVersion, h.data() + 6);
+    return h;
+}
+
+void SessionLog::append(QByteArray *out, const SessionRecord &r, qint64 *lastUs) {
+    appendVarint(out, static_cast<quint64>(std::max<qint64>(0, r.timeUs - *lastUs)));
+    appendVarint(out, r.connection);
+    appendVarint(out, static_cast<quint8>(r.event));
+    appendVarint(out, static_cast<quint64>(r.payload.size()));
+    out->append(r.payload);
+    *lastUs = std::max(*lastUs, r.timeUs);
+}
+
+bool SessionDecoder::reset(const QByteArray &data) {
+    m_data = data;
+    m_offset = SessionLog::kHeaderSize;
+    m_timeUs = 0;
+    m_error.clear();
+    if (data.size() < SessionLog::kHeaderSize || data.left(4) != QByteArray(kMagic, 4)) {
+        m_error = QStringLiteral("not a session log");
+        return false;
+    }
+    const quint16 format = qFromBigEndian<quint16>(data.constData() + 4);
+    const quint16 protocol = qFromBigEndian<quint16>(data.constData() + 6);
+    if (format != SessionLog::kFormatVersion) {
+        m_error = "unsupported session log format " + QString::number(format);
+        return false;
+    }
+    if (protocol != kProtocolVersion) {
+        m_error = "session recorded with protocol version " + QString::number(protocol) + ", this build speaks " +
+                  QString::number(kProtocolVersion);
+        return false;
+    }
+    return true;
+}
+
+bool SessionDecoder::readVarint(quint64 *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (m_offset >= m_data.size()) {
+            return false;
+        }
+        const quint8 byte = static_cast<quint8>(m_data[m_offset++]);
+        *v |= static_cast<quint64>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SessionDecoder::next(SessionRecord *r) {
+    if (!m_error.isEmpty() || m_offset >= m_data.size()) {
+        return false;
+    }
+    quint64 delta = 0;
+    quint64 connection = 0;
+    quint64 event = 0;
+    quint64 size = 0;
+    if (!readVarint(&delta) || !readVarint(&connection) || !readVarint(&event) || !readVarint(&size) ||
+        event > static_cast<quint8>(SessionEvent::Out) || size > static_cast<quint64>(m_data.size() - m_offset)) {
+        m_error = "truncated or corrupt record at byte " + QString::number(m_offset);
+        return false;
+    }
+    m_timeUs += static_cast<qint64>(delta);
+    r->timeUs = m_timeUs;
+    r->connection = static_cast<quint32>(connection);
+    r->event = static_cast<SessionEvent>(event);
+    r->payload = m_data.mid(m_offset, static_cast<qsizetype>(size));
+    m_offset += static_cast<qsizetype>(size);
+    return true;
+}
+
+SessionRecorder::~SessionRecorder() {
+    close();
+}
+
+bool SessionRecorder::open(const QString &path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    m_startUs = traceClockUs();
+    m_lastUs = 0;
+    m_lastFlushUs = m_startUs;
+    m_records = 0;
+    m_pending = SessionLog::header();
+    flush();
+    return true;
+}
+
+void SessionRecorder::record(quint32 connection, SessionEvent event, const QByteArray &payload) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+    const qint64 nowUs = traceClockUs();
+    SessionLog::append(&m_pending, SessionRecord{nowUs - m_startUs, connection, event, payload}, &m_lastUs);
+    ++m_records;
+    if (m_pending.size() >= kFlushBytes || nowUs - m_lastFlushUs >= kFlushIntervalUs) {
+        flush();
+    }
+}
+
+void SessionRecorder::flush() {
+    if (!m_file.isOpen() || m_pending.isEmpty()) {
+        return;
+    }
+    m_file.write(m_pending);
+    m_file.flush();
+    m_pending.clear();
+    m_lastFlushUs = traceClockUs();
+}
+
+void SessionRecorder::close() {
+    if (!m_file.isOpen()) {
+        return;
+    }
+    flush();
+    m_file.close();
+}
+
+} // namespace netproj
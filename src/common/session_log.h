@@ -0,0 +1,133 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief What happened on a recorded connection.
+ */
+enum class SessionEvent : quint8 {
+    Open = 0,  ///< Connection accepted.
+    Close = 1, ///< Connection closed.
+    In = 2,    ///< Frame received by the recording side.
+    Out = 3    ///< Frame sent by the recording side.
+};
+
+/**
+ * @brief One entry of a session log.
+ */
+struct SessionRecord {
+    qint64 timeUs = 0; ///< Since the start of the recording.
+    quint32 connection = 0;
+    SessionEvent event = SessionEvent::In;
+    QByteArray payload; ///< Frame payload without the length prefix (In/Out only).
+};
+
+/**
+ * @brief Binary session log format, without any I/O.
+ *
+ * A log starts with the 4 byte magic "NPSL", a quint16 format version and the quint16 wire protocol version of the
+ * recorded payloads (both big-endian). Each record follows as LEB128 varints: time since the previous record in
+ * microseconds, connection id, event, payload size; then the payload bytes. A HELLO/RESULT exchange costs a few bytes
+ * of overhead per frame.
+ */
+class SessionLog {
+public:
+    static constexpr quint16 kFormatVersion = 1;
+    static constexpr qsizetype kHeaderSize = 8;
+
+    /**
+     * @brief Log header for the current protocol version.
+     */
+    static QByteArray header();
+
+    /**
+     * @brief Append r to out.
+     * @param lastUs Time of the previous record; updated to r.timeUs.
+     */
+    static void append(QByteArray *out, const SessionRecord &r, qint64 *lastUs);
+};
+
+/**
+ * @brief Reads the records of a session log held in memory.
+ */
+class SessionDecoder {
+public:
+    /**
+     * @brief Start decoding data.
+     * @return false (see error()) if the header is invalid or from another protocol version.
+     */
+    bool reset(const QByteArray &data);
+
+    /**
+     * @brief Take the next record.
+     * @return false at the end of the log or on a truncated record (error() is set then).
+     */
+    bool next(SessionRecord *r);
+
+    /**
+     * @brief Why decoding stopped early (empty if not).
+     */
+    const QString &error() const { return m_error; }
+
+private:
+    bool readVarint(quint64 *v);
+
+    QByteArray m_data;
+    qsizetype m_offset = 0;
+    qint64 m_timeUs = 0;
+    QString m_error;
+};
+
+/**
+ * @brief Appends records to a session log file.
+ *
+ * Records are buffered and written out when 64 KiB are pending, with the next record a second after the last
+ * write, on flush() and on close. The owner calls flush() every kFlushIntervalMs, so an idle or killed process
+ * loses at most about a second of the session.
+ */
+class SessionRecorder {
+public:
+    static constexpr int kFlushIntervalMs = 1000;
+
+    ~SessionRecorder();
+
+    /**
+     * @brief Create (truncate) the log at path and write its header.
+     */
+    bool open(const QString &path);
+
+    /**
+     * @brief Whether a log is open.
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+
+    /**
+     * @brief Append one record stamped with the current time.
+     */
+    void record(quint32 connection, SessionEvent event, const QByteArray &payload = QByteArray());
+
+    /**
+     * @brief Write out pending records.
+     */
+    void flush();
+
+    /**
+     * @brief Flush and close the log.
+     */
+    void close();
+
+private:
+    QFile m_file;
+    QByteArray m_pending;
+    qint64 m_startUs = 0;
+    qint64 m_lastUs = 0;
+    qint64 m_lastFlushUs = 0;
+    quint64 m_records = 0;
+};
+
+} // namespace netproj
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The capacity is rounded up to a power of two. Producer and consumer indices live on separate cache lines and
+ * each side caches the other's index, so a push or pop touches shared memory only when the cached view says the
+ * ring is full or empty.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : m_slots(roundUp(capacity)),
+          m_mask(m_slots.size() - 1) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Number of slots.
+     */
+    size_t capacity() const { return m_slots.size(); }
+
+    /**
+     * @brief Append v (producer thread only).
+     * @return false if the ring is full; v is left untouched then.
+     */
+    bool push(T &&v) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tailCache == m_slots.size()) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tailCache == m_slots.size()) {
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = std::move(v);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest element (consumer thread only).
+     * @return false if the ring is empty.
+     */
+    bool pop(T *out) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_headCache) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail == m_headCache) {
+                return false;
+            }
+        }
+        *out = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether the ring is empty (exact only when called from the consumer with the producer idle).
+     */
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::vector<T> m_slots;
+    const size_t m_mask;
+    alignas(64) std::atomic<size_t> m_head{0}; ///< Next slot to write (producer).
+    size_t m_tailCache = 0;                    ///< Producer's view of m_tail.
+    alignas(64) std::atomic<size_t> m_tail{0}; ///< Next slot to read (consumer).
+    size_t m_headCache = 0;                    ///< Consumer's view of m_head.
+};
+
+} // namespace netproj
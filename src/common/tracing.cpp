@@ -0,0 +1,28 @@
+#include "tracing.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace netproj {
+
+qint64 traceClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+quint32 traceThreadId() {
+    static std::atomic<quint32> next{0};
+    thread_local const quint32 id = ++next;
+    return id;
+}
+
+void ClockSync::addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3) {
+    const qint64 rtt = (t3 - t0) - (t2 - t1);
+    if (rtt < 0 || (m_rttUs >= 0 && rtt >= m_rttUs)) {
+        return;
+    }
+    m_rttUs = rtt;
+    m_offsetUs = ((t1 - t0) + (t2 - t3)) / 2;
+}
+
+} // namespace netproj
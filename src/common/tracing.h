@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief Monotonic trace clock of this process in microseconds (arbitrary origin).
+ */
+qint64 traceClockUs();
+
+/**
+ * @brief Small stable number of the calling thread for trace lanes (1, 2, .. in order of first use).
+ */
+quint32 traceThreadId();
+
+/**
+ * @brief Offset of a remote trace clock estimated from request/response timestamps (NTP style).
+ *
+ * Each sample is a round trip: t0 local send, t1 remote receive, t2 remote send, t3 local receive. The sample
+ * with the smallest round trip bounds the error best (by half its round trip), so it is the one kept.
+ */
+class ClockSync {
+public:
+    /**
+     * @brief Add one round trip sample.
+     */
+    void addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3);
+
+    /**
+     * @brief Whether any sample has been added.
+     */
+    bool valid() const { return m_rttUs >= 0; }
+
+    /**
+     * @brief Remote clock minus local clock.
+     */
+    qint64 offsetUs() const { return m_offsetUs; }
+
+    /**
+     * @brief Network round trip of the best sample (-1 if none).
+     */
+    qint64 rttUs() const { return m_rttUs; }
+
+    /**
+     * @brief Convert a remote timestamp to the local clock.
+     */
+    qint64 toLocal(qint64 remoteUs) const { return remoteUs - m_offsetUs; }
+
+private:
+    qint64 m_offsetUs = 0;
+    qint64 m_rttUs = -1;
+};
+
+} // namespace netproj
@@ -0,0 +1,82 @@
+#include "chaos.h"
+
+#include "../proxy/link_shaper.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+
+namespace netproj {
+
+QString faultKindName(FaultKind kind) {
+    switch (kind) {
+    case FaultKind::Kill:
+        return "kill";
+    case FaultKind::Pause:
+        return "pause";
+    case FaultKind::Restart:
+        return "restart";
+    }
+    return "unknown";
+}
+
+bool parseChaos(const QString &text, ChaosSpec *spec, QString *error) {
+    ChaosSpec s;
+    const QHash<QString, double *> fields = {{"kill-every", &s.killEveryMs},
+                                             {"pause-every", &s.pauseEveryMs},
+                                             {"pause", &s.pauseMs},
+                                             {"restart-every", &s.restartEveryMs},
+                                             {"restart-delay", &s.restartDelayMs}};
+    if (!parseSpec(text, fields, "fault", error)) {
+        return false;
+    }
+    if (s.isNone()) {
+        *error = "no fault rate given (kill-every, pause-every or restart-every)";
+        return false;
+    }
+    *spec = s;
+    return true;
+}
+
+FaultPlan::FaultPlan(const ChaosSpec &spec, quint32 seed)
+    : m_spec(spec), m_rng(seed) {}
+
+FaultEvent FaultPlan::next() {
+    const double killRate = (m_spec.killEveryMs > 0.0) ? 1.0 / m_spec.killEveryMs : 0.0;
+    const double pauseRate = (m_spec.pauseEveryMs > 0.0) ? 1.0 / m_spec.pauseEveryMs : 0.0;
+    const double restartRate = (m_spec.restartEveryMs > 0.0) ? 1.0 / m_spec.restartEveryMs : 0.0;
+    const double total = killRate + pauseRate + restartRate;
+
+    FaultEvent e;
+    if (!(total > 0.0)) {
+        return e;
+    }
+    e.delayMs = static_cast<qint64>(std::llround(exponentialMs(m_rng, 1.0 / total)));
+    const double u = m_rng.generateDouble() * total;
+    if (u < killRate) {
+        e.kind = FaultKind::Kill;
+    } else if (u < killRate + pauseRate) {
+        e.kind = FaultKind::Pause;
+    } else {
+        e.kind = FaultKind::Restart;
+    }
+    return e;
+}
+
+int FaultPlan::pick(int count) {
+    return (count > 1) ? static_cast<int>(m_rng.bounded(static_cast<quint32>(count))) : 0;
+}
+
+bool sameResult(double reference, double value) {
+    // Units are summed in whatever order they finish, and a requeued range may be split differently.
+    return std::fabs(value - reference) <= 1e-9 * std::max(1.0, std::fabs(reference));
+}
+
+void RecoveryStats::add(double ms) {
+    ++count;
+    totalMs += ms;
+    maxMs = std::max(maxMs, ms);
+}
+
+} // namespace netproj
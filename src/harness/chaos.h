@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QRandomGenerator>
+#include <QString>
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief Fault injected into a worker process by the chaos harness.
+ */
+enum class FaultKind {
+    Kill,    ///< SIGKILL; the worker is started again after the restart delay.
+    Pause,   ///< SIGSTOP for the pause length, then SIGCONT.
+    Restart, ///< SIGTERM (graceful drain); the worker is started again after the restart delay.
+};
+
+/**
+ * @brief Fault name for reports.
+ */
+QString faultKindName(FaultKind kind);
+
+/**
+ * @brief Fault rates of a chaos run. Each kind arrives as a Poisson process of its own.
+ */
+struct ChaosSpec {
+    double killEveryMs = 0.0;      ///< Mean time between kills (0: none).
+    double pauseEveryMs = 0.0;     ///< Mean time between pauses (0: none).
+    double pauseMs = 1000.0;       ///< How long a paused worker stays stopped.
+    double restartEveryMs = 0.0;   ///< Mean time between graceful restarts (0: none).
+    double restartDelayMs = 500.0; ///< How long a killed or restarted worker stays down.
+
+    /**
+     * @brief Whether no fault is configured.
+     */
+    bool isNone() const { return killEveryMs <= 0.0 && pauseEveryMs <= 0.0 && restartEveryMs <= 0.0; }
+};
+
+/**
+ * @brief Parse "kill-every=5000,pause-every=3000,pause=1000,restart-every=8000,restart-delay=500".
+ *
+ * Keys may be given in any order and any subset; all values are in milliseconds.
+ * @return false (with error set) on unknown keys or invalid values.
+ */
+bool parseChaos(const QString &text, ChaosSpec *spec, QString *error);
+
+/**
+ * @brief Next fault of a chaos run.
+ */
+struct FaultEvent {
+    qint64 delayMs = 0; ///< From the previous fault (or the start).
+    FaultKind kind = FaultKind::Kill;
+};
+
+/**
+ * @brief Draws the fault sequence of a chaos run from a seed, so a failing run can be repeated.
+ */
+class FaultPlan {
+public:
+    FaultPlan(const ChaosSpec &spec, quint32 seed);
+
+    /**
+     * @brief Next fault: the superposition of the per-kind processes, so the kind is drawn by rate.
+     */
+    FaultEvent next();
+
+    /**
+     * @brief Pick one of count candidates uniformly.
+     */
+    int pick(int count);
+
+private:
+    ChaosSpec m_spec;
+    QRandomGenerator m_rng;
+};
+
+/**
+ * @brief Whether a distributed result agrees with the in-process reference up to summation order.
+ */
+bool sameResult(double reference, double value);
+
+/**
+ * @brief Count, mean and maximum of recovery times of one fault kind.
+ */
+struct RecoveryStats {
+    int count = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+
+    void add(double ms);
+    double meanMs() const { return count > 0 ? totalMs / count : 0.0; }
+};
+
+} // namespace netproj
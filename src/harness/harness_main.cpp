@@ -0,0 +1,1068 @@
+#include "../common/framed_socket.h"
+#include "../common/integrator.h"
+#include "../common/job_file.h"
+#include "../common/message_io.h"
+#include "../proxy/link_shaper.h"
+#include "chaos.h"
+#include "scaling.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <map>
+#include <optional>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#endif
+
+namespace netproj {
+
+/**
+ * @brief How long the cluster may take to come up before the run is aborted.
+ */
+static constexpr int kStartupTimeoutMs = 30000;
+
+/**
+ * @brief The impairment proxy of a cluster listens this far above the server's port.
+ */
+static constexpr int kProxyPortOffset = 1000;
+
+/**
+ * @brief One job of the benchmark matrix with its single-core reference time.
+ */
+struct BenchJob {
+    SubmitMsg msg;
+    double baselineMs = 0.0;
+    double reference = 0.0; ///< In-process value every distributed result is checked against.
+};
+
+/**
+ * @brief Cluster configuration and the jobs run on it.
+ */
+struct BenchStage {
+    enum class Kind {
+        Matrix,
+        Strong,
+        Weak
+    };
+
+    Kind kind = Kind::Matrix;
+    int workers = 1;
+    int threads = 0; ///< Threads per worker (0: worker default, all hardware threads).
+    QVector<int> jobs;
+    bool chaos = false; ///< Faults are injected into the workers while the jobs run.
+};
+
+/**
+ * @brief Measured run of one job on the cluster.
+ */
+struct BenchRow {
+    int stage = 0;
+    int job = 0;
+    int run = 0;
+    double makespanMs = 0.0;
+    JobResultMsg result;
+};
+
+/**
+ * @brief End-to-end benchmark harness: starts net_server in service mode and K local net_client workers, runs
+ * jobs one at a time and reports where the time went.
+ *
+ * Matrix mode runs a job matrix on one cluster and reports per job makespan (submit to result, measured here),
+ * time to first dispatch, compute time summed over units and per worker, network time (unit round trips minus
+ * compute), and speedup and parallel efficiency against a single-core in-process run of the same job.
+ *
+ * Scaling mode restarts the cluster for 1..N workers and 1..T threads per worker and runs one job on each
+ * configuration as is (strong scaling) and with its interval stretched by workers * threads (weak scaling).
+ *
+ * Chaos mode runs the matrix twice, the second time while workers are killed, paused and restarted, and compares
+ * results and makespans of the two runs.
+ */
+class HarnessApp : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct harness app.
+     */
+    explicit HarnessApp(QObject *parent = nullptr)
+        : QObject(parent) {
+        m_startupTimer.setSingleShot(true);
+        connect(&m_startupTimer, &QTimer::timeout, this, [this]() {
+            fail("cluster did not start within " + QString::number(kStartupTimeoutMs) + " ms");
+        });
+        m_faultTimer.setSingleShot(true);
+        connect(&m_faultTimer, &QTimer::timeout, this, &HarnessApp::injectFault);
+        connect(&m_socket, &QTcpSocket::connected, this, &HarnessApp::onConnected);
+        connect(&m_socket, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+            if (!m_stopping) {
+                fail("socket error: " + m_socket.errorString());
+            }
+        });
+    }
+
+    ~HarnessApp() override { stopCluster(); }
+
+    /**
+     * @brief Set executables of the server and the workers.
+     */
+    void setPrograms(const QString &server, const QString &client) {
+        m_serverProgram = server;
+        m_clientProgram = client;
+    }
+
+    /**
+     * @brief Connect workers through net_proxy (program) with the impairment spec (empty: directly).
+     *
+     * The submitter always connects directly, so makespan includes only the impaired worker traffic.
+     */
+    void setImpairment(const QString &program, const QString &spec) {
+        m_proxyProgram = program;
+        m_impairment = spec;
+    }
+
+    /**
+     * @brief Set first server port; each cluster restart uses the next one.
+     */
+    void setPort(quint16 port) { m_basePort = port; }
+
+    /**
+     * @brief Run every job on one cluster of workers, each computing with threads threads (0: all).
+     */
+    void setMatrix(const QVector<SubmitMsg> &jobs, int workers, int threads) {
+        m_scaling = false;
+        m_jobs.clear();
+        m_stages.clear();
+        BenchStage stage;
+        stage.workers = std::max(1, workers);
+        stage.threads = threads;
+        for (const SubmitMsg &m : jobs) {
+            stage.jobs.push_back(static_cast<int>(m_jobs.size()));
+            BenchJob j;
+            j.msg = m;
+            m_jobs.push_back(j);
+        }
+        m_stages.push_back(stage);
+    }
+
+    /**
+     * @brief Strong and weak scaling of one job over 1..maxWorkers workers and 1, 2, 4, .., maxThreads threads.
+     * @return false if the job cannot be stretched for weak scaling (its interval must lie above x = 1).
+     */
+    bool setScaling(const SubmitMsg &job, int maxWorkers, int maxThreads) {
+        m_scaling = true;
+        m_jobs.clear();
+        m_stages.clear();
+
+        const double lo = std::min(job.a, job.b);
+        const double hi = std::max(job.a, job.b);
+        if (!(lo > 1.0)) {
+            qCritical() << "Scaling job must lie above x = 1 so its interval can be stretched";
+            return false;
+        }
+
+        QVector<int> threadCounts;
+        for (int t = 1; t < maxThreads; t *= 2) {
+            threadCounts.push_back(t);
+        }
+        threadCounts.push_back(std::max(1, maxThreads));
+
+        BenchJob strong;
+        strong.msg = job;
+        strong.msg.a = lo;
+        strong.msg.b = hi;
+        m_jobs.push_back(strong);
+
+        for (const BenchStage::Kind kind : {BenchStage::Kind::Strong, BenchStage::Kind::Weak}) {
+            for (int w = 1; w <= std::max(1, maxWorkers); ++w) {
+                for (const int t : threadCounts) {
+                    BenchStage stage;
+                    stage.kind = kind;
+                    stage.workers = w;
+                    stage.threads = t;
+                    if (kind == BenchStage::Kind::Strong) {
+                        stage.jobs.push_back(0);
+                    } else {
+                        BenchJob weak = strong;
+                        weak.msg.b = lo + (hi - lo) * w * t;
+                        stage.jobs.push_back(static_cast<int>(m_jobs.size()));
+                        m_jobs.push_back(weak);
+                    }
+                    m_stages.push_back(stage);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Run the matrix a second time while injecting faults drawn from seed into the workers.
+     *
+     * Fails the run if a result is wrong or a job's makespan grows by more than maxInflation times.
+     */
+    void setChaos(const ChaosSpec &spec, double maxInflation, quint32 seed) {
+        m_chaos = spec;
+        m_maxInflation = maxInflation;
+        m_faultPlan.emplace(spec, seed);
+        BenchStage faulty = m_stages.front();
+        faulty.chaos = true;
+        m_stages.push_back(faulty);
+    }
+
+    /**
+     * @brief Set how many times each job is run per configuration.
+     */
+    void setRepeat(int repeat) { m_repeat = std::max(1, repeat); }
+
+    /**
+     * @brief Also write results as CSV to path (empty: no CSV).
+     */
+    void setCsvPath(const QString &path) { m_csvPath = path; }
+
+    /**
+     * @brief Forward server and worker logs to stderr.
+     */
+    void setVerbose(bool v) { m_verbose = v; }
+
+    /**
+     * @brief Measure single-core baselines (matrix mode), then start the first cluster.
+     */
+    void start() {
+        if (!m_scaling) {
+            QTextStream out(stdout);
+            for (BenchJob &j : m_jobs) {
+                QElapsedTimer t;
+                t.start();
+                j.reference = Integrator::integrate(j.msg.a, j.msg.b, j.msg.h, j.msg.method);
+                j.baselineMs = static_cast<double>(t.nsecsElapsed()) / 1e6;
+                out << "baseline " << describe(j.msg) << ": " << QString::number(j.baselineMs, 'f', 1) << " ms"
+                    << Qt::endl;
+            }
+        }
+        startStage(0);
+    }
+
+    /**
+     * @brief Process exit code.
+     */
+    int exitCode() const { return m_failed ? 1 : 0; }
+
+private slots:
+    /**
+     * @brief Follow server log to learn when it listens and when all workers have joined.
+     */
+    void onServerLog() {
+        m_serverLog += m_server->readAllStandardError();
+        int nl = 0;
+        while ((nl = m_serverLog.indexOf('\n')) >= 0) {
+            const QString line = QString::fromUtf8(m_serverLog.left(nl));
+            m_serverLog.remove(0, nl + 1);
+            if (m_verbose) {
+                QTextStream(stderr) << "[server] " << line << Qt::endl;
+            }
+            if (line.contains("in service mode")) {
+                if (m_impairment.isEmpty()) {
+                    startWorkers();
+                } else {
+                    startProxy();
+                }
+            } else if (line.contains("HELLO from client")) {
+                if (++m_joined == stage().workers) {
+                    m_socket.connectToHost("127.0.0.1", port());
+                }
+                // A killed or restarted worker has recovered once it is back in the pool.
+                static const QRegularExpression workerId("harness-worker-(\\d+)");
+                const QRegularExpressionMatch match = workerId.match(line);
+                const int worker = match.hasMatch() ? match.captured(1).toInt() - 1 : -1;
+                if (m_openFaults.contains(worker) && m_openFaults.value(worker).kind != FaultKind::Pause) {
+                    finishFault(worker);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Submitter connection is up: start the first job.
+     */
+    void onConnected() {
+        m_startupTimer.stop();
+        m_socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_framed = new FramedSocket(&m_socket, this);
+        connect(m_framed, &FramedSocket::frameReceived, this, &HarnessApp::onFrame);
+        QTextStream(stdout) << "cluster up: " << stage().workers << " workers, "
+                            << (stage().threads > 0 ? QString::number(stage().threads) : QString("all"))
+                            << " threads each"
+                            << (m_impairment.isEmpty() ? QString() : ", through proxy (" + m_impairment + ")")
+                            << Qt::endl;
+        if (stage().chaos) {
+            QTextStream(stdout) << "injecting faults" << Qt::endl;
+            m_chaosClock.start();
+            scheduleFault();
+        }
+        submitNext();
+    }
+
+    /**
+     * @brief Job result handler.
+     */
+    void onFrame(const QByteArray &payload) {
+        const auto pm = parseMessage(payload);
+        if (!pm.ok || pm.env.type != MessageType::JobResult) {
+            qWarning() << "Unexpected message from server";
+            return;
+        }
+        const JobResultMsg &r = pm.jobResult;
+        const int job = stage().jobs[m_current / m_repeat];
+        if (r.status != JobStatus::Ok) {
+            fail("job " + describe(m_jobs[job].msg) + " " + jobStatusName(r.status) + ": " + r.error);
+            return;
+        }
+        if (!m_scaling && !sameResult(m_jobs[job].reference, r.value)) {
+            qWarning() << "Wrong result for" << describe(m_jobs[job].msg) << ":" << r.value << "instead of"
+                       << m_jobs[job].reference;
+            ++m_wrongResults;
+        }
+
+        BenchRow row;
+        row.stage = m_stage;
+        row.job = job;
+        row.run = m_current % m_repeat;
+        row.makespanMs = static_cast<double>(m_jobTimer.nsecsElapsed()) / 1e6;
+        row.result = r;
+        m_rows.push_back(row);
+
+        ++m_current;
+        submitNext();
+    }
+
+private:
+    const BenchStage &stage() const { return m_stages[m_stage]; }
+
+    quint16 port() const { return static_cast<quint16>(m_basePort + m_stage); }
+
+    quint16 workerPort() const {
+        return m_impairment.isEmpty() ? port() : static_cast<quint16>(port() + kProxyPortOffset);
+    }
+
+    int threadsPerWorker(const BenchStage &s) const {
+        return (s.threads > 0) ? s.threads : std::max(1, QThread::idealThreadCount());
+    }
+
+    void startStage(int index) {
+        m_stage = index;
+        m_current = 0;
+        m_joined = 0;
+        m_serverLog.clear();
+        m_stopping = false;
+
+        m_startupTimer.start(kStartupTimeoutMs);
+        m_server = new QProcess(this);
+        m_server->setProcessChannelMode(QProcess::SeparateChannels);
+        m_server->setStandardOutputFile(QProcess::nullDevice());
+        connect(m_server, &QProcess::readyReadStandardError, this, &HarnessApp::onServerLog);
+        connect(m_server, &QProcess::finished, this, [this]() {
+            if (!m_stopping) {
+                fail("server exited");
+            }
+        });
+        // Each configuration gets its own port, so a restart never waits for the previous listener to go away.
+        m_server->start(m_serverProgram,
+                        {"--service", "--port", QString::number(port()), "--no-profiles", "--max-queue-delay", "0"});
+    }
+
+    /**
+     * @brief Hit a random worker that is up with the next fault of the plan, then schedule the one after.
+     */
+    void injectFault() {
+        if (m_stopping || !stage().chaos) {
+            return;
+        }
+        QVector<int> up;
+        for (int i = 0; i < m_clients.size(); ++i) {
+            if (m_clients[i] && m_clients[i]->state() == QProcess::Running && !m_openFaults.contains(i)) {
+                up.push_back(i);
+            }
+        }
+        if (!up.isEmpty()) {
+            const int i = up[m_faultPlan->pick(static_cast<int>(up.size()))];
+            QProcess *p = m_clients[i];
+            m_openFaults.insert(i, OpenFault{m_pendingFault, m_chaosClock.elapsed()});
+            ++m_injected[m_pendingFault];
+            if (m_verbose) {
+                QTextStream(stderr) << "[chaos] " << faultKindName(m_pendingFault) << " harness-worker-" << i + 1
+                                    << Qt::endl;
+            }
+            switch (m_pendingFault) {
+            case FaultKind::Kill:
+                p->kill();
+                break;
+            case FaultKind::Restart:
+                p->terminate();
+                break;
+            case FaultKind::Pause:
+#ifdef Q_OS_UNIX
+                ::kill(static_cast<pid_t>(p->processId()), SIGSTOP);
+                QTimer::singleShot(static_cast<int>(m_chaos.pauseMs), this, [this, i, p]() { resumeWorker(i, p); });
+#endif
+                break;
+            }
+        }
+        scheduleFault();
+    }
+
+    void scheduleFault() {
+        const FaultEvent next = m_faultPlan->next();
+        m_pendingFault = next.kind;
+        m_faultTimer.start(static_cast<int>(next.delayMs));
+    }
+
+    void resumeWorker(int i, QProcess *p) {
+        if (m_clients.value(i) != p || !m_openFaults.contains(i)) {
+            return;
+        }
+#ifdef Q_OS_UNIX
+        ::kill(static_cast<pid_t>(p->processId()), SIGCONT);
+#endif
+        finishFault(i);
+    }
+
+    void finishFault(int i) {
+        const OpenFault f = m_openFaults.take(i);
+        m_recovery[f.kind].add(static_cast<double>(m_chaosClock.elapsed() - f.startMs));
+    }
+
+    /**
+     * @brief Start the impairment proxy in front of the server; workers start once it listens.
+     */
+    void startProxy() {
+        m_proxy = new QProcess(this);
+        m_proxy->setProcessChannelMode(QProcess::SeparateChannels);
+        m_proxy->setStandardOutputFile(QProcess::nullDevice());
+        connect(m_proxy, &QProcess::readyReadStandardError, this, [this]() {
+            const QByteArray log = m_proxy->readAllStandardError();
+            if (m_verbose) {
+                QTextStream(stderr) << "[proxy] " << QString::fromUtf8(log.trimmed()) << Qt::endl;
+            }
+            if (!m_proxyUp && log.contains("Proxy listening")) {
+                m_proxyUp = true;
+                startWorkers();
+            }
+        });
+        connect(m_proxy, &QProcess::finished, this, [this]() {
+            if (!m_stopping) {
+                fail("proxy exited");
+            }
+        });
+        m_proxyUp = false;
+        m_proxy->start(m_proxyProgram, {"--listen", QString::number(workerPort()), "--target",
+                                        "127.0.0.1:" + QString::number(port()), "--impair", m_impairment, "--seed",
+                                        QString::number(m_basePort + m_stage)});
+    }
+
+    void startWorkers() {
+        m_clients.resize(stage().workers);
+        for (int i = 0; i < stage().workers; ++i) {
+            startWorker(i);
+        }
+    }
+
+    void startWorker(int i) {
+        auto *p = new QProcess(this);
+        p->setProcessChannelMode(m_verbose ? QProcess::ForwardedChannels : QProcess::SeparateChannels);
+        if (!m_verbose) {
+            p->setStandardOutputFile(QProcess::nullDevice());
+            p->setStandardErrorFile(QProcess::nullDevice());
+        }
+        QStringList args{"--host", "127.0.0.1", "--port", QString::number(workerPort()), "--id",
+                         "harness-worker-" + QString::number(i + 1)};
+        if (stage().threads > 0) {
+            args << "--threads" << QString::number(stage().threads);
+        }
+        if (!m_impairment.isEmpty() || stage().chaos) {
+            // A worker exits when its connection is cut or it is killed; start it again like a supervisor
+            // would, so the server's requeue and rejoin path is part of the measurement.
+            connect(p, &QProcess::finished, this, [this, i, p]() {
+                if (m_stopping || m_clients.value(i) != p) {
+                    return;
+                }
+                const bool injected = m_openFaults.contains(i);
+                if (!injected) {
+                    ++m_rejoins;
+                }
+                m_clients[i] = nullptr;
+                p->deleteLater();
+                const int stageIndex = m_stage;
+                QTimer::singleShot(injected ? static_cast<int>(m_chaos.restartDelayMs) : 0, this,
+                                   [this, i, stageIndex]() {
+                                       if (!m_stopping && m_stage == stageIndex) {
+                                           startWorker(i);
+                                       }
+                                   });
+            });
+        }
+        p->start(m_clientProgram, args);
+        m_clients[i] = p;
+    }
+
+    void submitNext() {
+        if (m_current >= static_cast<int>(stage().jobs.size()) * m_repeat) {
+            stopCluster();
+            if (m_stage + 1 < static_cast<int>(m_stages.size())) {
+                startStage(m_stage + 1);
+                return;
+            }
+            if (m_scaling) {
+                reportScaling();
+            } else {
+                reportMatrix();
+            }
+            m_done = true;
+            QCoreApplication::exit(exitCode());
+            return;
+        }
+        SubmitMsg m = m_jobs[stage().jobs[m_current / m_repeat]].msg;
+        m.requestId = static_cast<quint64>(m_current + 1);
+        m.tenant = "harness";
+        m.priority = JobPriority::Interactive;
+        m_jobTimer.start();
+        m_framed->sendFrame(serializeSubmit(m));
+    }
+
+    static QString describe(const SubmitMsg &m) {
+        return methodName(m.method) + " [" + QString::number(m.a) + "," + QString::number(m.b) +
+               "] h=" + QString::number(m.h);
+    }
+
+    static QString workersField(const JobResultMsg &r) {
+        QStringList parts;
+        for (auto it = r.workerComputeMs.cbegin(); it != r.workerComputeMs.cend(); ++it) {
+            parts << it.key() + "=" + QString::number(it.value(), 'f', 1);
+        }
+        return parts.join(';');
+    }
+
+    /**
+     * @brief Effective integrand evaluations per second of compute time, in millions, per worker.
+     */
+    static QString evalRateField(const JobResultMsg &r) {
+        QStringList parts;
+        for (auto it = r.workerEvaluations.cbegin(); it != r.workerEvaluations.cend(); ++it) {
+            const double ms = r.workerComputeMs.value(it.key());
+            const double rate = (ms > 0.0) ? static_cast<double>(it.value()) / ms / 1e3 : 0.0;
+            parts << it.key() + "=" + QString::number(rate, 'f', 1);
+        }
+        return parts.join(';');
+    }
+
+    bool openCsv(QFile &csv, QTextStream &csvOut, const char *header) const {
+        if (m_csvPath.isEmpty()) {
+            return false;
+        }
+        if (!csv.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << "Cannot write" << m_csvPath;
+            return false;
+        }
+        csvOut << header << "\n";
+        return true;
+    }
+
+    void reportMatrix() {
+        const BenchStage &s = m_stages.front();
+        const int threads = s.workers * threadsPerWorker(s);
+
+        QTextStream out(stdout);
+        out << Qt::endl
+            << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+                   .arg("job", -44)
+                   .arg("run", 4)
+                   .arg("makespan", 10)
+                   .arg("dispatch", 9)
+                   .arg("compute", 10)
+                   .arg("network", 9)
+                   .arg("units", 6)
+                   .arg("baseline", 10)
+                   .arg("speedup", 8)
+                   .arg("eff", 6)
+            << Qt::endl;
+
+        QFile csv(m_csvPath);
+        QTextStream csvOut(&csv);
+        const bool writeCsv = openCsv(csv, csvOut,
+                                      "method,a,b,h,run,workers,threads,makespan_ms,dispatch_ms,compute_ms,"
+                                      "network_ms,units,baseline_ms,speedup,efficiency,cpu_ms,evaluations,"
+                                      "worker_compute_ms,worker_meval_per_s,chaos,requeued_units,requeued_steps");
+
+        for (const BenchRow &row : m_rows) {
+            const BenchJob &j = m_jobs[row.job];
+            const JobResultMsg &r = row.result;
+            const double speedup = (row.makespanMs > 0.0) ? j.baselineMs / row.makespanMs : 0.0;
+            const double eff = speedup / threads;
+            const bool chaos = m_stages[row.stage].chaos;
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+                       .arg(describe(j.msg) + (chaos ? " chaos" : ""), -44)
+                       .arg(row.run + 1, 4)
+                       .arg(row.makespanMs, 10, 'f', 1)
+                       .arg(r.dispatchMs, 9)
+                       .arg(r.computeMs, 10, 'f', 1)
+                       .arg(r.networkMs, 9, 'f', 1)
+                       .arg(r.units, 6)
+                       .arg(j.baselineMs, 10, 'f', 1)
+                       .arg(speedup, 8, 'f', 2)
+                       .arg(eff, 6, 'f', 2)
+                << Qt::endl;
+            out << "    per worker compute ms: " << workersField(r) << Qt::endl;
+            out << "    per worker Meval/s: " << evalRateField(r) << ", cpu " << QString::number(r.cpuMs, 'f', 1)
+                << " ms" << Qt::endl;
+            if (writeCsv) {
+                csvOut << methodName(j.msg.method) << ',' << j.msg.a << ',' << j.msg.b << ',' << j.msg.h << ','
+                       << row.run + 1 << ',' << s.workers << ',' << threads << ',' << row.makespanMs << ','
+                       << r.dispatchMs << ',' << r.computeMs << ',' << r.networkMs << ',' << r.units << ','
+                       << j.baselineMs << ',' << speedup << ',' << eff << ',' << r.cpuMs << ',' << r.evaluations
+                       << ",\"" << workersField(r) << "\",\"" << evalRateField(r) << "\"," << (chaos ? 1 : 0) << ','
+                       << r.requeuedUnits << ',' << r.requeuedSteps << '\n';
+            }
+        }
+        out << "times in ms; network = unit round trips minus compute; eff = speedup / " << threads
+            << " worker threads" << Qt::endl;
+        reportImpairment(out);
+        if (m_faultPlan) {
+            reportChaos(out);
+        }
+    }
+
+    /**
+     * @brief Compare the run under faults with the clean run: makespan inflation, redone work, recovery times.
+     */
+    void reportChaos(QTextStream &out) {
+        out << Qt::endl
+            << QString("%1 %2 %3 %4 %5 %6")
+                   .arg("job", -44)
+                   .arg("clean", 10)
+                   .arg("chaos", 10)
+                   .arg("inflation", 10)
+                   .arg("requeued", 9)
+                   .arg("redone", 7)
+            << Qt::endl;
+
+        bool inflated = false;
+        for (int job = 0; job < m_jobs.size(); ++job) {
+            double cleanMs = 0.0;
+            double chaosMs = 0.0;
+            quint64 requeuedUnits = 0;
+            quint64 requeuedSteps = 0;
+            for (const BenchRow &row : m_rows) {
+                if (row.job != job) {
+                    continue;
+                }
+                if (m_stages[row.stage].chaos) {
+                    chaosMs += row.makespanMs / m_repeat;
+                    requeuedUnits += row.result.requeuedUnits;
+                    requeuedSteps += row.result.requeuedSteps;
+                } else {
+                    cleanMs += row.makespanMs / m_repeat;
+                }
+            }
+            const SubmitMsg &m = m_jobs[job].msg;
+            const double steps = std::fabs(m.b - m.a) / m.h * m_repeat;
+            const double inflation = (cleanMs > 0.0) ? chaosMs / cleanMs : 0.0;
+            inflated = inflated || inflation > m_maxInflation;
+            out << QString("%1 %2 %3 %4 %5 %6")
+                       .arg(describe(m), -44)
+                       .arg(cleanMs, 10, 'f', 1)
+                       .arg(chaosMs, 10, 'f', 1)
+                       .arg(inflation, 10, 'f', 2)
+                       .arg(requeuedUnits, 9)
+                       .arg(QString::number(100.0 * static_cast<double>(requeuedSteps) / steps, 'f', 1) + "%", 7)
+                << Qt::endl;
+        }
+        out << "mean makespan in ms; requeued = units lost with a worker and computed again; redone = their share of "
+               "the job's steps"
+            << Qt::endl;
+
+        for (const auto &[kind, count] : m_injected) {
+            const RecoveryStats &r = m_recovery[kind];
+            out << "faults " << faultKindName(kind) << ": " << count << " injected, " << r.count
+                << " recovered in mean " << QString::number(r.meanMs(), 'f', 0) << " ms, max "
+                << QString::number(r.maxMs, 'f', 0) << " ms" << Qt::endl;
+        }
+        out << "recovery: kill and restart until the worker is back in the pool, pause until it is resumed"
+            << Qt::endl;
+
+        if (m_wrongResults > 0) {
+            out << "FAILED: " << m_wrongResults << " wrong results" << Qt::endl;
+            m_failed = true;
+        }
+        if (inflated) {
+            out << "FAILED: makespan grew more than " << m_maxInflation << " times under faults" << Qt::endl;
+            m_failed = true;
+        }
+        if (!m_failed) {
+            out << "PASSED: all results correct, makespan inflation within " << m_maxInflation << " times"
+                << Qt::endl;
+        }
+    }
+
+    /**
+     * @brief Mean makespan of a stage over its repeats.
+     */
+    double stageTime(int stageIndex) const {
+        double sum = 0.0;
+        int n = 0;
+        for (const BenchRow &row : m_rows) {
+            if (row.stage == stageIndex) {
+                sum += row.makespanMs;
+                ++n;
+            }
+        }
+        return (n > 0) ? sum / n : 0.0;
+    }
+
+    void reportScaling() {
+        QTextStream out(stdout);
+        out << Qt::endl
+            << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+                   .arg("mode", -7)
+                   .arg("workers", 8)
+                   .arg("threads", 8)
+                   .arg("p", 5)
+                   .arg("b", 10)
+                   .arg("time_ms", 11)
+                   .arg("speedup", 8)
+                   .arg("eff", 6)
+                   .arg("serial", 8)
+            << Qt::endl;
+
+        QFile csv(m_csvPath);
+        QTextStream csvOut(&csv);
+        const bool writeCsv =
+            openCsv(csv, csvOut, "mode,workers,threads,p,a,b,h,method,time_ms,speedup,efficiency,serial_fraction");
+
+        // Reference of each mode is its 1 worker x 1 thread run, which is the first stage of the mode.
+        double t1 = 0.0;
+        for (int i = 0; i < static_cast<int>(m_stages.size()); ++i) {
+            const BenchStage &s = m_stages[i];
+            const bool strong = (s.kind == BenchStage::Kind::Strong);
+            const int p = s.workers * threadsPerWorker(s);
+            const double tp = stageTime(i);
+            if (p == 1) {
+                t1 = tp;
+            }
+            const ScalingMetrics m = strong ? strongScaling(t1, tp, p) : weakScaling(t1, tp, p);
+            const SubmitMsg &job = m_jobs[s.jobs.front()].msg;
+            const QString mode = strong ? "strong" : "weak";
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+                       .arg(mode, -7)
+                       .arg(s.workers, 8)
+                       .arg(threadsPerWorker(s), 8)
+                       .arg(p, 5)
+                       .arg(job.b, 10, 'g', 6)
+                       .arg(tp, 11, 'f', 1)
+                       .arg(m.speedup, 8, 'f', 2)
+                       .arg(m.efficiency, 6, 'f', 2)
+                       .arg(std::isnan(m.serialFraction) ? QString("-") : QString::number(m.serialFraction, 'f', 4), 8)
+                << Qt::endl;
+            if (writeCsv) {
+                csvOut << mode << ',' << s.workers << ',' << threadsPerWorker(s) << ',' << p << ',' << job.a << ','
+                       << job.b << ',' << job.h << ',' << methodName(job.method) << ',' << tp << ',' << m.speedup
+                       << ',' << m.efficiency << ',';
+                if (!std::isnan(m.serialFraction)) {
+                    csvOut << m.serialFraction;
+                }
+                csvOut << "\n";
+            }
+        }
+        out << "p = workers x threads; strong: same job, serial = Karp-Flatt; weak: interval stretched by p, "
+               "speedup = p * t1 / tp, serial = Gustafson"
+            << Qt::endl;
+        reportImpairment(out);
+    }
+
+    void reportImpairment(QTextStream &out) const {
+        if (!m_impairment.isEmpty()) {
+            out << "workers connected through proxy: " << m_impairment << "; " << m_rejoins
+                << " workers restarted after their connection was cut" << Qt::endl;
+        }
+    }
+
+    void fail(const QString &why) {
+        if (m_done) {
+            return;
+        }
+        qCritical() << "Harness failed:" << why;
+        m_failed = true;
+        m_done = true;
+        stopCluster();
+        QCoreApplication::exit(1);
+    }
+
+    void stopCluster() {
+        m_stopping = true;
+        m_startupTimer.stop();
+        m_faultTimer.stop();
+#ifdef Q_OS_UNIX
+        // Stopped workers would not see SIGTERM.
+        for (auto it = m_openFaults.cbegin(); it != m_openFaults.cend(); ++it) {
+            if (it.value().kind == FaultKind::Pause && m_clients.value(it.key())) {
+                ::kill(static_cast<pid_t>(m_clients[it.key()]->processId()), SIGCONT);
+            }
+        }
+#endif
+        m_openFaults.clear();
+        m_socket.abort();
+        if (m_framed) {
+            m_framed->deleteLater();
+            m_framed = nullptr;
+        }
+        for (QProcess *p : m_clients) {
+            if (p) {
+                p->terminate();
+            }
+        }
+        if (m_proxy) {
+            m_proxy->terminate();
+            if (!m_proxy->waitForFinished(5000)) {
+                m_proxy->kill();
+            }
+            m_proxy->deleteLater();
+            m_proxy = nullptr;
+        }
+        if (m_server) {
+            m_server->terminate();
+            if (!m_server->waitForFinished(5000)) {
+                m_server->kill();
+            }
+            m_server->deleteLater();
+        }
+        // Workers exit on their own once the server is gone.
+        for (QProcess *p : m_clients) {
+            if (!p) {
+                continue;
+            }
+            if (!p->waitForFinished(5000)) {
+                p->kill();
+            }
+            p->deleteLater();
+        }
+        m_clients.clear();
+        m_server = nullptr;
+    }
+
+    QString m_serverProgram;
+    QString m_clientProgram;
+    QString m_proxyProgram;
+    QString m_impairment;
+    quint16 m_basePort = 17777;
+    int m_repeat = 1;
+    bool m_scaling = false;
+    QVector<BenchJob> m_jobs;
+    QVector<BenchStage> m_stages;
+    QString m_csvPath;
+    bool m_verbose = false;
+
+    int m_stage = 0;
+    QProcess *m_server = nullptr;
+    QVector<QProcess *> m_clients;
+    QProcess *m_proxy = nullptr;
+    bool m_proxyUp = false;
+    int m_rejoins = 0;
+
+    /**
+     * @brief Fault a worker is in, from injection until it is back.
+     */
+    struct OpenFault {
+        FaultKind kind = FaultKind::Kill;
+        qint64 startMs = 0;
+    };
+
+    ChaosSpec m_chaos;
+    double m_maxInflation = 3.0;
+    std::optional<FaultPlan> m_faultPlan;
+    FaultKind m_pendingFault = FaultKind::Kill;
+    QTimer m_faultTimer;
+    QElapsedTimer m_chaosClock;
+    QHash<int, OpenFault> m_openFaults;
+    std::map<FaultKind, int> m_injected;
+    std::map<FaultKind, RecoveryStats> m_recovery;
+    int m_wrongResults = 0;
+    QByteArray m_serverLog;
+    int m_joined = 0;
+    QTimer m_startupTimer;
+    bool m_stopping = false;
+
+    QTcpSocket m_socket;
+    FramedSocket *m_framed = nullptr;
+    int m_current = 0;
+    QElapsedTimer m_jobTimer;
+    QVector<BenchRow> m_rows;
+    bool m_done = false;
+    bool m_failed = false;
+};
+
+} // namespace netproj
+
+#include "harness_main.moc"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = QCoreApplication::arguments();
+    const QDir here(QCoreApplication::applicationDirPath());
+
+    QString server = here.filePath("net_server");
+    QString client = here.filePath("net_client");
+    QString proxy = here.filePath("net_proxy");
+    QString impair;
+    QString chaos;
+    double maxInflation = 3.0;
+    quint32 seed = 1;
+    quint16 port = 17777;
+    int workers = 2;
+    int threads = 0;
+    int maxWorkers = 4;
+    int maxThreads = std::max(1, QThread::idealThreadCount());
+    int repeat = 1;
+    QString csv;
+    QStringList jobLines;
+
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        if (opt == "--server") {
+            server = val;
+        } else if (opt == "--client") {
+            client = val;
+        } else if (opt == "--proxy") {
+            proxy = val;
+        } else if (opt == "--impair") {
+            impair = val;
+        } else if (opt == "--chaos") {
+            chaos = val;
+        } else if (opt == "--max-inflation") {
+            maxInflation = val.toDouble();
+        } else if (opt == "--seed") {
+            seed = val.toUInt();
+        } else if (opt == "--port") {
+            port = val.toUShort();
+        } else if (opt == "--workers") {
+            workers = val.toInt();
+        } else if (opt == "--threads") {
+            threads = val.toInt();
+        } else if (opt == "--max-workers") {
+            maxWorkers = val.toInt();
+        } else if (opt == "--max-threads") {
+            maxThreads = val.toInt();
+        } else if (opt == "--repeat") {
+            repeat = val.toInt();
+        } else if (opt == "--csv") {
+            csv = val;
+        } else if (opt == "--job") {
+            jobLines.push_back(val);
+        } else {
+            continue;
+        }
+        ++i;
+    }
+
+    const bool scaling = args.contains("--scaling");
+    if (port == 0 || workers <= 0 || threads < 0 || maxWorkers <= 0 || maxThreads <= 0 || repeat <= 0) {
+        qCritical() << "Invalid --port, --workers, --threads, --max-workers, --max-threads or --repeat";
+        return 1;
+    }
+    if (!impair.isEmpty()) {
+        netproj::ImpairmentSpec spec;
+        QString error;
+        if (!netproj::parseImpairment(impair, &spec, &error)) {
+            qCritical() << "Invalid --impair:" << error;
+            return 1;
+        }
+        if (port > 65535 - netproj::kProxyPortOffset - 256) {
+            qCritical() << "--port too high to leave room for the proxy ports above it";
+            return 1;
+        }
+    }
+    netproj::ChaosSpec chaosSpec;
+    if (!chaos.isEmpty()) {
+        QString error;
+        if (!netproj::parseChaos(chaos, &chaosSpec, &error)) {
+            qCritical() << "Invalid --chaos:" << error;
+            return 1;
+        }
+        if (scaling) {
+            qCritical() << "--chaos runs the job matrix and cannot be combined with --scaling";
+            return 1;
+        }
+        if (!(maxInflation >= 1.0)) {
+            qCritical() << "Invalid --max-inflation (must be at least 1)";
+            return 1;
+        }
+#ifndef Q_OS_UNIX
+        if (chaosSpec.pauseEveryMs > 0.0) {
+            qCritical() << "pause faults need SIGSTOP and are not available on this system";
+            return 1;
+        }
+#endif
+    }
+    if (jobLines.isEmpty()) {
+        if (scaling) {
+            jobLines.push_back("2 10 1e-7 3");
+        } else {
+            for (const char *h : {"1e-6", "1e-7"}) {
+                for (int method = 1; method <= 3; ++method) {
+                    jobLines.push_back(QString("2 10 %1 %2").arg(h).arg(method));
+                }
+            }
+        }
+    }
+
+    QVector<netproj::SubmitMsg> jobs;
+    for (const QString &line : jobLines) {
+        netproj::SubmitMsg m;
+        QString error;
+        if (!netproj::parseJobLine(line, &m, &error)) {
+            qCritical() << "Invalid --job" << line << ":" << error;
+            return 1;
+        }
+        try {
+            netproj::Integrator::validate(m.a, m.b, m.h);
+        } catch (const std::exception &e) {
+            qCritical() << "Invalid --job" << line << ":" << e.what();
+            return 1;
+        }
+        jobs.push_back(m);
+    }
+
+    netproj::HarnessApp harness;
+    harness.setPrograms(server, client);
+    harness.setImpairment(proxy, impair);
+    harness.setPort(port);
+    harness.setRepeat(repeat);
+    harness.setCsvPath(csv);
+    harness.setVerbose(args.contains("--verbose"));
+    if (scaling) {
+        if (!harness.setScaling(jobs.front(), maxWorkers, maxThreads)) {
+            return 1;
+        }
+    } else {
+        harness.setMatrix(jobs, workers, threads);
+        if (!chaos.isEmpty()) {
+            harness.setChaos(chaosSpec, maxInflation, seed);
+        }
+    }
+    harness.start();
+
+    return app.exec();
+}
@@ -0,0 +1,36 @@
+#include "scaling.h"
+
+#include <limits>
+
+namespace netproj {
+
+ScalingMetrics strongScaling(double t1, double tp, int p) {
+    ScalingMetrics m;
+    m.serialFraction = std::numeric_limits<double>::quiet_NaN();
+    if (!(t1 > 0.0) || !(tp > 0.0) || p < 1) {
+        return m;
+    }
+    m.speedup = t1 / tp;
+    m.efficiency = m.speedup / p;
+    if (p > 1) {
+        const double inv = 1.0 / p;
+        m.serialFraction = (1.0 / m.speedup - inv) / (1.0 - inv);
+    }
+    return m;
+}
+
+ScalingMetrics weakScaling(double t1, double tp, int p) {
+    ScalingMetrics m;
+    m.serialFraction = std::numeric_limits<double>::quiet_NaN();
+    if (!(t1 > 0.0) || !(tp > 0.0) || p < 1) {
+        return m;
+    }
+    m.speedup = p * t1 / tp;
+    m.efficiency = m.speedup / p;
+    if (p > 1) {
+        m.serialFraction = (p - m.speedup) / (p - 1);
+    }
+    return m;
+}
+
+} // namespace netproj
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace netproj {
+
+/**
+ * @brief Derived scaling figures of one measurement against the single-worker, single-thread run.
+ */
+struct ScalingMetrics {
+    double speedup = 0.0;        ///< Strong: t1 / tp. Weak: scaled speedup p * t1 / tp.
+    double efficiency = 0.0;     ///< speedup / p.
+    double serialFraction = 0.0; ///< Strong: Karp-Flatt metric. Weak: Gustafson serial fraction. NaN for p = 1.
+};
+
+/**
+ * @brief Strong scaling: the same job on p processing units.
+ *
+ * The serial fraction is the experimentally determined Amdahl fraction e = (1/S - 1/p) / (1 - 1/p).
+ */
+ScalingMetrics strongScaling(double t1, double tp, int p);
+
+/**
+ * @brief Weak scaling: a job p times larger on p processing units.
+ *
+ * Scaled speedup S = p * t1 / tp; the serial fraction follows Gustafson's law S = p - e * (p - 1).
+ */
+ScalingMetrics weakScaling(double t1, double tp, int p);
+
+} // namespace netproj
@@ -0,0 +1,260 @@
+#include "../common/job_file.h"
+#include "../common/job_history.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QStringList>
+#include <QTextStream>
+
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace {
+
+using netproj::JobRecord;
+
+/**
+ * @brief Time from the command line: milliseconds since the epoch or an ISO 8601 date and time.
+ */
+bool parseTime(const QString &s, qint64 *ms) {
+    bool ok = false;
+    *ms = s.toLongLong(&ok);
+    if (ok) {
+        return true;
+    }
+    const QDateTime t = QDateTime::fromString(s, Qt::ISODateWithMs);
+    *ms = t.toMSecsSinceEpoch();
+    return t.isValid();
+}
+
+QString timeString(qint64 ms) {
+    return QDateTime::fromMSecsSinceEpoch(ms).toUTC().toString(Qt::ISODateWithMs);
+}
+
+QString number(double v) {
+    return std::isnan(v) ? QString() : QString::number(v, 'g', 17);
+}
+
+/**
+ * @brief Records as CSV, one row per job; workers as "id:evaluations:compute_ms" separated by ';'.
+ */
+QByteArray recordsCsv(const std::vector<JobRecord> &records) {
+    QString out = "finished,job_id,a,b,h,method,tenant,priority,status,value,error_estimate,elapsed_ms,dispatch_ms,"
+                  "compute_ms,network_ms,cpu_ms,units,evaluations,requeued_units,workers,error\n";
+    for (const JobRecord &r : records) {
+        QStringList workers;
+        for (auto it = r.workerEvaluations.cbegin(); it != r.workerEvaluations.cend(); ++it) {
+            workers << it.key() + ":" + QString::number(it.value()) + ":"
+                           + QString::number(r.workerComputeMs.value(it.key()), 'f', 3);
+        }
+        const QStringList row = {timeString(r.finishedMs),
+                                 QString::number(r.jobId),
+                                 number(r.a),
+                                 number(r.b),
+                                 number(r.h),
+                                 netproj::methodName(r.method),
+                                 netproj::csvField(r.tenant),
+                                 netproj::priorityName(r.priority),
+                                 netproj::jobStatusName(r.status),
+                                 r.status == netproj::JobStatus::Ok ? number(r.value) : QString(),
+                                 number(r.errorEstimate),
+                                 QString::number(r.elapsedMs),
+                                 QString::number(r.dispatchMs),
+                                 QString::number(r.computeMs, 'f', 3),
+                                 QString::number(r.networkMs, 'f', 3),
+                                 QString::number(r.cpuMs, 'f', 3),
+                                 QString::number(r.units),
+                                 QString::number(r.evaluations),
+                                 QString::number(r.requeuedUnits),
+                                 netproj::csvField(workers.join(';')),
+                                 netproj::csvField(r.error)};
+        out += row.join(',') + "\n";
+    }
+    return out.toUtf8();
+}
+
+/**
+ * @brief Records as a JSON array with the fields of the CSV columns; workers as an object by worker id.
+ */
+QByteArray recordsJson(const std::vector<JobRecord> &records) {
+    QJsonArray array;
+    for (const JobRecord &r : records) {
+        QJsonObject workers;
+        for (auto it = r.workerEvaluations.cbegin(); it != r.workerEvaluations.cend(); ++it) {
+            workers.insert(it.key(), QJsonObject{{"evaluations", static_cast<double>(it.value())},
+                                                 {"compute_ms", r.workerComputeMs.value(it.key())}});
+        }
+        QJsonObject o{{"finished", timeString(r.finishedMs)},
+                      {"job_id", static_cast<double>(r.jobId)},
+                      {"a", r.a},
+                      {"b", r.b},
+                      {"h", r.h},
+                      {"method", netproj::methodName(r.method)},
+                      {"tenant", r.tenant},
+                      {"priority", netproj::priorityName(r.priority)},
+                      {"status", netproj::jobStatusName(r.status)},
+                      {"elapsed_ms", static_cast<double>(r.elapsedMs)},
+                      {"dispatch_ms", static_cast<double>(r.dispatchMs)},
+                      {"compute_ms", r.computeMs},
+                      {"network_ms", r.networkMs},
+                      {"cpu_ms", r.cpuMs},
+                      {"units", static_cast<double>(r.units)},
+                      {"evaluations", static_cast<double>(r.evaluations)},
+                      {"requeued_units", static_cast<double>(r.requeuedUnits)},
+                      {"workers", workers}};
+        if (r.status == netproj::JobStatus::Ok) {
+            o.insert("value", r.value);
+        }
+        if (!std::isnan(r.errorEstimate)) {
+            o.insert("error_estimate", r.errorEstimate);
+        }
+        if (!r.error.isEmpty()) {
+            o.insert("error", r.error);
+        }
+        array.append(o);
+    }
+    return QJsonDocument(array).toJson(QJsonDocument::Indented);
+}
+
+/**
+ * @brief Throughput per time bucket of bucketMs: jobs, failures, evaluations, compute and CPU time, and
+ * evaluations per second of compute time; with byWorker one row per bucket and worker instead.
+ */
+QByteArray trendCsv(const std::vector<JobRecord> &records, qint64 bucketMs, bool byWorker) {
+    struct Bucket {
+        quint64 jobs = 0;
+        quint64 failed = 0;
+        quint64 evaluations = 0;
+        double computeMs = 0.0;
+        double cpuMs = 0.0;
+    };
+    QMap<qint64, QMap<QString, Bucket>> buckets;
+    for (const JobRecord &r : records) {
+        const qint64 start = r.finishedMs - ((r.finishedMs % bucketMs) + bucketMs) % bucketMs;
+        QMap<QString, Bucket> &row = buckets[start];
+        if (!byWorker) {
+            Bucket &b = row[QString()];
+            ++b.jobs;
+            b.failed += r.status == netproj::JobStatus::Ok ? 0 : 1;
+            b.evaluations += r.evaluations;
+            b.computeMs += r.computeMs;
+            b.cpuMs += r.cpuMs;
+            continue;
+        }
+        for (auto it = r.workerEvaluations.cbegin(); it != r.workerEvaluations.cend(); ++it) {
+            Bucket &b = row[it.key()];
+            ++b.jobs;
+            b.failed += r.status == netproj::JobStatus::Ok ? 0 : 1;
+            b.evaluations += it.value();
+            b.computeMs += r.workerComputeMs.value(it.key());
+        }
+    }
+
+    QString out = byWorker ? "bucket,worker,jobs,failed,evaluations,compute_ms,mevals_per_s\n"
+                           : "bucket,jobs,failed,evaluations,compute_ms,cpu_ms,mevals_per_s\n";
+    for (auto it = buckets.cbegin(); it != buckets.cend(); ++it) {
+        for (auto w = it.value().cbegin(); w != it.value().cend(); ++w) {
+            const Bucket &b = w.value();
+            const double rate = b.computeMs > 0.0 ? static_cast<double>(b.evaluations) / b.computeMs / 1e3 : 0.0;
+            QStringList row = {timeString(it.key())};
+            if (byWorker) {
+                row << netproj::csvField(w.key());
+            }
+            row << QString::number(b.jobs) << QString::number(b.failed) << QString::number(b.evaluations)
+                << QString::number(b.computeMs, 'f', 3);
+            if (!byWorker) {
+                row << QString::number(b.cpuMs, 'f', 3);
+            }
+            row << QString::number(rate, 'f', 3);
+            out += row.join(',') + "\n";
+        }
+    }
+    return out.toUtf8();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = QCoreApplication::arguments();
+    if (args.size() < 2 || args[1].startsWith("--")) {
+        qCritical() << "Usage: net_history HISTORY [--since TIME] [--until TIME] [--a A --b B] [--h H]"
+                    << "[--method M] [--tenant T] [--status S] [--limit N] [--json] [--trend SEC [--by-worker]]";
+        return 1;
+    }
+
+    netproj::JobHistoryQuery q;
+    std::optional<double> a;
+    std::optional<double> b;
+    qint64 trendMs = 0;
+    for (int i = 2; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        bool ok = true;
+        if (opt == "--since") {
+            ok = parseTime(val, &q.sinceMs);
+        } else if (opt == "--until") {
+            ok = parseTime(val, &q.untilMs);
+        } else if (opt == "--a") {
+            a = val.toDouble(&ok);
+        } else if (opt == "--b") {
+            b = val.toDouble(&ok);
+        } else if (opt == "--h") {
+            q.h = val.toDouble(&ok);
+        } else if (opt == "--method") {
+            netproj::MethodType m = netproj::MethodType::Simpson;
+            ok = netproj::parseMethodName(val, &m);
+            q.method = m;
+        } else if (opt == "--status") {
+            netproj::JobStatus s = netproj::JobStatus::Ok;
+            ok = netproj::parseJobStatus(val, &s);
+            q.status = s;
+        } else if (opt == "--tenant") {
+            q.tenant = val;
+        } else if (opt == "--limit") {
+            q.limit = val.toInt(&ok);
+            ok = ok && q.limit >= 0;
+        } else if (opt == "--trend") {
+            trendMs = static_cast<qint64>(std::llround(val.toDouble(&ok) * 1000.0));
+            ok = ok && trendMs > 0;
+        } else {
+            continue;
+        }
+        if (!ok) {
+            qCritical() << "Invalid" << opt << val;
+            return 1;
+        }
+        ++i;
+    }
+    if (a.has_value() != b.has_value()) {
+        qCritical() << "--a and --b select an interval together";
+        return 1;
+    }
+    if (a) {
+        q.interval = qMakePair(*a, *b);
+    }
+
+    netproj::JobHistory history;
+    if (!history.open(args[1], netproj::JobHistory::Mode::ReadOnly)) {
+        qCritical() << args[1] << ":" << history.error();
+        return 1;
+    }
+    const std::vector<netproj::JobRecord> records = history.query(q);
+
+    QTextStream out(stdout);
+    if (trendMs > 0) {
+        out << trendCsv(records, trendMs, args.contains("--by-worker"));
+    } else if (args.contains("--json")) {
+        out << recordsJson(records);
+    } else {
+        out << recordsCsv(records);
+    }
+    out.flush();
+    return 0;
+}
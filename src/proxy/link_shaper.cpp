@@ -0,0 +1,81 @@
+#include "link_shaper.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+
+namespace netproj {
+
+bool parseSpec(const QString &text, const QHash<QString, double *> &fields, const QString &what, QString *error) {
+    for (const QString &item : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList kv = item.split('=');
+        bool ok = false;
+        const double v = (kv.size() == 2) ? kv[1].trimmed().toDouble(&ok) : 0.0;
+        if (!ok || !(v >= 0.0) || std::isinf(v)) {
+            *error = "invalid " + what + " \"" + item + "\" (expected key=value with value >= 0)";
+            return false;
+        }
+        const QString key = kv[0].trimmed();
+        double *field = fields.value(key);
+        if (!field) {
+            *error = "unknown " + what + " \"" + key + "\"";
+            return false;
+        }
+        *field = v;
+    }
+    return true;
+}
+
+bool parseImpairment(const QString &text, ImpairmentSpec *spec, QString *error) {
+    ImpairmentSpec s;
+    const QHash<QString, double *> fields = {{"delay", &s.delayMs},
+                                             {"jitter", &s.jitterMs},
+                                             {"bandwidth", &s.bandwidthKbps},
+                                             {"stall-every", &s.stallEveryMs},
+                                             {"stall", &s.stallMs},
+                                             {"disconnect-after", &s.disconnectAfterMs}};
+    if (!parseSpec(text, fields, "impairment", error)) {
+        return false;
+    }
+    *spec = s;
+    return true;
+}
+
+double exponentialMs(QRandomGenerator &rng, double meanMs) {
+    // 1 - u lies in (0, 1], so the logarithm is finite.
+    return -meanMs * std::log(1.0 - rng.generateDouble());
+}
+
+LinkShaper::LinkShaper(const ImpairmentSpec &spec, quint32 seed)
+    : m_spec(spec), m_rng(seed) {}
+
+qint64 LinkShaper::schedule(qint64 nowUs, qint64 bytes) {
+    const qint64 sendStartUs = std::max(nowUs, m_linkFreeUs);
+    const qint64 sendUs = (m_spec.bandwidthKbps > 0.0)
+        ? static_cast<qint64>(std::ceil(static_cast<double>(bytes) * 8.0 * 1e3 / m_spec.bandwidthKbps))
+        : 0;
+    m_linkFreeUs = sendStartUs + sendUs;
+
+    const double jitterMs = (m_spec.jitterMs > 0.0) ? m_rng.generateDouble() * m_spec.jitterMs : 0.0;
+    const double latencyMs = m_spec.delayMs + jitterMs;
+    qint64 deliveryUs = std::max(m_linkFreeUs + static_cast<qint64>(latencyMs * 1e3), m_lastDeliveryUs);
+
+    if (m_spec.stallEveryMs > 0.0 && m_spec.stallMs > 0.0) {
+        const qint64 stallUs = static_cast<qint64>(m_spec.stallMs * 1e3);
+        if (m_stallStartUs < 0) {
+            m_stallStartUs = nowUs + static_cast<qint64>(exponentialMs(m_rng, m_spec.stallEveryMs) * 1e3);
+        }
+        // Stalls over before this delivery cannot affect it or any later (never earlier) delivery.
+        while (m_stallStartUs + stallUs <= deliveryUs) {
+            m_stallStartUs += stallUs + static_cast<qint64>(exponentialMs(m_rng, m_spec.stallEveryMs) * 1e3);
+        }
+        if (deliveryUs >= m_stallStartUs) {
+            deliveryUs = m_stallStartUs + stallUs;
+        }
+    }
+    m_lastDeliveryUs = deliveryUs;
+    return deliveryUs;
+}
+
+} // namespace netproj
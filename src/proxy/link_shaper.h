@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QHash>
+#include <QRandomGenerator>
+#include <QString>
+#include <QtGlobal>
+
+namespace netproj {
+
+/**
+ * @brief Network impairment of one proxied connection, applied to each direction separately.
+ */
+struct ImpairmentSpec {
+    double delayMs = 0.0;           ///< One-way latency added to every frame.
+    double jitterMs = 0.0;          ///< Extra latency, uniform in [0, jitterMs] per frame.
+    double bandwidthKbps = 0.0;     ///< Link rate in kbit/s (0: unlimited).
+    double stallEveryMs = 0.0;      ///< Mean time between stalls (exponential; 0: no stalls).
+    double stallMs = 0.0;           ///< Length of a stall, during which nothing is delivered.
+    double disconnectAfterMs = 0.0; ///< Mean connection lifetime before it is cut (exponential; 0: never).
+
+    /**
+     * @brief Whether any impairment is configured.
+     */
+    bool isNone() const {
+        return delayMs <= 0.0 && jitterMs <= 0.0 && bandwidthKbps <= 0.0 && (stallEveryMs <= 0.0 || stallMs <= 0.0) &&
+               disconnectAfterMs <= 0.0;
+    }
+};
+
+/**
+ * @brief Parse a "key=value[,key=value]" spec of numbers >= 0 into the field of each key.
+ *
+ * Keys may be given in any order and any subset; fields of keys not given keep their values.
+ * @param what What an item is called in errors ("impairment", "fault").
+ * @return false (with error set) on unknown keys or invalid values.
+ */
+bool parseSpec(const QString &text, const QHash<QString, double *> &fields, const QString &what, QString *error);
+
+/**
+ * @brief Parse "delay=20,jitter=5,bandwidth=10000,stall-every=2000,stall=300,disconnect-after=60000".
+ *
+ * Keys may be given in any order and any subset; times are in milliseconds, bandwidth in kbit/s.
+ * @return false (with error set) on unknown keys or invalid values.
+ */
+bool parseImpairment(const QString &text, ImpairmentSpec *spec, QString *error);
+
+/**
+ * @brief Draw an exponentially distributed time with the given mean.
+ */
+double exponentialMs(QRandomGenerator &rng, double meanMs);
+
+/**
+ * @brief Decides when each frame of one direction of a connection is delivered.
+ *
+ * A frame leaves after the link has finished sending the frames before it (size / bandwidth) and then takes the
+ * delay plus jitter to arrive. Delivery never reorders frames, as on a TCP connection; a frame that would arrive
+ * during a stall is held until the stall ends.
+ */
+class LinkShaper {
+public:
+    LinkShaper(const ImpairmentSpec &spec, quint32 seed);
+
+    /**
+     * @brief Delivery time of a frame of bytes arriving at nowUs (microseconds on any monotonic clock).
+     */
+    qint64 schedule(qint64 nowUs, qint64 bytes);
+
+private:
+    ImpairmentSpec m_spec;
+    QRandomGenerator m_rng;
+    qint64 m_linkFreeUs = 0;    ///< When the link has sent everything queued so far.
+    qint64 m_lastDeliveryUs = 0;
+    qint64 m_stallStartUs = -1; ///< Start of the next stall (-1: none scheduled yet).
+};
+
+} // namespace netproj
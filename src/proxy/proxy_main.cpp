@@ -0,0 +1,271 @@
+#include "../common/frame_decoder.h"
+#include "link_shaper.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <deque>
+
+namespace netproj {
+
+/**
+ * @brief One proxied connection: a worker or submitter socket and its upstream socket to the server.
+ *
+ * Bytes are cut into frames with FrameDecoder and each frame is held until its direction's LinkShaper delivers it,
+ * so delay, jitter, bandwidth and stalls apply to whole messages and never reorder them. The optional disconnect
+ * cuts both sockets at once, as a failing link or a killed process would.
+ */
+class ProxyConnection : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Proxy client to host:port.
+     * @param clock Shared monotonic clock of the proxy.
+     * @param seed Seed of this connection's random draws (jitter, stalls, disconnect).
+     */
+    ProxyConnection(QTcpSocket *client, const QString &host, quint16 port, const ImpairmentSpec &spec, quint32 seed,
+                    const QElapsedTimer *clock, quint64 id, QObject *parent = nullptr)
+        : QObject(parent), m_clock(clock), m_id(id), m_client(client), m_upstream(new QTcpSocket(this)),
+          m_toServer(spec, seed), m_toClient(spec, seed + 1) {
+        m_client->setParent(this);
+        m_client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_toServer.from = m_client;
+        m_toServer.to = m_upstream;
+        m_toClient.from = m_upstream;
+        m_toClient.to = m_client;
+        for (Direction *d : {&m_toServer, &m_toClient}) {
+            d->timer.setSingleShot(true);
+            d->timer.setTimerType(Qt::PreciseTimer);
+            connect(&d->timer, &QTimer::timeout, this, [this, d]() { release(d); });
+            connect(d->from, &QTcpSocket::readyRead, this, [this, d]() { receive(d); });
+            connect(d->from, &QTcpSocket::disconnected, this, [this, d]() {
+                d->sourceClosed = true;
+                release(d);
+            });
+        }
+        connect(m_upstream, &QTcpSocket::connected, this, [this]() {
+            m_upstream->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            // Bytes the client sent while the upstream was connecting are still in its socket.
+            receive(&m_toServer);
+        });
+        connect(m_upstream, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+            if (m_upstream->state() != QAbstractSocket::ConnectedState && !m_toServer.sourceClosed) {
+                close("upstream " + m_upstream->errorString(), false);
+            }
+        });
+
+        if (spec.disconnectAfterMs > 0.0) {
+            QRandomGenerator rng(seed + 2);
+            const int lifetimeMs = static_cast<int>(std::min(exponentialMs(rng, spec.disconnectAfterMs), 2.0e9));
+            QTimer::singleShot(lifetimeMs, this, [this]() { close("cut by impairment", true); });
+        }
+        m_upstream->connectToHost(host, port);
+    }
+
+private:
+    /**
+     * @brief Frames of one direction waiting for their delivery time.
+     */
+    struct Direction {
+        Direction(const ImpairmentSpec &spec, quint32 seed)
+            : shaper(spec, seed) {}
+
+        QTcpSocket *from = nullptr;
+        QTcpSocket *to = nullptr;
+        FrameDecoder decoder;
+        LinkShaper shaper;
+        std::deque<std::pair<qint64, QByteArray>> pending; ///< Delivery time (us) and encoded frame.
+        QTimer timer;
+        bool sourceClosed = false;
+        quint64 frames = 0;
+        quint64 bytes = 0;
+    };
+
+    qint64 nowUs() const { return m_clock->nsecsElapsed() / 1000; }
+
+    void receive(Direction *d) {
+        if (m_upstream->state() != QAbstractSocket::ConnectedState) {
+            return;
+        }
+        d->decoder.append(d->from->readAll());
+        QByteArray payload;
+        while (d->decoder.next(&payload)) {
+            QByteArray frame = FrameDecoder::encode(payload);
+            const qint64 dueUs = d->shaper.schedule(nowUs(), frame.size());
+            d->pending.emplace_back(dueUs, std::move(frame));
+        }
+        release(d);
+    }
+
+    /**
+     * @brief Write every due frame and arm the timer for the next one.
+     */
+    void release(Direction *d) {
+        const qint64 now = nowUs();
+        while (!d->pending.empty() && d->pending.front().first <= now) {
+            const QByteArray &frame = d->pending.front().second;
+            d->to->write(frame);
+            ++d->frames;
+            d->bytes += static_cast<quint64>(frame.size());
+            d->pending.pop_front();
+        }
+        if (!d->pending.empty()) {
+            d->timer.start(static_cast<int>((d->pending.front().first - now + 999) / 1000));
+            return;
+        }
+        if (d->sourceClosed) {
+            // Like a FIN, the close reaches the other side after the data sent before it.
+            close(d == &m_toServer ? "client closed" : "server closed", false);
+        }
+    }
+
+    /**
+     * @brief Close both sockets; cut drops them at once instead of flushing.
+     *
+     * Without cut, each socket writes out the frames already in its buffer before it closes. The sockets are children
+     * of this connection, so it is deleted only once both are unconnected.
+     */
+    void close(const QString &reason, bool cut) {
+        if (m_closed) {
+            return;
+        }
+        m_closed = true;
+        qInfo() << "Connection" << m_id << reason << "after" << m_toServer.frames << "frames to server and"
+                << m_toClient.frames << "to client";
+        m_toServer.timer.stop();
+        m_toClient.timer.stop();
+        if (cut) {
+            m_client->abort();
+            m_upstream->abort();
+            deleteLater();
+            return;
+        }
+        for (QTcpSocket *s : {m_client, m_upstream}) {
+            connect(s, &QAbstractSocket::stateChanged, this, [this]() { deleteWhenClosed(); });
+            s->disconnectFromHost();
+        }
+        deleteWhenClosed();
+    }
+
+    void deleteWhenClosed() {
+        if (m_client->state() == QAbstractSocket::UnconnectedState
+            && m_upstream->state() == QAbstractSocket::UnconnectedState) {
+            deleteLater();
+        }
+    }
+
+    const QElapsedTimer *m_clock = nullptr;
+    quint64 m_id = 0;
+    QTcpSocket *m_client = nullptr;
+    QTcpSocket *m_upstream = nullptr;
+    Direction m_toServer;
+    Direction m_toClient;
+    bool m_closed = false;
+};
+
+/**
+ * @brief Accepts connections and proxies each of them to the target server.
+ */
+class ProxyApp : public QObject {
+    Q_OBJECT
+public:
+    ProxyApp(const QString &host, quint16 port, const ImpairmentSpec &spec, quint32 seed, QObject *parent = nullptr)
+        : QObject(parent), m_host(host), m_port(port), m_spec(spec), m_seed(seed) {
+        m_clock.start();
+        connect(&m_server, &QTcpServer::newConnection, this, &ProxyApp::onNewConnection);
+    }
+
+    /**
+     * @brief Listen on address:port.
+     */
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost) {
+        if (!m_server.listen(address, port)) {
+            qCritical() << "Cannot listen on port" << port << ":" << m_server.errorString();
+            return false;
+        }
+        qInfo() << "Proxy listening on" << address.toString() << "port" << m_server.serverPort() << "for" << m_host
+                << m_port;
+        return true;
+    }
+
+private slots:
+    void onNewConnection() {
+        while (QTcpSocket *client = m_server.nextPendingConnection()) {
+            ++m_connections;
+            // Three random streams per connection: one per direction and one for the disconnect.
+            new ProxyConnection(client, m_host, m_port, m_spec, m_seed + static_cast<quint32>(m_connections) * 3,
+                                &m_clock, m_connections, this);
+        }
+    }
+
+private:
+    QString m_host;
+    quint16 m_port = 0;
+    ImpairmentSpec m_spec;
+    quint32 m_seed = 0;
+    QTcpServer m_server;
+    QElapsedTimer m_clock;
+    quint64 m_connections = 0;
+};
+
+} // namespace netproj
+
+#include "proxy_main.moc"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = QCoreApplication::arguments();
+    quint16 listenPort = 0;
+    // Anyone who can reach the proxy reaches the target through it, so it serves only this machine by default.
+    QHostAddress listenAddress(QHostAddress::LocalHost);
+    bool addressOk = true;
+    QString target;
+    QString impair;
+    quint32 seed = 1;
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        if (opt == "--listen") {
+            listenPort = val.toUShort();
+        } else if (opt == "--bind") {
+            addressOk = listenAddress.setAddress(val);
+        } else if (opt == "--target") {
+            target = val;
+        } else if (opt == "--impair") {
+            impair = val;
+        } else if (opt == "--seed") {
+            seed = val.toUInt();
+        } else {
+            continue;
+        }
+        ++i;
+    }
+
+    const int colon = target.lastIndexOf(':');
+    const QString host = (colon > 0) ? target.left(colon) : QString();
+    const quint16 port = (colon > 0) ? target.mid(colon + 1).toUShort() : 0;
+    if (listenPort == 0 || !addressOk || host.isEmpty() || port == 0) {
+        qCritical() << "Usage: net_proxy --listen PORT [--bind ADDR] --target HOST:PORT [--impair SPEC] [--seed N]";
+        qCritical() << "SPEC: delay=MS,jitter=MS,bandwidth=KBPS,stall-every=MS,stall=MS,disconnect-after=MS";
+        return 1;
+    }
+    netproj::ImpairmentSpec spec;
+    QString error;
+    if (!netproj::parseImpairment(impair, &spec, &error)) {
+        qCritical() << "Invalid --impair:" << error;
+        return 1;
+    }
+
+    netproj::ProxyApp proxy(host, port, spec, seed);
+    if (!proxy.listen(listenPort, listenAddress)) {
+        return 1;
+    }
+    return app.exec();
+}
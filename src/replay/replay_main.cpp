@@ -0,0 +1,313 @@
+#include "../common/async_log.h"
+#include "../common/framed_socket.h"
+#include "../common/message_io.h"
+#include "../common/session_log.h"
+#include "../server/server_app.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief Replays a recorded session (server --record) against an in-process ServerApp.
+ *
+ * Every recorded connection is opened again over loopback and its inbound frames (HELLO, RESULT, SUBMIT, ...) are
+ * sent in recorded order, either at the recorded times or as fast as possible. Causality is kept per connection:
+ * a frame is only sent once the server has sent as many frames on that connection as it had in the recording at
+ * that point, so a RESULT never overtakes the TASK it answers. If the server diverges and the expected frames do
+ * not come, the replay waits for the stall timeout and then sends anyway. Frames the server sends are compared by
+ * message type with the recording.
+ */
+class ReplayApp : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Replay records against server.
+     * @param maxSpeed Ignore recorded times and only respect causality.
+     * @param stallMs How long to wait for expected server frames before sending anyway.
+     */
+    ReplayApp(ServerApp *server, std::vector<SessionRecord> records, bool maxSpeed, int stallMs,
+              QObject *parent = nullptr)
+        : QObject(parent), m_server(server), m_records(std::move(records)), m_maxSpeed(maxSpeed), m_stallMs(stallMs) {
+        m_waitTimer.setSingleShot(true);
+        connect(&m_waitTimer, &QTimer::timeout, this, &ReplayApp::step);
+        m_stallTimer.setSingleShot(true);
+        connect(&m_stallTimer, &QTimer::timeout, this, [this]() {
+            ++m_stalls;
+            m_force = true;
+            step();
+        });
+    }
+
+public slots:
+    /**
+     * @brief Start replaying.
+     */
+    void start() {
+        for (const SessionRecord &r : m_records) {
+            if (r.event == SessionEvent::Out) {
+                m_links[r.connection].recordedTypes.push_back(envelopeType(r.payload));
+                ++m_recordedOut;
+            }
+            if (r.event == SessionEvent::In) {
+                ++m_recordedIn;
+            }
+        }
+        m_recordedUs = m_records.empty() ? 0 : m_records.back().timeUs;
+        m_clock.start();
+        step();
+    }
+
+private slots:
+    /**
+     * @brief Handle as many records as are due and not blocked.
+     */
+    void step() {
+        while (m_next < m_records.size()) {
+            const SessionRecord &r = m_records[m_next];
+            if (!m_maxSpeed) {
+                const qint64 waitUs = r.timeUs - m_clock.nsecsElapsed() / 1000;
+                if (waitUs > 0) {
+                    m_waitTimer.start(static_cast<int>((waitUs + 999) / 1000));
+                    return;
+                }
+            }
+            Link &link = m_links[r.connection];
+            if (r.event == SessionEvent::Out) {
+                ++link.expected;
+                ++m_next;
+                continue;
+            }
+            if (r.event == SessionEvent::Open) {
+                open(r.connection);
+                ++m_next;
+                continue;
+            }
+            if (!link.socket) {
+                // Opened before the recording started: nothing to replay it on.
+                ++m_next;
+                continue;
+            }
+            if (!link.ready(m_force)) {
+                if (!m_stallTimer.isActive()) {
+                    m_stallTimer.start(m_stallMs);
+                }
+                return;
+            }
+            m_stallTimer.stop();
+            m_force = false;
+            if (r.event == SessionEvent::In) {
+                link.framed->sendFrame(r.payload);
+                ++m_sent;
+            } else {
+                link.socket->disconnectFromHost();
+            }
+            ++m_next;
+        }
+        maybeFinish();
+    }
+
+private:
+    /**
+     * @brief Client side of one recorded connection.
+     */
+    struct Link {
+        QTcpSocket *socket = nullptr;
+        FramedSocket *framed = nullptr;
+        bool connected = false;
+        quint64 expected = 0; ///< Server frames recorded on this connection before the current record.
+        quint64 received = 0;
+        std::vector<MessageType> recordedTypes;
+
+        bool ready(bool force) const { return force || (connected && received >= expected); }
+    };
+
+    static MessageType envelopeType(const QByteArray &payload) {
+        QDataStream in(payload);
+        in.setVersion(QDataStream::Qt_6_5);
+        Envelope e;
+        in >> e;
+        return e.type;
+    }
+
+    void open(quint32 connection) {
+        Link &link = m_links[connection];
+        link.socket = new QTcpSocket(this);
+        link.framed = new FramedSocket(link.socket, link.socket);
+        connect(link.socket, &QTcpSocket::connected, this, [this, connection]() {
+            Link &l = m_links[connection];
+            l.connected = true;
+            l.socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            step();
+        });
+        connect(link.framed, &FramedSocket::frameReceived, this, [this, connection](const QByteArray &payload) {
+            onServerFrame(connection, payload);
+        });
+        link.socket->connectToHost(QHostAddress::LocalHost, m_server->port());
+    }
+
+    void onServerFrame(quint32 connection, const QByteArray &payload) {
+        Link &link = m_links[connection];
+        const MessageType type = envelopeType(payload);
+        if (link.received >= link.recordedTypes.size() || link.recordedTypes[link.received] != type) {
+            ++m_mismatches;
+        }
+        ++link.received;
+        ++m_receivedOut;
+        if (type == MessageType::JobResult) {
+            ++m_jobResults;
+        }
+        step();
+    }
+
+    /**
+     * @brief Stop once every record is replayed and the server sent everything it sent in the recording (or the
+     * stall timeout passed without it).
+     */
+    void maybeFinish() {
+        if (m_finished || m_next < m_records.size()) {
+            return;
+        }
+        bool pending = false;
+        for (const Link &link : m_links) {
+            pending = pending || link.received < link.recordedTypes.size();
+        }
+        if (pending && !m_force) {
+            if (!m_stallTimer.isActive()) {
+                m_stallTimer.start(m_stallMs);
+            }
+            return;
+        }
+        m_finished = true;
+        m_stallTimer.stop();
+        report();
+        QCoreApplication::quit();
+    }
+
+    void report() {
+        const double ms = static_cast<double>(m_clock.nsecsElapsed()) / 1e6;
+        QTextStream out(stdout);
+        out << "Replayed " << m_sent << " of " << m_recordedIn << " frames on " << m_links.size() << " connections in "
+            << QString::number(ms, 'f', 1) << " ms (recorded " << QString::number(m_recordedUs / 1e3, 'f', 1)
+            << " ms), " << QString::number(ms > 0.0 ? static_cast<double>(m_sent) / ms * 1e3 : 0.0, 'f', 0)
+            << " frames/s\n";
+        out << "Server sent " << m_receivedOut << " frames (recorded " << m_recordedOut << "), " << m_jobResults
+            << " job results\n";
+        out << "Divergence: " << m_mismatches << " frames of another type than recorded, " << m_stalls
+            << " stalls of " << m_stallMs << " ms\n";
+        out.flush();
+    }
+
+    ServerApp *m_server = nullptr;
+    std::vector<SessionRecord> m_records;
+    bool m_maxSpeed = false;
+    int m_stallMs = 5000;
+
+    QHash<quint32, Link> m_links;
+    size_t m_next = 0;
+    bool m_force = false;
+    bool m_finished = false;
+    QElapsedTimer m_clock;
+    QTimer m_waitTimer;
+    QTimer m_stallTimer;
+
+    qint64 m_recordedUs = 0;
+    quint64 m_recordedIn = 0;
+    quint64 m_recordedOut = 0;
+    quint64 m_sent = 0;
+    quint64 m_receivedOut = 0;
+    quint64 m_jobResults = 0;
+    quint64 m_mismatches = 0;
+    quint64 m_stalls = 0;
+};
+
+} // namespace netproj
+
+#include "replay_main.moc"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = QCoreApplication::arguments();
+    if (args.size() < 2 || args[1].startsWith("--")) {
+        qCritical() << "Usage: net_replay SESSION [--max-speed] [--stall-timeout MS] [--granularity N]"
+                    << "[--verify-blocks B] [--verify-samples K] [--no-dedup] [--log-level LEVEL]";
+        return 1;
+    }
+
+    int stallMs = 5000;
+    int granularity = 4;
+    int verifyBlocks = 0;
+    int verifySamples = 1;
+    netproj::LogLevel logLevel = netproj::LogLevel::Warning;
+    for (int i = 2; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        bool ok = true;
+        if (opt == "--stall-timeout") {
+            stallMs = val.toInt(&ok);
+        } else if (opt == "--granularity") {
+            granularity = val.toInt(&ok);
+        } else if (opt == "--verify-blocks") {
+            verifyBlocks = val.toInt(&ok);
+        } else if (opt == "--verify-samples") {
+            verifySamples = val.toInt(&ok);
+        } else if (opt == "--log-level") {
+            ok = netproj::parseLogLevel(val, &logLevel);
+        } else {
+            continue;
+        }
+        if (!ok) {
+            qCritical() << "Invalid" << opt << val;
+            return 1;
+        }
+        ++i;
+    }
+    if (stallMs <= 0 || granularity <= 0 || verifyBlocks < 0 || verifySamples <= 0) {
+        qCritical() << "Invalid --stall-timeout, --granularity, --verify-blocks or --verify-samples";
+        return 1;
+    }
+    const netproj::AsyncLog log(logLevel);
+
+    QFile file(args[1]);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot open" << args[1] << ":" << file.errorString();
+        return 1;
+    }
+    netproj::SessionDecoder decoder;
+    if (!decoder.reset(file.readAll())) {
+        qCritical() << args[1] << ":" << decoder.error();
+        return 1;
+    }
+    std::vector<netproj::SessionRecord> records;
+    netproj::SessionRecord r;
+    while (decoder.next(&r)) {
+        records.push_back(r);
+    }
+    if (!decoder.error().isEmpty()) {
+        // A recording cut short by a killed server is still worth replaying up to that point.
+        qWarning() << args[1] << ":" << decoder.error() << "- replaying the" << records.size() << "records before it";
+    }
+
+    netproj::ServerApp srv;
+    srv.setGranularity(granularity);
+    srv.setDeduplication(!args.contains("--no-dedup"));
+    srv.setVerification(verifyBlocks, verifySamples);
+    if (!srv.setProfilesPath(QString()) || !srv.startService(0)) {
+        return 1;
+    }
+
+    netproj::ReplayApp replay(&srv, std::move(records), args.contains("--max-speed"), stallMs);
+    QTimer::singleShot(0, &replay, &netproj::ReplayApp::start);
+    return app.exec();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+namespace netproj {
+
+/**
+ * @brief Return type of a coroutine that runs on its own once called, e.g. one per job awaiting
+ * JobClient::integrate(). Requires C++20.
+ *
+ * The coroutine starts at once, frees its frame when it finishes, and terminates the process on an uncaught
+ * exception, like a thread function would.
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace netproj
@@ -0,0 +1,136 @@
+#include "job_client.h"
+
+#include <QTimer>
+
+namespace netproj {
+
+JobClient::JobClient(QObject *parent)
+    : QObject(parent) {
+    connect(&m_socket, &QTcpSocket::connected, this, &JobClient::onConnected);
+    connect(&m_socket, &QTcpSocket::errorOccurred, this, &JobClient::onError);
+}
+
+JobClient::~JobClient() {
+    // Awaiting coroutines must not stay suspended forever. Close everything first, so completions run against a
+    // client with no connection, no socket signals and no pending jobs left.
+    disconnect(&m_socket, nullptr, this, nullptr);
+    delete m_framed;
+    m_framed = nullptr;
+    m_socket.abort();
+    m_closedReason = "client destroyed";
+    failAll(m_closedReason);
+}
+
+void JobClient::connectToServer(const QString &host, quint16 port) {
+    m_closedReason.clear();
+    m_socket.connectToHost(host, port);
+}
+
+quint64 JobClient::submit(const SubmitMsg &job, Callback done) {
+    const quint64 id = m_nextRequestId++;
+    Pending &p = m_pending[id];
+    p.job = job;
+    p.job.requestId = id;
+    p.done = std::move(done);
+    if (m_framed) {
+        send(p.job);
+    } else if (!m_closedReason.isEmpty()) {
+        // Never complete inside submit(): a coroutine calling it from await_suspend() is not resumable yet.
+        QTimer::singleShot(0, this, [this]() { failAll(m_closedReason); });
+    }
+    return id;
+}
+
+void JobClient::send(const SubmitMsg &job) {
+    m_framed->sendFrame(m_codec.serialize(MessageType::Submit, job));
+}
+
+void JobClient::onConnected() {
+    m_socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    m_framed = new FramedSocket(&m_socket, this);
+    connect(m_framed, &FramedSocket::frameReceived, this, &JobClient::onFrame);
+    connect(m_framed, &FramedSocket::disconnected, this, &JobClient::onDisconnected);
+
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        send(it->job);
+    }
+    emit connected();
+}
+
+void JobClient::onFrame(const QByteArray &payload) {
+    const ParsedMessage &pm = m_codec.parse(payload);
+    if (!pm.ok) {
+        qWarning() << "Failed to parse server message:" << pm.parseError;
+        return;
+    }
+    if (pm.env.type == MessageType::Error) {
+        qWarning() << "Server error:" << pm.error.text;
+        return;
+    }
+    if (pm.env.type != MessageType::JobResult) {
+        qWarning() << "Unexpected message type from server";
+        return;
+    }
+
+    const quint64 id = pm.jobResult.requestId;
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        qWarning() << "Result for unknown request" << id;
+        return;
+    }
+    if (pm.jobResult.status == JobStatus::Deferred && m_retryDeferred) {
+        qInfo() << "Request" << id << "deferred:" << pm.jobResult.error << "- retrying in" << pm.jobResult.retryAfterMs
+                << "ms";
+        QTimer::singleShot(static_cast<int>(pm.jobResult.retryAfterMs), this, [this, id]() {
+            const auto p = m_pending.constFind(id);
+            if (m_framed && p != m_pending.cend()) {
+                send(p->job);
+            }
+        });
+        return;
+    }
+
+    // The callback may submit more jobs or release the client with deleteLater(), so leave no reference into
+    // m_pending or the codec.
+    const JobResultMsg result = pm.jobResult;
+    const Callback done = std::move(it->done);
+    m_pending.erase(it);
+    if (done) {
+        done(result);
+    }
+}
+
+void JobClient::onDisconnected() {
+    m_framed->deleteLater();
+    m_framed = nullptr;
+    m_closedReason = "connection closed";
+    failAll(m_closedReason);
+    emit disconnected(m_closedReason);
+}
+
+void JobClient::onError(QAbstractSocket::SocketError) {
+    // Errors of an established connection are followed by disconnected(), which fails the outstanding jobs.
+    if (m_framed) {
+        return;
+    }
+    m_closedReason = m_socket.errorString();
+    failAll(m_closedReason);
+    emit disconnected(m_closedReason);
+}
+
+void JobClient::failAll(const QString &error) {
+    QMap<quint64, Pending> pending;
+    pending.swap(m_pending);
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        JobResultMsg r;
+        r.requestId = it.key();
+        r.status = JobStatus::Failed;
+        r.error = error;
+        if (it->done) {
+            it->done(r);
+        }
+    }
+}
+
+} // namespace netproj
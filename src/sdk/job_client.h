@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../common/framed_socket.h"
+#include "../common/job_file.h"
+#include "../common/message_codec.h"
+
+#include <QMap>
+#include <QObject>
+#include <QTcpSocket>
+
+#include <functional>
+#include <utility>
+
+namespace netproj {
+
+class JobClient;
+
+/**
+ * @brief Awaitable result of JobClient::integrate(): `JobResultMsg r = co_await client.integrate(job);`
+ *
+ * The coroutine resumes on the client's thread when the result arrives. Usable from C++20 coroutines; the library
+ * itself does not need C++20, since await_suspend() accepts any coroutine handle.
+ */
+class IntegrateAwaiter {
+public:
+    IntegrateAwaiter(JobClient *client, const SubmitMsg &job)
+        : m_client(client), m_job(job) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Handle>
+    void await_suspend(Handle handle);
+
+    JobResultMsg await_resume() { return std::move(m_result); }
+
+private:
+    JobClient *m_client = nullptr;
+    SubmitMsg m_job;
+    JobResultMsg m_result;
+};
+
+/**
+ * @brief Client SDK for service mode: submits jobs over one connection and completes each with its JOB_RESULT.
+ *
+ * Jobs are pipelined: each is sent as soon as it is submitted (or once connected), and results complete their jobs
+ * in whatever order the server finishes them, matched by request id. Hundreds of jobs in flight cost one map entry
+ * each. Deferred jobs are resubmitted after the server's retry hint unless setRetryDeferred(false). If the
+ * connection fails or closes, every outstanding job completes with JobStatus::Failed.
+ *
+ * Not thread-safe: use a client from the thread it lives in, like any QObject with a socket.
+ */
+class JobClient : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Completion of one job; called on the client's thread.
+     *
+     * A callback may submit more jobs. It must release the client with deleteLater(), not delete it: completions run
+     * while the client's socket is still emitting readyRead().
+     */
+    using Callback = std::function<void(const JobResultMsg &result)>;
+
+    explicit JobClient(QObject *parent = nullptr);
+
+    /**
+     * @brief Closes the connection, then completes outstanding jobs as failed ("client destroyed").
+     *
+     * These completions, and coroutines they resume, run while the client is being destroyed: they must not use
+     * the client any more, e.g. to submit another job.
+     */
+    ~JobClient() override;
+
+    /**
+     * @brief Connect to a service-mode server. Jobs submitted before the connection is up are sent once it is.
+     */
+    void connectToServer(const QString &host, quint16 port);
+
+    /**
+     * @brief Resubmit deferred jobs after the server's retry hint (default) or complete them as deferred.
+     */
+    void setRetryDeferred(bool v) { m_retryDeferred = v; }
+
+    /**
+     * @brief Submit job (its requestId is assigned by the client) and call done with its result.
+     * @return Request id of the job.
+     */
+    quint64 submit(const SubmitMsg &job, Callback done);
+
+    /**
+     * @brief Submit job and co_await its result (value and telemetry).
+     */
+    IntegrateAwaiter integrate(const SubmitMsg &job) { return IntegrateAwaiter(this, job); }
+
+    /**
+     * @brief Jobs submitted and not yet completed.
+     */
+    int inFlight() const { return m_pending.size(); }
+
+signals:
+    void connected();
+
+    /**
+     * @brief Connection closed or could not be established; outstanding jobs have been completed as failed.
+     */
+    void disconnected(const QString &reason);
+
+private slots:
+    void onConnected();
+    void onFrame(const QByteArray &payload);
+    void onDisconnected();
+    void onError(QAbstractSocket::SocketError error);
+
+private:
+    struct Pending {
+        SubmitMsg job;
+        Callback done;
+    };
+
+    void send(const SubmitMsg &job);
+
+    /**
+     * @brief Complete every outstanding job with JobStatus::Failed and error.
+     */
+    void failAll(const QString &error);
+
+    QTcpSocket m_socket;
+    FramedSocket *m_framed = nullptr;
+    MessageCodec m_codec;
+    QMap<quint64, Pending> m_pending; ///< By request id, so jobs queued before connecting are sent in order.
+    quint64 m_nextRequestId = 1;
+    bool m_retryDeferred = true;
+    QString m_closedReason; ///< Why the connection is down; jobs submitted meanwhile fail with it.
+};
+
+template <typename Handle>
+void IntegrateAwaiter::await_suspend(Handle handle) {
+    m_client->submit(m_job, [this, handle](const JobResultMsg &r) mutable {
+        m_result = r;
+        handle.resume();
+    });
+}
+
+} // namespace netproj
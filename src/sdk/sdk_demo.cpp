@@ -0,0 +1,113 @@
+#include "detached.h"
+#include "job_client.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+
+namespace netproj {
+
+/**
+ * @brief Progress of the demo's jobs.
+ */
+struct DemoStats {
+    int remaining = 0;
+    int failed = 0;
+    QElapsedTimer timer;
+};
+
+/**
+ * @brief Await one job and print its result; the last job to finish ends the demo.
+ */
+static Detached runJob(JobClient *client, SubmitMsg job, DemoStats *stats) {
+    const JobResultMsg r = co_await client->integrate(job);
+
+    QTextStream out(stdout);
+    out << "request " << r.requestId << " job " << r.jobId << " " << jobStatusName(r.status) << " value "
+        << QString::number(r.value, 'g', 17) << " time " << r.elapsedMs << "ms units " << r.units << " compute "
+        << r.computeMs << "ms";
+    if (!r.error.isEmpty()) {
+        out << " error \"" << r.error << "\"";
+    }
+    out << Qt::endl;
+
+    if (r.status != JobStatus::Ok) {
+        ++stats->failed;
+    }
+    if (--stats->remaining == 0) {
+        const double seconds = static_cast<double>(stats->timer.nsecsElapsed()) / 1e9;
+        qInfo() << "All jobs done in" << seconds << "s," << stats->failed << "failed";
+        QCoreApplication::exit(stats->failed == 0 ? 0 : 1);
+    }
+}
+
+} // namespace netproj
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = QCoreApplication::arguments();
+    QString host = "127.0.0.1";
+    quint16 port = 0;
+    QString tenant = "default";
+    netproj::JobPriority priority = netproj::JobPriority::Normal;
+    QStringList jobLines;
+    int copies = 1;
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        if (opt == "--host") {
+            host = val;
+        } else if (opt == "--port") {
+            port = val.toUShort();
+        } else if (opt == "--tenant") {
+            tenant = val;
+        } else if (opt == "--priority") {
+            if (!netproj::parsePriority(val, &priority)) {
+                qCritical() << "Invalid --priority (expected batch, normal or interactive)";
+                return 1;
+            }
+        } else if (opt == "--job") {
+            jobLines.push_back(val);
+        } else if (opt == "--copies") {
+            copies = val.toInt();
+        } else {
+            continue;
+        }
+        ++i;
+    }
+    if (port == 0 || jobLines.isEmpty() || copies < 1) {
+        qCritical() << "Usage: net_sdk_demo --port PORT --job \"A B h method\" [--job ...] [--copies N] [--host HOST]"
+                    << "[--tenant NAME] [--priority CLASS]";
+        return 1;
+    }
+
+    QVector<netproj::SubmitMsg> jobs;
+    for (const QString &line : jobLines) {
+        netproj::SubmitMsg m;
+        QString error;
+        if (!netproj::parseJobLine(line, &m, &error)) {
+            qCritical() << "Invalid job:" << error;
+            return 1;
+        }
+        m.tenant = tenant;
+        m.priority = priority;
+        jobs.push_back(m);
+    }
+
+    netproj::JobClient client;
+    client.setRetryDeferred(!args.contains("--no-retry"));
+    netproj::DemoStats stats;
+    stats.remaining = static_cast<int>(jobs.size()) * copies;
+    stats.timer.start();
+    // Every job is a coroutine suspended on its result; all of them are in flight over the one connection.
+    for (int c = 0; c < copies; ++c) {
+        for (const netproj::SubmitMsg &job : jobs) {
+            netproj::runJob(&client, job, &stats);
+        }
+    }
+    qInfo() << "Submitting" << client.inFlight() << "jobs to" << host << port;
+    client.connectToServer(host, port);
+    return app.exec();
+}
@@ -0,0 +1,75 @@
+#include "admission_control.h"
+
+#include "../common/integrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace netproj {
+
+/**
+ * @brief Bounds of the retry hint sent with deferrals.
+ */
+static constexpr qint64 kMinRetryMs = 100;
+static constexpr qint64 kMaxRetryMs = 60000;
+
+static qint64 retryHintMs(double seconds) {
+    if (!std::isfinite(seconds)) {
+        return kMaxRetryMs;
+    }
+    return std::clamp(static_cast<qint64>(std::ceil(seconds * 1000.0)), kMinRetryMs, kMaxRetryMs);
+}
+
+AdmissionDecision AdmissionController::evaluate(const JobSpec &spec, const JobScheduler &scheduler) const {
+    AdmissionDecision d;
+
+    const int active = scheduler.activeJobs();
+    const double backlog = scheduler.backlogSeconds(spec.priority);
+    const double cap = scheduler.capacity(spec.method, spec.h);
+    const double steps = static_cast<double>(Integrator::stepCount(spec.a, spec.b, spec.h));
+    d.jobSec = (cap > 0.0) ? steps / cap : 0.0;
+    d.waitSec = backlog;
+
+    // Average time until one active job finishes: used as the retry hint for queue length limits.
+    const double perJobSec = (active > 0 && std::isfinite(backlog)) ? backlog / active : 1.0;
+
+    if (m_limits.maxActiveJobs > 0 && active >= m_limits.maxActiveJobs) {
+        d.kind = AdmissionDecision::Kind::Defer;
+        d.reason = QString("queue full (%1 active jobs)").arg(active);
+        d.retryAfterMs = retryHintMs(perJobSec);
+        return d;
+    }
+
+    const int tenantActive = scheduler.tenantJobs(spec.tenant);
+    if (m_limits.maxTenantJobs > 0 && tenantActive >= m_limits.maxTenantJobs) {
+        d.kind = AdmissionDecision::Kind::Defer;
+        d.reason = QString("tenant queue full (%1 active jobs)").arg(tenantActive);
+        d.retryAfterMs = retryHintMs(perJobSec);
+        return d;
+    }
+
+    if (m_limits.maxQueueDelaySec <= 0.0 || !(cap > 0.0)) {
+        return d;
+    }
+
+    if (d.jobSec > m_limits.maxQueueDelaySec) {
+        d.kind = AdmissionDecision::Kind::Reject;
+        d.reason = QString("estimated cost %1 s exceeds the %2 s bound at current capacity")
+                       .arg(d.jobSec, 0, 'f', 1)
+                       .arg(m_limits.maxQueueDelaySec, 0, 'f', 1);
+        return d;
+    }
+
+    if (backlog + d.jobSec > m_limits.maxQueueDelaySec) {
+        d.kind = AdmissionDecision::Kind::Defer;
+        d.reason = QString("estimated completion in %1 s exceeds the %2 s bound")
+                       .arg(backlog + d.jobSec, 0, 'f', 1)
+                       .arg(m_limits.maxQueueDelaySec, 0, 'f', 1);
+        d.retryAfterMs = retryHintMs(backlog + d.jobSec - m_limits.maxQueueDelaySec);
+        return d;
+    }
+
+    return d;
+}
+
+} // namespace netproj
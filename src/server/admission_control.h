@@ -0,0 +1,65 @@
+#pragma once
+
+#include "job_scheduler.h"
+
+#include <QString>
+
+namespace netproj {
+
+/**
+ * @brief Limits applied to new submissions. A value <= 0 disables the corresponding check.
+ */
+struct AdmissionLimits {
+    int maxActiveJobs = 1000;
+    int maxTenantJobs = 200;
+    double maxQueueDelaySec = 600.0;
+};
+
+/**
+ * @brief Outcome of an admission check.
+ */
+struct AdmissionDecision {
+    enum class Kind {
+        Admit,
+        Defer,
+        Reject
+    };
+
+    Kind kind = Kind::Admit;
+    qint64 retryAfterMs = 0;
+    QString reason;
+    double jobSec = 0.0;
+    double waitSec = 0.0;
+};
+
+/**
+ * @brief Admission control for service mode.
+ *
+ * The cost of a job is its step count divided by the predicted aggregate throughput of the connected workers for
+ * its method and step. The predicted completion delay is that cost plus the remaining work of active jobs of the
+ * same or higher priority (lower classes will be preempted). Jobs that alone exceed the delay bound are rejected;
+ * jobs that only exceed it because of the current backlog, or that hit the queue length limits, are deferred
+ * with a retry hint. With no workers connected only the queue length limits apply.
+ */
+class AdmissionController {
+public:
+    /**
+     * @brief Set admission limits.
+     */
+    void setLimits(const AdmissionLimits &limits) { m_limits = limits; }
+
+    /**
+     * @brief Current admission limits.
+     */
+    const AdmissionLimits &limits() const { return m_limits; }
+
+    /**
+     * @brief Decide whether a validated job may enter the scheduler now.
+     */
+    AdmissionDecision evaluate(const JobSpec &spec, const JobScheduler &scheduler) const;
+
+private:
+    AdmissionLimits m_limits;
+};
+
+} // namespace netproj
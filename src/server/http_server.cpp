@@ -0,0 +1,152 @@
+#include "http_server.h"
+
+#include <QHostAddress>
+#include <QStringList>
+#include <QTcpSocket>
+
+namespace netproj {
+
+static QByteArray statusText(int status) {
+    switch (status) {
+    case 200:
+        return "OK";
+    case 202:
+        return "Accepted";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 429:
+        return "Too Many Requests";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return (status < 400) ? "OK" : "Error";
+    }
+}
+
+HttpServer::HttpServer(QObject *parent)
+    : QObject(parent) {
+    connect(&m_server, &QTcpServer::newConnection, this, &HttpServer::onNewConnection);
+}
+
+void HttpServer::route(const QString &method, const QString &path, Handler handler) {
+    routeAsync(method, path, [handler = std::move(handler)](const HttpRequest &req, const Responder &respond) {
+        respond(handler(req));
+    });
+}
+
+void HttpServer::routeAsync(const QString &method, const QString &path, AsyncHandler handler) {
+    m_routes[path][method] = std::move(handler);
+}
+
+bool HttpServer::listen(quint16 port, const QHostAddress &address) {
+    if (!m_server.listen(address, port)) {
+        qCritical() << "HTTP listen on" << address.toString() << "port" << port << "failed:" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::onNewConnection() {
+    while (QTcpSocket *sock = m_server.nextPendingConnection()) {
+        m_pending.insert(sock, QByteArray());
+        connect(sock, &QTcpSocket::readyRead, this, [this, sock]() {
+            onReadyRead(sock);
+        });
+        connect(sock, &QTcpSocket::disconnected, this, [this, sock]() {
+            m_pending.remove(sock);
+            sock->deleteLater();
+        });
+    }
+}
+
+void HttpServer::onReadyRead(QTcpSocket *sock) {
+    const auto it = m_pending.find(sock);
+    if (it == m_pending.end()) {
+        sock->readAll();
+        return;
+    }
+    QByteArray &buf = *it;
+    buf += sock->readAll();
+
+    const qsizetype headerEnd = buf.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buf.size() > kMaxRequestBytes) {
+            m_pending.erase(it);
+            reply(sock, HttpResponse{413, "text/plain; charset=utf-8", "request too large\n"});
+        }
+        return;
+    }
+
+    HttpRequest req;
+    const QList<QByteArray> lines = buf.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.front().trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine[2].startsWith("HTTP/1.")) {
+        m_pending.erase(it);
+        reply(sock, HttpResponse{400, "text/plain; charset=utf-8", "malformed request line\n"});
+        return;
+    }
+    req.method = QString::fromLatin1(requestLine[0]);
+    const QString target = QString::fromUtf8(requestLine[1]);
+    const qsizetype q = target.indexOf('?');
+    req.path = (q < 0) ? target : target.left(q);
+    req.query = (q < 0) ? QString() : target.mid(q + 1);
+    for (int i = 1; i < lines.size(); ++i) {
+        const qsizetype colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            req.headers.insert(QString::fromLatin1(lines[i].left(colon).trimmed()).toLower(),
+                               QString::fromUtf8(lines[i].mid(colon + 1).trimmed()));
+        }
+    }
+
+    bool ok = true;
+    const qint64 length = req.headers.value("content-length", "0").toLongLong(&ok);
+    if (!ok || length < 0 || headerEnd + 4 + length > kMaxRequestBytes) {
+        m_pending.erase(it);
+        reply(sock, HttpResponse{ok ? 413 : 400, "text/plain; charset=utf-8", "bad content length\n"});
+        return;
+    }
+    if (buf.size() < headerEnd + 4 + length) {
+        return;
+    }
+    req.body = buf.mid(headerEnd + 4, length);
+    m_pending.erase(it);
+    dispatch(sock, req);
+}
+
+void HttpServer::dispatch(QTcpSocket *sock, const HttpRequest &req) const {
+    const auto path = m_routes.constFind(req.path);
+    if (path == m_routes.constEnd()) {
+        reply(sock, HttpResponse{404, "text/plain; charset=utf-8", "not found\n"});
+        return;
+    }
+    const auto handler = path->constFind(req.method);
+    if (handler == path->constEnd()) {
+        reply(sock, HttpResponse{405, "text/plain; charset=utf-8", "method not allowed\n"});
+        return;
+    }
+    // The socket is deleted when the client disconnects, which may happen before a deferred response.
+    const QPointer<QTcpSocket> target(sock);
+    (*handler)(req, [target](const HttpResponse &resp) {
+        if (target && target->state() == QAbstractSocket::ConnectedState) {
+            reply(target, resp);
+        }
+    });
+}
+
+void HttpServer::reply(QTcpSocket *sock, const HttpResponse &resp) {
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(resp.status) + ' ' + statusText(resp.status) + "\r\n";
+    out += "Content-Type: " + resp.contentType + "\r\n";
+    out += "Content-Length: " + QByteArray::number(resp.body.size()) + "\r\n";
+    out += "Connection: close\r\n\r\n";
+    out += resp.body;
+    sock->write(out);
+    sock->disconnectFromHost();
+}
+
+} // namespace netproj
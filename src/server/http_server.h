@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTcpServer>
+
+#include <functional>
+
+class QTcpSocket;
+
+namespace netproj {
+
+/**
+ * @brief Parsed HTTP request.
+ */
+struct HttpRequest {
+    QString method;
+    QString path;  ///< Without the query string.
+    QString query; ///< Part after '?', not decoded.
+    QHash<QString, QString> headers; ///< Keys in lower case.
+    QByteArray body;
+};
+
+/**
+ * @brief HTTP response produced by a route handler.
+ */
+struct HttpResponse {
+    int status = 200;
+    QByteArray contentType = "text/plain; charset=utf-8";
+    QByteArray body;
+};
+
+/**
+ * @brief Minimal HTTP/1.1 server for local tooling endpoints.
+ *
+ * Serves one request per connection (responses carry "Connection: close") and dispatches it by exact path to
+ * the handlers registered with route() or routeAsync(). Handlers run on the event loop thread and must not block;
+ * an asynchronous handler answers later through its responder instead.
+ */
+class HttpServer : public QObject {
+    Q_OBJECT
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest &)>;
+
+    /**
+     * @brief Sends the response of one request; does nothing once the client has gone or after the first call.
+     */
+    using Responder = std::function<void(const HttpResponse &)>;
+    using AsyncHandler = std::function<void(const HttpRequest &, const Responder &)>;
+
+    /**
+     * @brief Largest accepted request (headers and body).
+     */
+    static constexpr int kMaxRequestBytes = 1 << 20;
+
+    /**
+     * @brief Construct an idle server.
+     */
+    explicit HttpServer(QObject *parent = nullptr);
+
+    /**
+     * @brief Serve method requests for path with handler.
+     */
+    void route(const QString &method, const QString &path, Handler handler);
+
+    /**
+     * @brief Serve method requests for path with a handler that may respond after returning.
+     */
+    void routeAsync(const QString &method, const QString &path, AsyncHandler handler);
+
+    /**
+     * @brief Start listening on port of address; only local clients by default, since no route authenticates.
+     */
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+    /**
+     * @brief Listening port (0 if not listening).
+     */
+    quint16 port() const { return m_server.serverPort(); }
+
+private slots:
+    void onNewConnection();
+
+private:
+    void onReadyRead(QTcpSocket *sock);
+    void dispatch(QTcpSocket *sock, const HttpRequest &req) const;
+    static void reply(QTcpSocket *sock, const HttpResponse &resp);
+
+    QTcpServer m_server;
+    QHash<QString, QHash<QString, AsyncHandler>> m_routes; ///< path -> method -> handler
+    QHash<QTcpSocket *, QByteArray> m_pending;
+};
+
+} // namespace netproj
@@ -0,0 +1,150 @@
+#include "job_gateway.h"
+
+#include "../common/job_file.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QUrlQuery>
+
+namespace netproj {
+
+static const QByteArray kJsonType = "application/json";
+
+static HttpResponse jsonError(int status, const QString &error) {
+    QJsonObject o;
+    o.insert("error", error);
+    return HttpResponse{status, kJsonType, QJsonDocument(o).toJson(QJsonDocument::Compact) + "\n"};
+}
+
+JobGateway::JobGateway(QObject *parent)
+    : QObject(parent) {
+    m_http.routeAsync("POST", "/jobs", [this](const HttpRequest &req, const HttpServer::Responder &respond) {
+        handleSubmit(req, respond);
+    });
+    m_http.route("GET", "/jobs", [this](const HttpRequest &req) {
+        return handleStatus(req);
+    });
+}
+
+bool JobGateway::listen(quint16 port, const QHostAddress &address) {
+    return m_http.listen(port, address);
+}
+
+void JobGateway::handleSubmit(const HttpRequest &req, const HttpServer::Responder &respond) {
+    const QByteArray body = req.body.trimmed();
+    std::vector<SubmitMsg> jobs;
+    QString error;
+    // A single job object is a job file of one.
+    if (!parseJobFile(body.startsWith('{') ? "[" + body + "]" : body, &jobs, &error)) {
+        respond(jsonError(400, error));
+        return;
+    }
+    const QString wait = QUrlQuery(req.query).queryItemValue("wait");
+    const bool waitForResults = (wait == "1" || wait == "true");
+
+    std::vector<quint64> ids;
+    for (SubmitMsg &m : jobs) {
+        m.requestId = m_nextJobId++;
+        m_jobs[m.requestId].job = m;
+        ids.push_back(m.requestId);
+        m_queue.push_back(m);
+    }
+    m_pending += static_cast<int>(jobs.size());
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &JobGateway::flush);
+    }
+
+    if (!waitForResults) {
+        respond(HttpResponse{202, kJsonType, jobsJson(ids)});
+        return;
+    }
+    const quint64 waiter = m_nextWaiterId++;
+    for (const quint64 id : ids) {
+        m_jobs[id].waiters.push_back(waiter);
+    }
+    m_waiters.insert(waiter, Waiter{ids, static_cast<int>(ids.size()), respond});
+}
+
+HttpResponse JobGateway::handleStatus(const HttpRequest &req) const {
+    bool ok = false;
+    const quint64 id = QUrlQuery(req.query).queryItemValue("id").toULongLong(&ok);
+    if (!ok) {
+        return jsonError(400, "expected /jobs?id=N");
+    }
+    if (!m_jobs.contains(id)) {
+        return jsonError(404, "unknown job " + QString::number(id));
+    }
+    return HttpResponse{200, kJsonType, QJsonDocument(jobJson(id)).toJson(QJsonDocument::Compact) + "\n"};
+}
+
+void JobGateway::flush() {
+    m_flushScheduled = false;
+    if (m_queue.empty()) {
+        return;
+    }
+    std::vector<SubmitMsg> batch;
+    batch.swap(m_queue);
+    if (m_submitter) {
+        m_submitter(batch);
+    }
+}
+
+void JobGateway::deliver(const JobResultMsg &r) {
+    const auto it = m_jobs.find(r.requestId);
+    if (it == m_jobs.end() || it->done) {
+        return;
+    }
+    it->done = true;
+    it->result = r;
+    const QVector<quint64> waiters = it->waiters;
+    it->waiters.clear();
+    --m_pending;
+    m_finished.push_back(r.requestId);
+
+    for (const quint64 w : waiters) {
+        const auto waiter = m_waiters.find(w);
+        if (waiter == m_waiters.end() || --waiter->remaining > 0) {
+            continue;
+        }
+        const Waiter done = *waiter;
+        m_waiters.erase(waiter);
+        done.respond(HttpResponse{200, kJsonType, jobsJson(done.ids)});
+    }
+
+    while (m_finished.size() > static_cast<size_t>(kMaxRetainedResults)) {
+        m_jobs.remove(m_finished.front());
+        m_finished.pop_front();
+    }
+}
+
+QJsonObject JobGateway::jobJson(quint64 id) const {
+    const auto it = m_jobs.constFind(id);
+    QJsonObject o;
+    if (it == m_jobs.constEnd()) {
+        // Dropped after kMaxRetainedResults later results; only a waiter outliving that many jobs sees this.
+        o.insert("status", "expired");
+    } else if (!it->done) {
+        o.insert("status", "pending");
+    } else {
+        o = jobResultJson(JobFileResult{it->job, it->result});
+        if (it->result.status == JobStatus::Deferred) {
+            o.insert("retry_after_ms", static_cast<qint64>(it->result.retryAfterMs));
+        }
+    }
+    o.insert("id", static_cast<qint64>(id));
+    return o;
+}
+
+QByteArray JobGateway::jobsJson(const std::vector<quint64> &ids) const {
+    QJsonArray jobs;
+    for (const quint64 id : ids) {
+        jobs.append(jobJson(id));
+    }
+    QJsonObject o;
+    o.insert("jobs", jobs);
+    return QJsonDocument(o).toJson(QJsonDocument::Compact) + "\n";
+}
+
+} // namespace netproj
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../common/protocol.h"
+#include "http_server.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QVector>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief HTTP/JSON front end for job submission, for tools that cannot speak the framed protocol.
+ *
+ * POST /jobs takes a job object or an array of them (the JSON job file format, see parseJobFile()) and answers
+ * 202 with the ids assigned to the jobs, or with their results once all are finished if the query has "wait=1".
+ * GET /jobs?id=N polls one job. Submissions of all requests received in one event loop iteration reach the
+ * scheduler as one batch, so a burst of requests costs one scheduling pass.
+ */
+class JobGateway : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Admits a batch of jobs; results come back through deliver(), with the job's id as request id.
+     */
+    using Submitter = std::function<void(const std::vector<SubmitMsg> &)>;
+
+    /**
+     * @brief Finished results kept for polling; the oldest are dropped beyond this.
+     */
+    static constexpr int kMaxRetainedResults = 10000;
+
+    /**
+     * @brief Construct a gateway that is not listening.
+     */
+    explicit JobGateway(QObject *parent = nullptr);
+
+    /**
+     * @brief Set where submitted jobs go.
+     */
+    void setSubmitter(Submitter submitter) { m_submitter = std::move(submitter); }
+
+    /**
+     * @brief Start serving the routes on port of address (see HttpServer::listen()).
+     */
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+    /**
+     * @brief Listening port (0 if not listening).
+     */
+    quint16 port() const { return m_http.port(); }
+
+    /**
+     * @brief Record the result of a job and answer the requests waiting for it.
+     */
+    void deliver(const JobResultMsg &r);
+
+    /**
+     * @brief POST /jobs handler.
+     */
+    void handleSubmit(const HttpRequest &req, const HttpServer::Responder &respond);
+
+    /**
+     * @brief GET /jobs handler.
+     */
+    HttpResponse handleStatus(const HttpRequest &req) const;
+
+    /**
+     * @brief Hand the queued submissions to the submitter (runs once per event loop iteration with submissions).
+     */
+    void flush();
+
+    /**
+     * @brief Jobs submitted and not finished yet.
+     */
+    int pendingCount() const { return m_pending; }
+
+private:
+    /**
+     * @brief Job submitted through the gateway.
+     */
+    struct Entry {
+        SubmitMsg job;
+        bool done = false;
+        JobResultMsg result;
+        QVector<quint64> waiters;
+    };
+
+    /**
+     * @brief Request answered when all of its jobs are finished.
+     */
+    struct Waiter {
+        std::vector<quint64> ids;
+        int remaining = 0;
+        HttpServer::Responder respond;
+    };
+
+    QJsonObject jobJson(quint64 id) const;
+    QByteArray jobsJson(const std::vector<quint64> &ids) const;
+
+    HttpServer m_http;
+    Submitter m_submitter;
+    QHash<quint64, Entry> m_jobs;
+    QHash<quint64, Waiter> m_waiters;
+    std::vector<SubmitMsg> m_queue;
+    std::deque<quint64> m_finished; ///< Finished job ids, oldest first.
+    quint64 m_nextJobId = 1;
+    quint64 m_nextWaiterId = 1;
+    int m_pending = 0;
+    bool m_flushScheduled = false;
+};
+
+} // namespace netproj
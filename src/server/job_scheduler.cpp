@@ -0,0 +1,567 @@
+#include "job_scheduler.h"
+
+#include "../common/integrator.h"
+
+#include <QHashFunctions>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace netproj {
+
+/**
+ * @brief Smallest unit handed out (in steps), so tiny shares do not turn into round-trip-bound units.
+ */
+static constexpr quint64 kMinUnitSteps = 1024;
+
+JobKey JobKey::of(const JobSpec &spec) {
+    JobKey k;
+    // Adding 0.0 folds -0.0 into +0.0 so both hash alike.
+    k.lo = std::min(spec.a, spec.b) + 0.0;
+    k.hi = std::max(spec.a, spec.b) + 0.0;
+    k.h = spec.h;
+    k.method = spec.method;
+    return k;
+}
+
+size_t qHash(const JobKey &key, size_t seed) {
+    return qHashMulti(seed, key.lo, key.hi, key.h, static_cast<quint8>(key.method));
+}
+
+void JobScheduler::setTenantWeight(const QString &tenant, double weight) {
+    m_tenants[tenant].weight = (weight > 0.0) ? weight : 1.0;
+}
+
+void JobScheduler::setDefaultCoreRate(double stepsPerSec) {
+    if (stepsPerSec > 0.0) {
+        m_defaultCoreRate = stepsPerSec;
+    }
+}
+
+void JobScheduler::setGranularity(int granularity) {
+    m_granularity = std::max(1, granularity);
+}
+
+void JobScheduler::addWorker(int worker, quint32 cores, bool relay) {
+    Worker &w = m_workers[worker];
+    w.cores = std::max<quint32>(1u, cores);
+    w.relay = relay;
+}
+
+void JobScheduler::drainWorker(int worker) {
+    const auto it = m_workers.find(worker);
+    if (it != m_workers.end()) {
+        it->second.draining = true;
+    }
+}
+
+void JobScheduler::removeWorker(int worker) {
+    const auto it = m_workers.find(worker);
+    if (it == m_workers.end()) {
+        return;
+    }
+    if (it->second.busy) {
+        releaseUnit(it->second, true);
+    }
+    m_workers.erase(it);
+}
+
+double JobScheduler::virtualTime(const QString &tenant) const {
+    const auto it = m_tenants.constFind(tenant);
+    if (it == m_tenants.constEnd()) {
+        return 0.0;
+    }
+    return it->usage / it->weight;
+}
+
+double JobScheduler::tenantUsage(const QString &tenant) const {
+    return m_tenants.value(tenant).usage;
+}
+
+quint64 JobScheduler::submit(const JobSpec &spec) {
+    Job job;
+    job.id = m_nextJobId++;
+    job.spec = spec;
+    job.lo = std::min(spec.a, spec.b);
+    job.hi = std::max(spec.a, spec.b);
+    job.sign = (spec.b < spec.a) ? -1.0 : 1.0;
+    job.totalSteps = Integrator::stepCount(job.lo, job.hi, spec.h);
+
+    // A tenant returning from idle starts at the current minimum virtual time instead of cashing in the
+    // share it did not use while it had nothing queued.
+    bool tenantActive = false;
+    bool haveMin = false;
+    double minVt = 0.0;
+    for (const auto &[id, other] : m_jobs) {
+        if (other.spec.tenant == spec.tenant) {
+            tenantActive = true;
+            break;
+        }
+        const double vt = virtualTime(other.spec.tenant);
+        if (!haveMin || vt < minVt) {
+            minVt = vt;
+            haveMin = true;
+        }
+    }
+    Tenant &tenant = m_tenants[spec.tenant];
+    if (!tenantActive && haveMin) {
+        tenant.usage = std::max(tenant.usage, minVt * tenant.weight);
+    }
+
+    if (job.totalSteps == 0) {
+        JobOutcome o;
+        o.jobId = job.id;
+        m_finished.push_back(o);
+        return job.id;
+    }
+
+    job.pending.push_back(StepRange{0, job.totalSteps});
+    const quint64 id = job.id;
+    m_jobs.emplace(id, std::move(job));
+    return id;
+}
+
+void JobScheduler::raisePriority(quint64 jobId, JobPriority priority) {
+    const auto it = m_jobs.find(jobId);
+    if (it != m_jobs.end() && priority > it->second.spec.priority) {
+        it->second.spec.priority = priority;
+    }
+}
+
+std::vector<Assignment> JobScheduler::cancelJob(quint64 jobId) {
+    return dropJob(jobId, JobStatus::Cancelled, QString());
+}
+
+std::vector<Assignment> JobScheduler::dropJob(quint64 jobId, JobStatus status, const QString &error) {
+    std::vector<Assignment> victims;
+    const auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return victims;
+    }
+
+    for (auto &[id, w] : m_workers) {
+        if (w.busy && !w.cancelling && w.unit.jobId == jobId) {
+            w.cancelling = true;
+            victims.push_back(Assignment{id, w.unit});
+        }
+    }
+
+    JobOutcome o;
+    o.jobId = jobId;
+    o.status = status;
+    o.error = error;
+    m_finished.push_back(o);
+    m_jobs.erase(it);
+    return victims;
+}
+
+JobScheduler::Job *JobScheduler::pickJob(const Worker &w) {
+    Job *best = nullptr;
+    double bestVt = 0.0;
+    for (auto &[id, job] : m_jobs) {
+        // Relaying federated work again could bounce it between coordinators forever.
+        if (job.pending.empty() || (w.relay && job.spec.federated)) {
+            continue;
+        }
+        const double vt = virtualTime(job.spec.tenant);
+        if (!best || job.spec.priority > best->spec.priority ||
+            (job.spec.priority == best->spec.priority && vt < bestVt)) {
+            best = &job;
+            bestVt = vt;
+        }
+    }
+    return best;
+}
+
+std::vector<double> JobScheduler::workerRates(MethodType method, double h) const {
+    std::vector<std::optional<double>> known;
+    known.reserve(m_workers.size());
+
+    double knownRate = 0.0;
+    quint64 knownCores = 0;
+    for (const auto &[id, w] : m_workers) {
+        std::optional<double> r;
+        if (w.draining) {
+            known.push_back(0.0);
+            continue;
+        }
+        if (m_rateEstimator) {
+            r = m_rateEstimator(id, method, h);
+        }
+        if (r && *r > 0.0) {
+            knownRate += *r;
+            knownCores += w.cores;
+        } else {
+            r.reset();
+        }
+        known.push_back(r);
+    }
+
+    // Workers without a profile are assumed to be as fast per core as the profiled ones.
+    const double perCore = (knownCores > 0) ? knownRate / static_cast<double>(knownCores) : m_defaultCoreRate;
+
+    std::vector<double> rates;
+    rates.reserve(m_workers.size());
+    size_t i = 0;
+    for (const auto &[id, w] : m_workers) {
+        rates.push_back(known[i] ? *known[i] : perCore * static_cast<double>(w.cores));
+        ++i;
+    }
+    return rates;
+}
+
+double JobScheduler::shareFraction(int worker, const JobSpec &spec) const {
+    const std::vector<double> rates = workerRates(spec.method, spec.h);
+
+    double total = 0.0;
+    double mine = 0.0;
+    size_t i = 0;
+    for (const auto &[id, w] : m_workers) {
+        total += rates[i];
+        if (id == worker) {
+            mine = rates[i];
+        }
+        ++i;
+    }
+    return (total > 0.0) ? mine / total : 1.0;
+}
+
+double JobScheduler::capacity(MethodType method, double h) const {
+    double total = 0.0;
+    for (const double r : workerRates(method, h)) {
+        total += r;
+    }
+    return total;
+}
+
+double JobScheduler::backlogSeconds(JobPriority atLeast) const {
+    double seconds = 0.0;
+    for (const auto &[jobId, job] : m_jobs) {
+        if (job.spec.priority < atLeast) {
+            continue;
+        }
+        quint64 steps = 0;
+        for (const StepRange &r : job.pending) {
+            steps += r.last - r.first;
+        }
+        for (const auto &[id, w] : m_workers) {
+            if (w.busy && w.unit.jobId == jobId) {
+                steps += w.range.last - w.range.first;
+            }
+        }
+        if (steps == 0) {
+            continue;
+        }
+        const double cap = capacity(job.spec.method, job.spec.h);
+        if (!(cap > 0.0)) {
+            return std::numeric_limits<double>::infinity();
+        }
+        seconds += static_cast<double>(steps) / cap;
+    }
+    return seconds;
+}
+
+int JobScheduler::tenantJobs(const QString &tenant) const {
+    int n = 0;
+    for (const auto &[id, job] : m_jobs) {
+        if (job.spec.tenant == tenant) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+JobScheduler::StepRange JobScheduler::carve(Job &job, int worker) {
+    StepRange &front = job.pending.front();
+
+    const double frac = shareFraction(worker, job.spec);
+    quint64 want = static_cast<quint64>(
+        std::ceil(static_cast<double>(job.totalSteps) * frac / static_cast<double>(m_granularity)));
+    want = std::max(want, kMinUnitSteps);
+    want += want % 2; // Keep inner boundaries on even steps (Simpson pairs).
+
+    const quint64 avail = front.last - front.first;
+    StepRange r;
+    if (avail <= want + kMinUnitSteps) {
+        r = front;
+        job.pending.pop_front();
+    } else {
+        r.first = front.first;
+        r.last = front.first + want;
+        front.first = r.last;
+    }
+    return r;
+}
+
+WorkUnit JobScheduler::makeUnit(const Job &job, const StepRange &r) {
+    WorkUnit u;
+    u.jobId = job.id;
+    u.unitId = m_nextUnitId++;
+    u.a = job.lo + static_cast<double>(r.first) * job.spec.h;
+    u.b = (r.last == job.totalSteps) ? job.hi : job.lo + static_cast<double>(r.last) * job.spec.h;
+    u.h = job.spec.h;
+    u.method = job.spec.method;
+    return u;
+}
+
+std::vector<Assignment> JobScheduler::schedule() {
+    std::vector<Assignment> out;
+    for (auto &[id, w] : m_workers) {
+        if (w.busy || w.draining) {
+            continue;
+        }
+        Job *job = pickJob(w);
+        if (!job) {
+            continue;
+        }
+
+        const StepRange r = carve(*job, id);
+        w.busy = true;
+        w.cancelling = false;
+        w.range = r;
+        w.unit = makeUnit(*job, r);
+        ++job->running;
+        m_tenants[job->spec.tenant].usage += static_cast<double>(std::max<quint64>(1, r.last - r.first));
+
+        out.push_back(Assignment{id, w.unit});
+    }
+    return out;
+}
+
+std::vector<Assignment> JobScheduler::preempt() {
+    std::vector<Assignment> victims;
+
+    int cancelling = 0;
+    for (const auto &[id, w] : m_workers) {
+        if (!w.busy && !w.draining) {
+            return victims;
+        }
+        if (w.cancelling) {
+            ++cancelling;
+        }
+    }
+
+    std::vector<Job *> starving;
+    for (auto &[id, job] : m_jobs) {
+        if (!job.pending.empty() && job.running == 0) {
+            starving.push_back(&job);
+        }
+    }
+    std::stable_sort(starving.begin(), starving.end(),
+                     [](const Job *l, const Job *r) { return l->spec.priority > r->spec.priority; });
+
+    for (Job *job : starving) {
+        // Workers already being cancelled will be handed to the most urgent starving jobs first.
+        if (cancelling > 0) {
+            --cancelling;
+            continue;
+        }
+
+        int victimId = 0;
+        Worker *victim = nullptr;
+        JobPriority victimPriority = JobPriority::Interactive;
+        for (auto &[id, w] : m_workers) {
+            if (!w.busy || w.cancelling || (w.relay && job->spec.federated)) {
+                continue;
+            }
+            const auto jit = m_jobs.find(w.unit.jobId);
+            if (jit == m_jobs.end()) {
+                continue;
+            }
+            const JobPriority p = jit->second.spec.priority;
+            if (p >= job->spec.priority) {
+                continue;
+            }
+            if (!victim || p < victimPriority || (p == victimPriority && w.unit.unitId > victim->unit.unitId)) {
+                victim = &w;
+                victimId = id;
+                victimPriority = p;
+            }
+        }
+        if (!victim) {
+            continue;
+        }
+
+        victim->cancelling = true;
+        victims.push_back(Assignment{victimId, victim->unit});
+    }
+    return victims;
+}
+
+void JobScheduler::releaseUnit(Worker &w, bool requeue) {
+    const auto it = m_jobs.find(w.unit.jobId);
+    if (it != m_jobs.end()) {
+        Job &job = it->second;
+        --job.running;
+        if (requeue) {
+            job.pending.push_front(w.range);
+            job.requeuedUnits += 1;
+            job.requeuedSteps += w.range.last - w.range.first;
+            Tenant &t = m_tenants[job.spec.tenant];
+            t.usage = std::max(0.0, t.usage - static_cast<double>(w.range.last - w.range.first));
+        }
+    }
+    w.busy = false;
+    w.cancelling = false;
+}
+
+void JobScheduler::maybeFinish(Job &job) {
+    if (!job.pending.empty() || job.running > 0) {
+        return;
+    }
+    JobOutcome o;
+    o.jobId = job.id;
+    o.status = JobStatus::Ok;
+    o.value = job.sign * job.sum;
+    o.requeuedUnits = job.requeuedUnits;
+    o.requeuedSteps = job.requeuedSteps;
+    m_finished.push_back(o);
+    m_jobs.erase(o.jobId);
+}
+
+bool JobScheduler::unitCompleted(int worker, quint64 unitId, double value) {
+    const auto wit = m_workers.find(worker);
+    if (wit == m_workers.end() || !wit->second.busy || wit->second.unit.unitId != unitId) {
+        return false;
+    }
+    Worker &w = wit->second;
+    const auto jit = m_jobs.find(w.unit.jobId);
+    releaseUnit(w, false);
+    if (jit == m_jobs.end()) {
+        return false;
+    }
+    jit->second.sum += value;
+    maybeFinish(jit->second);
+    return true;
+}
+
+bool JobScheduler::holdUnit(int worker, quint64 unitId) {
+    const auto wit = m_workers.find(worker);
+    if (wit == m_workers.end() || !wit->second.busy || wit->second.unit.unitId != unitId) {
+        return false;
+    }
+    Worker &w = wit->second;
+    const bool active = m_jobs.count(w.unit.jobId) != 0;
+    if (active) {
+        // The job keeps counting the unit as running until it is accepted or rejected.
+        m_held[unitId] = HeldUnit{w.unit.jobId, w.range};
+    }
+    w.busy = false;
+    w.cancelling = false;
+    return active;
+}
+
+void JobScheduler::acceptHeld(quint64 unitId, double value) {
+    const auto hit = m_held.find(unitId);
+    if (hit == m_held.end()) {
+        return;
+    }
+    const quint64 jobId = hit->second.jobId;
+    m_held.erase(hit);
+
+    const auto jit = m_jobs.find(jobId);
+    if (jit == m_jobs.end()) {
+        return;
+    }
+    --jit->second.running;
+    jit->second.sum += value;
+    maybeFinish(jit->second);
+}
+
+void JobScheduler::rejectHeld(quint64 unitId) {
+    const auto hit = m_held.find(unitId);
+    if (hit == m_held.end()) {
+        return;
+    }
+    const HeldUnit held = hit->second;
+    m_held.erase(hit);
+
+    const auto jit = m_jobs.find(held.jobId);
+    if (jit == m_jobs.end()) {
+        return;
+    }
+    Job &job = jit->second;
+    --job.running;
+    job.pending.push_front(held.range);
+    job.requeuedUnits += 1;
+    job.requeuedSteps += held.range.last - held.range.first;
+    Tenant &t = m_tenants[job.spec.tenant];
+    t.usage = std::max(0.0, t.usage - static_cast<double>(held.range.last - held.range.first));
+}
+
+bool JobScheduler::unitPartial(int worker, quint64 unitId, quint64 steps, double value) {
+    const auto wit = m_workers.find(worker);
+    if (wit == m_workers.end() || !wit->second.busy || wit->second.unit.unitId != unitId) {
+        return false;
+    }
+    Worker &w = wit->second;
+    const quint64 length = w.range.last - w.range.first;
+    if (steps == 0 || steps % 2 != 0 || steps >= length) {
+        // Nothing usable (or the whole unit, which a complete result would have reported): start over.
+        releaseUnit(w, true);
+        return false;
+    }
+
+    const auto jit = m_jobs.find(w.unit.jobId);
+    w.range.first += steps;
+    releaseUnit(w, true);
+    if (jit == m_jobs.end()) {
+        return false;
+    }
+    jit->second.sum += value;
+    return true;
+}
+
+void JobScheduler::unitCancelled(int worker, quint64 unitId) {
+    const auto wit = m_workers.find(worker);
+    if (wit == m_workers.end() || !wit->second.busy || wit->second.unit.unitId != unitId) {
+        return;
+    }
+    releaseUnit(wit->second, true);
+}
+
+std::vector<Assignment> JobScheduler::unitFailed(int worker, const QString &error) {
+    const auto wit = m_workers.find(worker);
+    if (wit == m_workers.end() || !wit->second.busy) {
+        return {};
+    }
+    const quint64 jobId = wit->second.unit.jobId;
+    releaseUnit(wit->second, false);
+    return dropJob(jobId, JobStatus::Failed, error);
+}
+
+std::vector<JobOutcome> JobScheduler::takeFinished() {
+    std::vector<JobOutcome> out;
+    out.swap(m_finished);
+    return out;
+}
+
+std::optional<WorkUnit> JobScheduler::currentUnit(int worker) const {
+    const auto it = m_workers.find(worker);
+    if (it == m_workers.end() || !it->second.busy) {
+        return std::nullopt;
+    }
+    return it->second.unit;
+}
+
+const JobSpec *JobScheduler::job(quint64 jobId) const {
+    const auto it = m_jobs.find(jobId);
+    return (it == m_jobs.end()) ? nullptr : &it->second.spec;
+}
+
+int JobScheduler::queuedJobs() const {
+    int n = 0;
+    for (const auto &[id, job] : m_jobs) {
+        if (job.running == 0) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+int JobScheduler::runningJobs() const {
+    return static_cast<int>(m_jobs.size()) - queuedJobs();
+}
+
+} // namespace netproj
@@ -0,0 +1,340 @@
+#pragma once
+
+#include "../common/protocol.h"
+
+#include <QHash>
+#include <QString>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace netproj {
+
+/**
+ * @brief Parameters of a job as accepted by the scheduler.
+ */
+struct JobSpec {
+    double a = 0.0;
+    double b = 0.0;
+    double h = 0.0;
+    MethodType method = MethodType::Simpson;
+    QString tenant;
+    JobPriority priority = JobPriority::Normal;
+    bool federated = false; ///< Work unit of a peer coordinator; never relayed to another coordinator.
+};
+
+/**
+ * @brief Normalized identity of a job's computation, used to deduplicate concurrent identical submissions.
+ *
+ * Bounds are ordered (a reversed interval is the same computation with opposite sign); tenant and priority
+ * do not take part.
+ */
+struct JobKey {
+    double lo = 0.0;
+    double hi = 0.0;
+    double h = 0.0;
+    MethodType method = MethodType::Simpson;
+
+    /**
+     * @brief Key of a job specification.
+     */
+    static JobKey of(const JobSpec &spec);
+
+    bool operator==(const JobKey &o) const { return lo == o.lo && hi == o.hi && h == o.h && method == o.method; }
+};
+
+/**
+ * @brief Hash of a JobKey for QHash.
+ */
+size_t qHash(const JobKey &key, size_t seed = 0);
+
+/**
+ * @brief Contiguous piece of a job assigned to one worker.
+ */
+struct WorkUnit {
+    quint64 jobId = 0;
+    quint64 unitId = 0;
+    double a = 0.0;
+    double b = 0.0;
+    double h = 0.0;
+    MethodType method = MethodType::Simpson;
+};
+
+/**
+ * @brief Work unit bound to a worker (new assignment or preemption victim).
+ */
+struct Assignment {
+    int worker = 0;
+    WorkUnit unit;
+};
+
+/**
+ * @brief Final state of a job reported by the scheduler.
+ */
+struct JobOutcome {
+    quint64 jobId = 0;
+    JobStatus status = JobStatus::Ok;
+    double value = 0.0;
+    QString error;
+    quint32 requeuedUnits = 0; ///< Units handed out again after their worker was lost, preempted or rejected.
+    quint64 requeuedSteps = 0; ///< Steps of those units, an upper bound of the work computed twice.
+};
+
+/**
+ * @brief Event-driven job scheduler without any I/O.
+ *
+ * Jobs are cut into work units on the step grid and handed to idle workers. The next job is chosen by
+ * priority class first, then by weighted fair share between tenants (tenant with the smallest
+ * usage/weight, usage counted in dispatched steps), then FIFO. A job that cannot start because all workers
+ * are busy with lower-priority units preempts one of them through cancellation.
+ *
+ * Unit sizes follow each worker's predicted throughput: a worker gets about job_length * rate / total_rate /
+ * granularity, so granularity 1 reproduces a single proportional split and larger values trade a few more
+ * round trips for load balancing and fairness.
+ */
+class JobScheduler {
+public:
+    /**
+     * @brief Predicted throughput (steps/second) of a worker for a method and step, if known.
+     */
+    using RateEstimator = std::function<std::optional<double>(int worker, MethodType method, double h)>;
+
+    /**
+     * @brief Set throughput estimator. Without it (or for unknown workers) rates are proportional to cores.
+     */
+    void setRateEstimator(RateEstimator estimator) { m_rateEstimator = std::move(estimator); }
+
+    /**
+     * @brief Set assumed throughput (steps/second) of one core of a worker without a profile.
+     */
+    void setDefaultCoreRate(double stepsPerSec);
+
+    /**
+     * @brief Set fair-share weight of a tenant (default 1).
+     */
+    void setTenantWeight(const QString &tenant, double weight);
+
+    /**
+     * @brief Set number of units each worker's proportional share of a job is cut into (>= 1).
+     */
+    void setGranularity(int granularity);
+
+    /**
+     * @brief Register an idle worker.
+     * @param relay Worker is a peer coordinator; federated jobs are not assigned to it.
+     */
+    void addWorker(int worker, quint32 cores, bool relay = false);
+
+    /**
+     * @brief Remove a worker; its running unit goes back to the front of its job.
+     */
+    void removeWorker(int worker);
+
+    /**
+     * @brief Stop assigning units to a worker that is about to leave; its current unit is left to finish.
+     */
+    void drainWorker(int worker);
+
+    /**
+     * @brief Check whether a worker is registered.
+     */
+    bool hasWorker(int worker) const { return m_workers.count(worker) != 0; }
+
+    /**
+     * @brief Number of registered workers.
+     */
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+    /**
+     * @brief Queue a job. Parameters must already be validated.
+     * @return Job id.
+     */
+    quint64 submit(const JobSpec &spec);
+
+    /**
+     * @brief Raise the priority class of an active job (never lowers it).
+     */
+    void raisePriority(quint64 jobId, JobPriority priority);
+
+    /**
+     * @brief Cancel a job. Pending units are dropped.
+     * @return Running units of the job whose workers should be told to stop.
+     */
+    std::vector<Assignment> cancelJob(quint64 jobId);
+
+    /**
+     * @brief Assign units to idle workers.
+     */
+    std::vector<Assignment> schedule();
+
+    /**
+     * @brief Select running lower-priority units to cancel in favor of higher-priority jobs that have no worker.
+     *
+     * Victims stay assigned until the worker acknowledges via unitCancelled() or unitCompleted().
+     */
+    std::vector<Assignment> preempt();
+
+    /**
+     * @brief Worker finished its unit.
+     * @return false if the result is stale (unknown unit or job no longer active).
+     */
+    bool unitCompleted(int worker, quint64 unitId, double value);
+
+    /**
+     * @brief Take a finished unit off its worker without crediting it yet (e.g. while its result is verified).
+     *
+     * The worker becomes idle; the job stays active until the unit is accepted or rejected.
+     * @return false if the result is stale.
+     */
+    bool holdUnit(int worker, quint64 unitId);
+
+    /**
+     * @brief Credit a held unit.
+     */
+    void acceptHeld(quint64 unitId, double value);
+
+    /**
+     * @brief Discard a held unit; its range is queued again.
+     */
+    void rejectHeld(quint64 unitId);
+
+    /**
+     * @brief Worker handed back a unit of which only the first steps were computed; the rest is queued again.
+     * @param steps Completed steps from the unit start (even, so Simpson pairs are not split).
+     * @return false if the result is stale.
+     */
+    bool unitPartial(int worker, quint64 unitId, quint64 steps, double value);
+
+    /**
+     * @brief Worker abandoned its unit after a cancel request; the range is queued again.
+     */
+    void unitCancelled(int worker, quint64 unitId);
+
+    /**
+     * @brief Worker failed to compute its unit; the job fails.
+     * @return Other running units of the failed job whose workers should be told to stop.
+     */
+    std::vector<Assignment> unitFailed(int worker, const QString &error);
+
+    /**
+     * @brief Take outcomes of jobs finished since the last call.
+     */
+    std::vector<JobOutcome> takeFinished();
+
+    /**
+     * @brief Current unit of a worker, if busy.
+     */
+    std::optional<WorkUnit> currentUnit(int worker) const;
+
+    /**
+     * @brief Parameters of an active job, or nullptr.
+     */
+    const JobSpec *job(quint64 jobId) const;
+
+    /**
+     * @brief Number of active jobs without any running unit.
+     */
+    int queuedJobs() const;
+
+    /**
+     * @brief Number of active jobs with at least one running unit.
+     */
+    int runningJobs() const;
+
+    /**
+     * @brief Number of active (queued or running) jobs.
+     */
+    int activeJobs() const { return static_cast<int>(m_jobs.size()); }
+
+    /**
+     * @brief Number of active jobs of a tenant.
+     */
+    int tenantJobs(const QString &tenant) const;
+
+    /**
+     * @brief Steps dispatched on behalf of a tenant so far.
+     */
+    double tenantUsage(const QString &tenant) const;
+
+    /**
+     * @brief Predicted aggregate throughput (steps/second) of all workers for a method and step.
+     */
+    double capacity(MethodType method, double h) const;
+
+    /**
+     * @brief Predicted seconds until the remaining work of active jobs with at least the given priority is done.
+     * @return Infinity if there is work but no worker.
+     */
+    double backlogSeconds(JobPriority atLeast) const;
+
+private:
+    /**
+     * @brief Half-open step range [first, last) of a job.
+     */
+    struct StepRange {
+        quint64 first = 0;
+        quint64 last = 0;
+    };
+
+    struct Job {
+        quint64 id = 0;
+        JobSpec spec;
+        double lo = 0.0;
+        double hi = 0.0;
+        double sign = 1.0;
+        quint64 totalSteps = 0;
+        std::deque<StepRange> pending;
+        int running = 0;
+        double sum = 0.0;
+        quint32 requeuedUnits = 0;
+        quint64 requeuedSteps = 0;
+    };
+
+    struct Worker {
+        quint32 cores = 1;
+        bool relay = false;
+        bool draining = false;
+        bool busy = false;
+        bool cancelling = false;
+        WorkUnit unit;
+        StepRange range;
+    };
+
+    struct Tenant {
+        double weight = 1.0;
+        double usage = 0.0;
+    };
+
+    struct HeldUnit {
+        quint64 jobId = 0;
+        StepRange range;
+    };
+
+    Job *pickJob(const Worker &w);
+    std::vector<double> workerRates(MethodType method, double h) const;
+    double shareFraction(int worker, const JobSpec &spec) const;
+    StepRange carve(Job &job, int worker);
+    WorkUnit makeUnit(const Job &job, const StepRange &r);
+    void releaseUnit(Worker &w, bool requeue);
+    void maybeFinish(Job &job);
+    std::vector<Assignment> dropJob(quint64 jobId, JobStatus status, const QString &error);
+    double virtualTime(const QString &tenant) const;
+
+    RateEstimator m_rateEstimator;
+    double m_defaultCoreRate = 2e7;
+    int m_granularity = 1;
+
+    std::map<quint64, Job> m_jobs;
+    std::map<int, Worker> m_workers;
+    std::map<quint64, HeldUnit> m_held;
+    QHash<QString, Tenant> m_tenants;
+    std::vector<JobOutcome> m_finished;
+
+    quint64 m_nextJobId = 1;
+    quint64 m_nextUnitId = 1;
+};
+
+} // namespace netproj
@@ -0,0 +1,68 @@
+#include "job_trace.h"
+
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace netproj {
+
+void JobTrace::addSpan(int pid, int tid, const QString &name, qint64 startUs, qint64 endUs, const QJsonObject &args) {
+    QJsonObject e;
+    e.insert("name", name);
+    e.insert("ph", "X");
+    e.insert("pid", pid);
+    e.insert("tid", tid);
+    e.insert("ts", static_cast<double>(startUs - m_originUs));
+    e.insert("dur", static_cast<double>(std::max<qint64>(0, endUs - startUs)));
+    if (!args.isEmpty()) {
+        e.insert("args", args);
+    }
+    m_events.append(e);
+}
+
+QByteArray JobTrace::toJson() const {
+    QJsonArray events;
+    for (auto it = m_processNames.cbegin(); it != m_processNames.cend(); ++it) {
+        QJsonObject e;
+        e.insert("name", "process_name");
+        e.insert("ph", "M");
+        e.insert("pid", it.key());
+        e.insert("args", QJsonObject{{"name", it.value()}});
+        events.append(e);
+        QJsonObject order;
+        order.insert("name", "process_sort_index");
+        order.insert("ph", "M");
+        order.insert("pid", it.key());
+        order.insert("args", QJsonObject{{"sort_index", it.key()}});
+        events.append(order);
+    }
+    for (auto it = m_threadNames.cbegin(); it != m_threadNames.cend(); ++it) {
+        QJsonObject e;
+        e.insert("name", "thread_name");
+        e.insert("ph", "M");
+        e.insert("pid", it.key().first);
+        e.insert("tid", it.key().second);
+        e.insert("args", QJsonObject{{"name", it.value()}});
+        events.append(e);
+    }
+    for (const QJsonValue &e : m_events) {
+        events.append(e);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool JobTrace::save(const QString &path) const {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    f.write(toJson());
+    return f.commit();
+}
+
+} // namespace netproj
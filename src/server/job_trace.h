@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QPair>
+#include <QString>
+
+namespace netproj {
+
+/**
+ * @brief Timeline of one job in Chrome trace event format (viewable in chrome://tracing and Perfetto).
+ *
+ * Processes are the server (pid 0) and the workers; threads are lanes within them. Timestamps are given in
+ * microseconds of the server's trace clock and written relative to the job's origin.
+ */
+class JobTrace {
+public:
+    /**
+     * @brief Start a trace whose time zero is originUs.
+     */
+    explicit JobTrace(qint64 originUs = 0)
+        : m_originUs(originUs) {}
+
+    /**
+     * @brief Name a process (shown as a track group).
+     */
+    void setProcessName(int pid, const QString &name) { m_processNames.insert(pid, name); }
+
+    /**
+     * @brief Name a thread lane of a process.
+     */
+    void setThreadName(int pid, int tid, const QString &name) { m_threadNames.insert(qMakePair(pid, tid), name); }
+
+    /**
+     * @brief Add a complete span from startUs to endUs.
+     */
+    void addSpan(int pid, int tid, const QString &name, qint64 startUs, qint64 endUs,
+                 const QJsonObject &args = QJsonObject());
+
+    /**
+     * @brief Whether no span has been added.
+     */
+    bool isEmpty() const { return m_events.isEmpty(); }
+
+    /**
+     * @brief Trace JSON ({"traceEvents": [...]}).
+     */
+    QByteArray toJson() const;
+
+    /**
+     * @brief Write the trace JSON to path.
+     */
+    bool save(const QString &path) const;
+
+private:
+    qint64 m_originUs;
+    QMap<int, QString> m_processNames;
+    QMap<QPair<int, int>, QString> m_threadNames;
+    QJsonArray m_events;
+};
+
+} // namespace netproj
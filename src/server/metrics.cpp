@@ -0,0 +1,92 @@
+#include "metrics.h"
+
+#include <cmath>
+
+namespace netproj {
+
+void LatencyHistogram::record(double seconds) {
+    ++m_counts[static_cast<size_t>(bucketOf(seconds))];
+    ++m_count;
+    m_sum += seconds;
+}
+
+int LatencyHistogram::bucketOf(double seconds) {
+    if (!(seconds > kLowestSeconds)) {
+        return 0;
+    }
+    // seconds / kLowestSeconds = m * 2^e with m in [0.5, 1): octave e - 1, position 2m - 1 inside it.
+    int e = 0;
+    const double m = std::frexp(seconds / kLowestSeconds, &e);
+    const int octave = e - 1;
+    const int sub = static_cast<int>(std::ceil((2.0 * m - 1.0) * kSubBuckets));
+    // A value exactly on a power of two closes the last bucket of the previous octave.
+    const int bucket = (sub == 0) ? octave * kSubBuckets : 1 + octave * kSubBuckets + (sub - 1);
+    return (bucket < kBuckets) ? bucket : kBuckets;
+}
+
+double LatencyHistogram::upperBound(int bucket) {
+    if (bucket <= 0) {
+        return kLowestSeconds;
+    }
+    const int octave = (bucket - 1) / kSubBuckets;
+    const int sub = (bucket - 1) % kSubBuckets + 1;
+    return std::ldexp(kLowestSeconds, octave) * (1.0 + static_cast<double>(sub) / kSubBuckets);
+}
+
+static QString escapeLabel(QString v) {
+    v.replace('\\', "\\\\");
+    v.replace('"', "\\\"");
+    v.replace('\n', "\\n");
+    return v;
+}
+
+static QString formatValue(double v) {
+    if (std::isinf(v)) {
+        return (v > 0) ? QStringLiteral("+Inf") : QStringLiteral("-Inf");
+    }
+    if (std::isnan(v)) {
+        return QStringLiteral("NaN");
+    }
+    return QString::number(v, 'g', 15);
+}
+
+void PrometheusWriter::family(const QString &name, const char *type, const QString &help) {
+    m_text += "# HELP " + name.toUtf8() + ' ' + help.toUtf8() + '\n';
+    m_text += "# TYPE " + name.toUtf8() + ' ' + type + '\n';
+}
+
+void PrometheusWriter::sample(const QString &name, double value, const MetricLabels &labels) {
+    line(name, labels, formatValue(value));
+}
+
+void PrometheusWriter::histogram(const QString &name, const LatencyHistogram &h, const MetricLabels &labels) {
+    quint64 cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::kBuckets; ++i) {
+        cumulative += h.bucketCount(i);
+        MetricLabels l = labels;
+        l.append({QStringLiteral("le"), formatValue(LatencyHistogram::upperBound(i))});
+        line(name + "_bucket", l, QString::number(cumulative));
+    }
+    MetricLabels inf = labels;
+    inf.append({QStringLiteral("le"), QStringLiteral("+Inf")});
+    line(name + "_bucket", inf, QString::number(h.count()));
+    line(name + "_sum", labels, formatValue(h.sum()));
+    line(name + "_count", labels, QString::number(h.count()));
+}
+
+void PrometheusWriter::line(const QString &name, const MetricLabels &labels, const QString &value) {
+    m_text += name.toUtf8();
+    if (!labels.isEmpty()) {
+        m_text += '{';
+        for (int i = 0; i < labels.size(); ++i) {
+            if (i > 0) {
+                m_text += ',';
+            }
+            m_text += labels[i].first.toUtf8() + "=\"" + escapeLabel(labels[i].second).toUtf8() + '"';
+        }
+        m_text += '}';
+    }
+    m_text += ' ' + value.toUtf8() + '\n';
+}
+
+} // namespace netproj
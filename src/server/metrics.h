@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include <array>
+
+namespace netproj {
+
+/**
+ * @brief Latency histogram with log-linear buckets (HDR style).
+ *
+ * Every power-of-two range above kLowestSeconds is split into kSubBuckets equal buckets, so any recorded value
+ * is reported with at most 1 / kSubBuckets relative error across the whole range from 100 us to about 28 min.
+ * Values above the range only count towards +Inf.
+ */
+class LatencyHistogram {
+public:
+    static constexpr double kLowestSeconds = 1e-4;
+    static constexpr int kOctaves = 24;
+    static constexpr int kSubBuckets = 4;
+    static constexpr int kBuckets = 1 + kOctaves * kSubBuckets;
+
+    /**
+     * @brief Record one observation.
+     */
+    void record(double seconds);
+
+    /**
+     * @brief Bucket index of a value (kBuckets for values above the range).
+     */
+    static int bucketOf(double seconds);
+
+    /**
+     * @brief Inclusive upper bound of a bucket in seconds.
+     */
+    static double upperBound(int bucket);
+
+    /**
+     * @brief Observations in a bucket (not cumulative); bucket kBuckets holds values above the range.
+     */
+    quint64 bucketCount(int bucket) const { return m_counts[static_cast<size_t>(bucket)]; }
+
+    /**
+     * @brief Total number of observations.
+     */
+    quint64 count() const { return m_count; }
+
+    /**
+     * @brief Sum of all observations in seconds.
+     */
+    double sum() const { return m_sum; }
+
+private:
+    std::array<quint64, kBuckets + 1> m_counts{};
+    quint64 m_count = 0;
+    double m_sum = 0.0;
+};
+
+/**
+ * @brief Metric labels as name/value pairs.
+ */
+using MetricLabels = QList<QPair<QString, QString>>;
+
+/**
+ * @brief Builds a Prometheus text exposition (format 0.0.4).
+ */
+class PrometheusWriter {
+public:
+    /**
+     * @brief Start a metric family; samples of it must follow.
+     * @param type "counter", "gauge" or "histogram".
+     */
+    void family(const QString &name, const char *type, const QString &help);
+
+    /**
+     * @brief Add one sample.
+     */
+    void sample(const QString &name, double value, const MetricLabels &labels = {});
+
+    /**
+     * @brief Add the _bucket, _sum and _count samples of a histogram family.
+     */
+    void histogram(const QString &name, const LatencyHistogram &h, const MetricLabels &labels = {});
+
+    /**
+     * @brief Exposition text.
+     */
+    const QByteArray &text() const { return m_text; }
+
+private:
+    void line(const QString &name, const MetricLabels &labels, const QString &value);
+
+    QByteArray m_text;
+};
+
+} // namespace netproj
@@ -0,0 +1,121 @@
+#include "peer_link.h"
+
+#include "../common/message_io.h"
+
+namespace netproj {
+
+/**
+ * @brief Delay before reconnecting to a peer after a failure.
+ */
+static constexpr int kReconnectDelayMs = 5000;
+
+PeerLink::PeerLink(const QString &host, quint16 port, const QString &workerId, QObject *parent)
+    : QObject(parent),
+      m_host(host),
+      m_port(port),
+      m_workerId(workerId) {
+    m_retry.setSingleShot(true);
+    m_retry.setInterval(kReconnectDelayMs);
+    connect(&m_retry, &QTimer::timeout, this, &PeerLink::connectIfNeeded);
+    connect(&m_socket, &QTcpSocket::connected, this, &PeerLink::onConnected);
+    connect(&m_socket, &QTcpSocket::errorOccurred, this, &PeerLink::onError);
+}
+
+void PeerLink::setCores(quint32 cores) {
+    if (cores == m_cores) {
+        return;
+    }
+    m_cores = cores;
+    if (m_cores == 0) {
+        if (m_socket.state() != QAbstractSocket::UnconnectedState) {
+            qInfo() << "No local workers, leaving peer" << address();
+            m_socket.disconnectFromHost();
+        }
+        return;
+    }
+    if (m_framed) {
+        sendHello();
+        return;
+    }
+    connectIfNeeded();
+}
+
+void PeerLink::connectIfNeeded() {
+    if (m_cores == 0 || m_retry.isActive() || m_socket.state() != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+    qInfo() << "Connecting to peer" << address();
+    m_socket.connectToHost(m_host, m_port);
+}
+
+void PeerLink::sendHello() {
+    HelloMsg hello;
+    hello.cores = m_cores;
+    hello.workerId = m_workerId;
+    hello.flags = HelloCoordinator;
+    m_framed->sendFrame(serializeHello(hello));
+    qInfo() << "Offered" << m_cores << "cores to peer" << address();
+}
+
+void PeerLink::sendResult(const ResultMsg &m) {
+    if (m_framed) {
+        m_framed->sendFrame(serializeResult(m));
+    }
+}
+
+void PeerLink::sendError(const ErrorMsg &m) {
+    if (m_framed) {
+        m_framed->sendFrame(serializeError(m));
+    }
+}
+
+void PeerLink::onConnected() {
+    m_socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    m_framed = new FramedSocket(&m_socket, this);
+    connect(m_framed, &FramedSocket::frameReceived, this, &PeerLink::onFrame);
+    connect(m_framed, &FramedSocket::disconnected, this, &PeerLink::onDisconnected);
+    sendHello();
+}
+
+void PeerLink::onFrame(const QByteArray &payload) {
+    const auto pm = parseMessage(payload);
+    if (!pm.ok) {
+        qWarning() << "Failed to parse message from peer" << address() << ":" << pm.parseError;
+        return;
+    }
+
+    switch (pm.env.type) {
+    case MessageType::Task:
+        emit taskReceived(pm.task);
+        return;
+    case MessageType::Cancel:
+        emit cancelReceived(pm.cancel);
+        return;
+    case MessageType::Error:
+        qWarning() << "Peer" << address() << "ERROR:" << pm.error.text;
+        m_socket.disconnectFromHost();
+        return;
+    default:
+        qWarning() << "Unexpected message type from peer" << address();
+        return;
+    }
+}
+
+void PeerLink::onDisconnected() {
+    qWarning() << "Lost peer" << address();
+    m_framed->deleteLater();
+    m_framed = nullptr;
+    emit lost();
+    m_retry.start();
+}
+
+void PeerLink::onError(QAbstractSocket::SocketError) {
+    qWarning() << "Peer" << address() << "socket error:" << m_socket.errorString();
+    if (!m_framed) {
+        // Connection attempt failed; connected sockets are handled by onDisconnected().
+        m_retry.start();
+    }
+}
+
+} // namespace netproj
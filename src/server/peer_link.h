@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../common/framed_socket.h"
+#include "../common/protocol.h"
+
+#include <QObject>
+#include <QString>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace netproj {
+
+/**
+ * @brief Outgoing link of a coordinator to a peer coordinator of the federation.
+ *
+ * The link joins the peer as a single worker (HELLO with the HelloCoordinator flag) whose cores are the total of
+ * the local worker pool, so a busy peer can shard its jobs onto this coordinator's workers. Units received over
+ * the link are handed to the owner through signals; results go back with sendResult(). The link stays
+ * disconnected while the local pool is empty and reconnects after failures.
+ */
+class PeerLink : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct a link to host:port announcing itself as workerId.
+     */
+    PeerLink(const QString &host, quint16 port, const QString &workerId, QObject *parent = nullptr);
+
+    /**
+     * @brief Peer address as "host:port".
+     */
+    QString address() const { return m_host + ":" + QString::number(m_port); }
+
+    /**
+     * @brief Update the advertised capacity. Zero disconnects, a change re-sends HELLO.
+     */
+    void setCores(quint32 cores);
+
+    /**
+     * @brief Send a unit result to the peer (dropped if not connected).
+     */
+    void sendResult(const ResultMsg &m);
+
+    /**
+     * @brief Report a unit failure to the peer (dropped if not connected).
+     */
+    void sendError(const ErrorMsg &m);
+
+signals:
+    /**
+     * @brief Peer assigned a unit to this coordinator.
+     */
+    void taskReceived(const TaskMsg &t);
+
+    /**
+     * @brief Peer asked to stop a unit.
+     */
+    void cancelReceived(const CancelMsg &m);
+
+    /**
+     * @brief Connection to the peer was lost; units received over it are void.
+     */
+    void lost();
+
+private slots:
+    void onConnected();
+    void onFrame(const QByteArray &payload);
+    void onDisconnected();
+    void onError(QAbstractSocket::SocketError);
+
+private:
+    void connectIfNeeded();
+    void sendHello();
+
+    QString m_host;
+    quint16 m_port = 0;
+    QString m_workerId;
+    quint32 m_cores = 0;
+    QTcpSocket m_socket;
+    FramedSocket *m_framed = nullptr;
+    QTimer m_retry;
+};
+
+} // namespace netproj
@@ -0,0 +1,79 @@
+#include "result_verifier.h"
+
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+namespace netproj {
+
+ResultVerifier::ResultVerifier(int blocks, int samples, double relTolerance)
+    : m_blocks(std::max(0, blocks)), m_samples(std::max(1, samples)), m_relTolerance(relTolerance) {
+}
+
+std::vector<Segment> ResultVerifier::unitBlocks(const WorkUnit &unit) const {
+    return Integrator::partition(unit.a, unit.b, unit.h, m_blocks);
+}
+
+bool ResultVerifier::matches(double reported, double expected) const {
+    if (!std::isfinite(reported) || !std::isfinite(expected)) {
+        return false;
+    }
+    const double scale = std::max({std::abs(reported), std::abs(expected), 1e-300});
+    return std::abs(reported - expected) <= m_relTolerance * scale + 1e-15;
+}
+
+QString ResultVerifier::checkConsistency(const WorkUnit &unit, const ResultMsg &result) const {
+    const size_t expected = unitBlocks(unit).size();
+    if (static_cast<size_t>(result.blockSums.size()) != expected) {
+        return QString("expected %1 block sums, got %2").arg(expected).arg(result.blockSums.size());
+    }
+
+    double sum = 0.0;
+    for (const double v : result.blockSums) {
+        sum += v;
+    }
+    if (!matches(result.value, sum)) {
+        return QString("block sums add up to %1 but value is %2").arg(sum, 0, 'g', 17).arg(result.value, 0, 'g', 17);
+    }
+    return QString();
+}
+
+std::vector<int> ResultVerifier::pickSamples(int blockCount, QRandomGenerator &rng) const {
+    std::vector<int> all(static_cast<size_t>(std::max(0, blockCount)));
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = static_cast<int>(i);
+    }
+    const size_t n = std::min(all.size(), static_cast<size_t>(m_samples));
+    // Partial Fisher-Yates shuffle: the first n entries are a uniform sample without repetition.
+    for (size_t i = 0; i < n; ++i) {
+        const size_t j = i + static_cast<size_t>(rng.bounded(static_cast<quint32>(all.size() - i)));
+        std::swap(all[i], all[j]);
+    }
+    all.resize(n);
+    return all;
+}
+
+QString ResultVerifier::recheck(const WorkUnit &unit, const std::vector<Segment> &blocks,
+                                const std::vector<int> &samples, const QVector<double> &reported) const {
+    for (const int i : samples) {
+        const Segment &s = blocks[static_cast<size_t>(i)];
+        double expected = 0.0;
+        try {
+            expected = Integrator::integrate(s.a, s.b, unit.h, unit.method);
+        } catch (const std::exception &e) {
+            return QString("recomputing block %1 failed: %2").arg(i).arg(QString::fromUtf8(e.what()));
+        }
+        const double got = reported[i];
+        if (!matches(got, expected)) {
+            return QString("block %1 reported %2, recomputed %3")
+                .arg(i)
+                .arg(got, 0, 'g', 17)
+                .arg(expected, 0, 'g', 17);
+        }
+    }
+    return QString();
+}
+
+} // namespace netproj
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../common/integrator.h"
+#include "../common/protocol.h"
+#include "job_scheduler.h"
+
+#include <QString>
+
+#include <vector>
+
+class QRandomGenerator;
+
+namespace netproj {
+
+/**
+ * @brief Spot checks of worker results for untrusted clients.
+ *
+ * Tasks ask the worker to report per-block partial sums over Integrator::partition(a, b, h, blocks). The server
+ * checks that the blocks add up to the reported value and recomputes a few randomly chosen blocks itself, so a
+ * faulty or dishonest worker is caught with probability growing with every unit it returns, at samples/blocks of
+ * the cost of full duplication.
+ */
+class ResultVerifier {
+public:
+    /**
+     * @brief Construct a verifier.
+     * @param blocks Blocks per unit (0 disables verification).
+     * @param samples Blocks recomputed per unit.
+     * @param relTolerance Allowed relative difference between reported and recomputed block sums.
+     */
+    explicit ResultVerifier(int blocks = 0, int samples = 1, double relTolerance = 1e-9);
+
+    /**
+     * @brief Whether tasks carry verification blocks.
+     */
+    bool enabled() const { return m_blocks > 0; }
+
+    /**
+     * @brief Blocks per unit requested from workers.
+     */
+    int blocks() const { return m_blocks; }
+
+    /**
+     * @brief Blocks of a unit, identical to the ones the worker used.
+     */
+    std::vector<Segment> unitBlocks(const WorkUnit &unit) const;
+
+    /**
+     * @brief Cheap structural check of a result: block count and block sums adding up to the value.
+     * @return Empty string if consistent, otherwise a description of the problem.
+     */
+    QString checkConsistency(const WorkUnit &unit, const ResultMsg &result) const;
+
+    /**
+     * @brief Choose distinct block indices to recompute.
+     */
+    std::vector<int> pickSamples(int blockCount, QRandomGenerator &rng) const;
+
+    /**
+     * @brief Recompute sampled blocks and compare them with the reported sums (runs on any thread).
+     * @return Empty string if all samples match, otherwise a description of the first mismatch.
+     */
+    QString recheck(const WorkUnit &unit, const std::vector<Segment> &blocks, const std::vector<int> &samples,
+                    const QVector<double> &reported) const;
+
+    /**
+     * @brief Compare a reported and an expected value with relative tolerance.
+     */
+    bool matches(double reported, double expected) const;
+
+private:
+    int m_blocks;
+    int m_samples;
+    double m_relTolerance;
+};
+
+} // namespace netproj
@@ -0,0 +1,1262 @@
+#include "server_app.h"
+
+#include "../common/async_log.h"
+#include "../common/integrator.h"
+#include "../common/message_io.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFutureWatcher>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <exception>
+
+#ifdef NETPROJ_COUNT_ALLOCATIONS
+#include "../common/alloc_counter.h"
+#endif
+
+namespace netproj {
+
+/**
+ * @brief Round trips per clock synchronisation burst.
+ */
+static constexpr quint32 kClockSyncPings = 8;
+
+/**
+ * @brief Interval of clock re-synchronisation, bounding the effect of clock drift on traces.
+ */
+static constexpr int kClockResyncMs = 60000;
+
+/**
+ * @brief Delay of saving changed worker profiles, so a burst of finished units costs one write.
+ */
+static constexpr int kProfileSaveDelayMs = 10000;
+
+/**
+ * @brief Connection id standing for the HTTP gateway as submitter; real connections are numbered from 1.
+ */
+static constexpr int kGatewayConnection = 0;
+
+ServerApp::ServerApp(QObject *parent)
+    : QObject(parent) {
+    connect(&m_server, &QTcpServer::newConnection, this, &ServerApp::onNewConnection);
+    connect(&m_clockTimer, &QTimer::timeout, this, &ServerApp::resyncClocks);
+    m_profileSaveTimer.setSingleShot(true);
+    connect(&m_profileSaveTimer, &QTimer::timeout, this, &ServerApp::saveProfiles);
+    connect(&m_recordFlushTimer, &QTimer::timeout, this, [this]() { m_recorder.flush(); });
+
+    m_oneShotSpec.a = 2.0;
+    m_oneShotSpec.b = 10.0;
+    m_oneShotSpec.h = 1e-4;
+    m_oneShotSpec.method = MethodType::Simpson;
+    m_oneShotSpec.tenant = "default";
+
+    m_scheduler.setRateEstimator([this](int worker, MethodType method, double h) -> std::optional<double> {
+        if (m_profilesPath.isEmpty()) {
+            return std::nullopt;
+        }
+        const auto it = m_connections.constFind(worker);
+        if (it == m_connections.constEnd() || it->workerId.isEmpty()) {
+            return std::nullopt;
+        }
+        return m_profiles.rate(it->workerId, method, h, QDateTime::currentMSecsSinceEpoch());
+    });
+}
+
+ServerApp::~ServerApp() {
+    saveProfiles();
+}
+
+bool ServerApp::setProfilesPath(const QString &path) {
+    m_profilesPath = path;
+    if (m_profilesPath.isEmpty()) {
+        return true;
+    }
+    if (!m_profiles.load(m_profilesPath)) {
+        qCritical() << "Failed to load worker profiles from" << m_profilesPath;
+        return false;
+    }
+    qInfo() << "Loaded" << m_profiles.size() << "worker profile entries from" << m_profilesPath;
+    return true;
+}
+
+bool ServerApp::listen(quint16 port) {
+    if (!m_server.listen(QHostAddress::Any, port)) {
+        qCritical() << "Server listen failed:" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ServerApp::start(quint16 port, int expectedClients) {
+    m_expectedClients = expectedClients;
+    if (!listen(port)) {
+        return false;
+    }
+    qInfo() << "Server listening on port" << port << ", expecting" << expectedClients << "clients";
+    return true;
+}
+
+bool ServerApp::startService(quint16 port) {
+    m_serviceMode = true;
+    if (!listen(port)) {
+        return false;
+    }
+    qInfo() << "Server listening on port" << port << "in service mode";
+    return true;
+}
+
+void ServerApp::setTask(double a, double b, double h, MethodType method) {
+    m_oneShotSpec.a = a;
+    m_oneShotSpec.b = b;
+    m_oneShotSpec.h = h;
+    m_oneShotSpec.method = method;
+}
+
+void ServerApp::setJobFile(const std::vector<SubmitMsg> &jobs, const QString &outPath) {
+    m_batch = jobs;
+    m_batchOutPath = outPath;
+}
+
+void ServerApp::addPeer(const QString &host, quint16 port) {
+    const int peer = static_cast<int>(m_peers.size());
+    const QString self = "coordinator@" + QSysInfo::machineHostName() + ":" + QString::number(m_server.serverPort());
+    auto *link = new PeerLink(host, port, self, this);
+    m_peers.push_back(link);
+
+    connect(link, &PeerLink::taskReceived, this, [this, peer](const TaskMsg &t) {
+        handlePeerTask(peer, t);
+    });
+    connect(link, &PeerLink::cancelReceived, this, [this, peer](const CancelMsg &m) {
+        handlePeerCancel(peer, m);
+    });
+    connect(link, &PeerLink::lost, this, [this, peer]() {
+        dropPeerUnits(peer);
+    });
+    qInfo() << "Federated with peer" << link->address();
+    updatePeerCores();
+}
+
+bool ServerApp::setTraceDir(const QString &dir) {
+    m_traceDir = dir;
+    if (m_traceDir.isEmpty()) {
+        m_clockTimer.stop();
+        return true;
+    }
+    if (!QDir().mkpath(m_traceDir)) {
+        qCritical() << "Cannot create trace directory" << m_traceDir;
+        return false;
+    }
+    m_clockTimer.start(kClockResyncMs);
+    qInfo() << "Writing job traces to" << m_traceDir;
+    return true;
+}
+
+bool ServerApp::startMetrics(quint16 port, const QHostAddress &address) {
+    m_metricsHttp.route("GET", "/metrics", [this](const HttpRequest &) {
+        HttpResponse r;
+        r.contentType = "text/plain; version=0.0.4; charset=utf-8";
+        r.body = metricsText();
+        return r;
+    });
+    if (!m_metricsHttp.listen(port, address)) {
+        return false;
+    }
+    qInfo() << "Serving metrics on" << address.toString() << "http port" << port << "at /metrics";
+    return true;
+}
+
+bool ServerApp::startGateway(quint16 port, const QHostAddress &address) {
+    m_gateway.setSubmitter([this](const std::vector<SubmitMsg> &jobs) {
+        submitGatewayJobs(jobs);
+    });
+    if (!m_gateway.listen(port, address)) {
+        return false;
+    }
+    qInfo() << "Accepting jobs on" << address.toString() << "http port" << port << "at /jobs";
+    return true;
+}
+
+bool ServerApp::setHistoryPath(const QString &path) {
+    if (path.isEmpty()) {
+        m_history.close();
+        return true;
+    }
+    if (!m_history.open(path)) {
+        qCritical() << "Cannot open job history" << path << ":" << m_history.error();
+        return false;
+    }
+    qInfo() << "Recording completed jobs to" << path << "(" << m_history.size() << "jobs so far)";
+    return true;
+}
+
+bool ServerApp::setRecordPath(const QString &path) {
+    if (!m_recorder.open(path)) {
+        qCritical() << "Cannot record session to" << path;
+        return false;
+    }
+    m_recordFlushTimer.start(SessionRecorder::kFlushIntervalMs);
+    qInfo() << "Recording session to" << path;
+    return true;
+}
+
+void ServerApp::onNewConnection() {
+    while (QTcpSocket *sock = m_server.nextPendingConnection()) {
+        sock->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        auto *framed = new FramedSocket(sock, sock);
+        framed->setCounters(&m_traffic);
+        const int id = m_nextConnectionId++;
+        if (m_recorder.isOpen()) {
+            m_recorder.record(static_cast<quint32>(id), SessionEvent::Open);
+            framed->setFrameTap([this, id](bool outbound, const QByteArray &payload) {
+                m_recorder.record(static_cast<quint32>(id), outbound ? SessionEvent::Out : SessionEvent::In, payload);
+            });
+        }
+        Connection c;
+        c.framed = framed;
+        m_connections.insert(id, c);
+
+        qInfo() << "Connection" << id << "from" << sock->peerAddress().toString() << ":" << sock->peerPort();
+
+        connect(framed, &FramedSocket::frameReceived, this, [this, id](const QByteArray &payload) {
+            onFrame(id, payload);
+        });
+        connect(framed, &FramedSocket::disconnected, this, [this, id]() {
+            onConnectionClosed(id);
+        });
+    }
+}
+
+void ServerApp::onConnectionClosed(int id) {
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end()) {
+        return;
+    }
+    const Connection c = *it;
+    m_connections.erase(it);
+    c.framed->socket()->deleteLater();
+    m_recorder.record(static_cast<quint32>(id), SessionEvent::Close);
+
+    if (c.role == Role::Worker) {
+        qWarning() << "Worker" << id << "disconnected";
+        m_scheduler.removeWorker(id);
+    } else if (c.role == Role::Submitter) {
+        qInfo() << "Submitter" << id << "disconnected";
+        // Jobs nobody waits for any more are cancelled.
+        std::vector<quint64> orphaned;
+        for (auto t = m_tickets.begin(); t != m_tickets.end(); ++t) {
+            auto &subs = t->subscribers;
+            const bool had = !subs.isEmpty();
+            subs.removeIf([id](const Subscriber &s) { return s.connection == id; });
+            if (had && subs.isEmpty() && t.key() != m_oneShotJobId) {
+                orphaned.push_back(t.key());
+            }
+        }
+        for (const quint64 jobId : orphaned) {
+            qInfo() << "Cancelling orphaned job" << jobId;
+            sendCancels(m_scheduler.cancelJob(jobId));
+        }
+    }
+    pump();
+}
+
+void ServerApp::onFrame(int id, const QByteArray &payload) {
+    const ParsedMessage &pm = m_codec.parse(payload);
+    if (!pm.ok) {
+        qWarning() << "Failed to parse message from connection" << id << ":" << pm.parseError;
+        return;
+    }
+    ++m_messagesIn[pm.env.type];
+
+    switch (pm.env.type) {
+    case MessageType::Hello:
+        handleHello(id, pm.hello);
+        return;
+    case MessageType::Result:
+        handleResult(id, pm.result);
+        return;
+    case MessageType::Error:
+        handleWorkerError(id, pm.error);
+        return;
+    case MessageType::Drain:
+        handleDrain(id, pm.drain);
+        return;
+    case MessageType::Pong:
+        handlePong(id, pm.pong);
+        return;
+    case MessageType::Submit:
+        handleSubmit(id, pm.submit);
+        return;
+    default:
+        qWarning() << "Unexpected message type from connection" << id;
+        return;
+    }
+}
+
+void ServerApp::handleHello(int id, const HelloMsg &m) {
+    // A frame read together with one that made us close the connection finds it already removed.
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end()) {
+        return;
+    }
+    Connection &c = *it;
+    if (c.role == Role::Submitter) {
+        qWarning() << "HELLO from submitter connection" << id << "ignored";
+        return;
+    }
+    if (!m.workerId.isEmpty() && m_quarantined.contains(m.workerId)) {
+        qWarning() << "Refusing quarantined worker" << m.workerId << "on connection" << id;
+        ErrorMsg err;
+        err.text = "worker is quarantined after failed result verification";
+        c.framed->sendFrame(serializeError(err));
+        c.framed->socket()->disconnectFromHost();
+        return;
+    }
+    if (c.role == Role::Worker) {
+        // Peer coordinators re-announce themselves when their pool changes.
+        c.cores = m.cores;
+        m_scheduler.addWorker(id, m.cores, c.coordinator);
+        qInfo() << "HELLO update from client" << id << ", cores=" << c.cores;
+        pump();
+        return;
+    }
+    c.role = Role::Worker;
+    c.cores = m.cores;
+    c.workerId = m.workerId;
+    c.coordinator = (m.flags & HelloCoordinator) != 0;
+    c.workerIndex = m_nextWorkerIndex++;
+    m_scheduler.addWorker(id, m.cores, c.coordinator);
+    qInfo() << "HELLO from" << (c.coordinator ? "peer coordinator" : "client") << id << ", cores=" << c.cores
+            << ", id=" << c.workerId;
+
+    if (!m_traceDir.isEmpty() && !c.coordinator) {
+        sendPing(id, 0);
+    }
+
+    if (!m_serviceMode && m_scheduler.workerCount() == m_expectedClients) {
+        qInfo() << "All clients connected.";
+    }
+    maybeStartOneShot();
+    pump();
+}
+
+void ServerApp::handleResult(int id, const ResultMsg &m) {
+    const auto it = m_connections.constFind(id);
+    if (it == m_connections.constEnd() || it->role != Role::Worker) {
+        qWarning() << "RESULT from non-worker connection" << id;
+        return;
+    }
+
+    if (m.flags & ResultCancelled) {
+        qCDebug(lcMessages) << "Unit" << m.unitId << "of job" << m.jobId << "cancelled by client" << id;
+        m_scheduler.unitCancelled(id, m.unitId);
+        pump();
+        return;
+    }
+
+    if (m.flags & ResultPartial) {
+        // Partial sums carry no block breakdown to verify, so with verification the whole unit is redone.
+        if (!m_verifier.enabled() && m_scheduler.unitPartial(id, m.unitId, m.doneSteps, m.value)) {
+            qInfo() << "Partial RESULT from draining client" << id << "job" << m.jobId << "unit" << m.unitId << ":"
+                    << m.doneSteps << "steps, rest requeued";
+        } else {
+            qInfo() << "Unit" << m.unitId << "of job" << m.jobId << "handed back by draining client" << id;
+            m_scheduler.unitCancelled(id, m.unitId);
+        }
+        pump();
+        return;
+    }
+
+    const auto unit = m_scheduler.currentUnit(id);
+    const bool current = unit && unit->unitId == m.unitId;
+    const QString workerId = it->workerId;
+    const qint64 roundTripNs = it->unitTimer.isValid() ? it->unitTimer.nsecsElapsed() : -1;
+    if (current && !m_traceDir.isEmpty()) {
+        traceUnit(*it, m);
+    }
+
+    // Profiles and throughput only learn from units that are accepted, not from a worker about to be quarantined.
+    if (m_verifier.enabled() && current) {
+        const QString problem = m_verifier.checkConsistency(*unit, m);
+        if (!problem.isEmpty()) {
+            quarantine(id, problem);
+            pump();
+            return;
+        }
+        if (m_scheduler.holdUnit(id, m.unitId)) {
+            startVerification(id, *unit, m, roundTripNs);
+        }
+        pump();
+        return;
+    }
+
+    if (m_scheduler.unitCompleted(id, m.unitId, m.value)) {
+        if (current) {
+            recordProfile(workerId, *unit, roundTripNs);
+            recordUnitStats(workerId, *unit, m, roundTripNs);
+        }
+        qCDebug(lcMessages) << "RESULT from client" << id << "job" << m.jobId << "unit" << m.unitId << ":" << m.value;
+    } else {
+        qCDebug(lcMessages) << "Ignoring stale RESULT from client" << id << "job" << m.jobId << "unit" << m.unitId;
+    }
+    pump();
+}
+
+void ServerApp::handleWorkerError(int id, const ErrorMsg &m) {
+    qWarning() << "ERROR from client" << id << ":" << m.text;
+    sendCancels(m_scheduler.unitFailed(id, m.text));
+    pump();
+}
+
+void ServerApp::handleDrain(int id, const DrainMsg &m) {
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->role != Role::Worker) {
+        qWarning() << "DRAIN from non-worker connection" << id;
+        return;
+    }
+    it->draining = true;
+    m_scheduler.drainWorker(id);
+    qInfo() << "Client" << id << "(" << it->workerId << ") is draining, deadline" << m.deadlineMs << "ms";
+    pump();
+}
+
+void ServerApp::handlePong(int id, const PongMsg &m) {
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->role != Role::Worker) {
+        return;
+    }
+    it->nextClock.addSample(m.serverUs, m.receivedUs, m.sentUs, traceClockUs());
+    if (m.seq + 1 < kClockSyncPings) {
+        sendPing(id, m.seq + 1);
+        return;
+    }
+    it->clock = it->nextClock;
+    it->nextClock = ClockSync();
+    qInfo() << "Clock of client" << id << "synchronised: offset" << it->clock.offsetUs() << "us, round trip"
+            << it->clock.rttUs() << "us";
+}
+
+void ServerApp::sendPing(int id, quint32 seq) {
+    const auto it = m_connections.constFind(id);
+    if (it == m_connections.constEnd()) {
+        return;
+    }
+    PingMsg m;
+    m.seq = seq;
+    m.serverUs = traceClockUs();
+    it->framed->sendFrame(m_codec.serialize(MessageType::Ping, m));
+}
+
+void ServerApp::resyncClocks() {
+    for (auto it = m_connections.cbegin(); it != m_connections.cend(); ++it) {
+        if (it->role == Role::Worker && !it->coordinator) {
+            sendPing(it.key(), 0);
+        }
+    }
+}
+
+void ServerApp::handleSubmit(int id, const SubmitMsg &m) {
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end()) {
+        return;
+    }
+    Connection &c = *it;
+    if (c.role == Role::Worker) {
+        qWarning() << "SUBMIT from worker connection" << id << "ignored";
+        return;
+    }
+    c.role = Role::Submitter;
+    admit(id, m);
+    pump();
+}
+
+void ServerApp::submitGatewayJobs(const std::vector<SubmitMsg> &jobs) {
+    // One scheduling pass for every job that arrived over HTTP since the last one.
+    qInfo() << "GATEWAY batch of" << jobs.size() << "jobs," << m_gateway.pendingCount() << "pending";
+    for (const SubmitMsg &m : jobs) {
+        admit(kGatewayConnection, m);
+    }
+    pump();
+}
+
+void ServerApp::admit(int id, const SubmitMsg &m) {
+    JobResultMsg reject;
+    reject.requestId = m.requestId;
+    reject.status = JobStatus::Failed;
+
+    const quint8 method = static_cast<quint8>(m.method);
+    if (method < static_cast<quint8>(MethodType::MidpointRectangles) || method > static_cast<quint8>(MethodType::Simpson)) {
+        reject.error = "Unknown method";
+        sendJobResult(id, reject);
+        return;
+    }
+    if (static_cast<quint8>(m.priority) > static_cast<quint8>(JobPriority::Interactive)) {
+        reject.error = "Unknown priority class";
+        sendJobResult(id, reject);
+        return;
+    }
+    try {
+        Integrator::validate(m.a, m.b, m.h);
+    } catch (const std::exception &e) {
+        reject.error = QString::fromUtf8(e.what());
+        sendJobResult(id, reject);
+        return;
+    }
+
+    JobSpec spec;
+    spec.a = m.a;
+    spec.b = m.b;
+    spec.h = m.h;
+    spec.method = m.method;
+    spec.tenant = m.tenant.isEmpty() ? QStringLiteral("default") : m.tenant;
+    spec.priority = m.priority;
+
+    if (m_resultCache && m_history.isOpen()) {
+        const std::optional<JobRecord> cached = m_history.latestOk(spec.a, spec.b, spec.h, spec.method);
+        if (cached) {
+            JobResultMsg r;
+            r.requestId = m.requestId;
+            r.status = JobStatus::Ok;
+            // Job id 0: nothing ran. The recorded run may have integrated the other way round.
+            r.value = ((cached->b < cached->a) == (m.b < m.a)) ? cached->value : -cached->value;
+            ++m_cacheHits;
+            sendJobResult(id, r);
+            qInfo() << "SUBMIT from" << id << "request" << m.requestId << "answered from the job history (job"
+                    << cached->jobId << "at" << QDateTime::fromMSecsSinceEpoch(cached->finishedMs).toString(Qt::ISODate)
+                    << ")";
+            return;
+        }
+    }
+
+    const JobKey key = JobKey::of(spec);
+    Subscriber sub;
+    sub.connection = id;
+    sub.requestId = m.requestId;
+    sub.sign = (m.b < m.a) ? -1.0 : 1.0;
+    sub.timer.start();
+
+    if (m_dedup) {
+        const auto inflight = m_inflight.constFind(key);
+        if (inflight != m_inflight.constEnd()) {
+            const quint64 jobId = *inflight;
+            m_scheduler.raisePriority(jobId, spec.priority);
+            m_tickets[jobId].subscribers.push_back(sub);
+            qInfo() << "SUBMIT from" << id << "request" << m.requestId << "attached to in-flight job" << jobId;
+            return;
+        }
+    }
+
+    const AdmissionDecision adm = m_admission.evaluate(spec, m_scheduler);
+    if (adm.kind != AdmissionDecision::Kind::Admit) {
+        JobResultMsg r;
+        r.requestId = m.requestId;
+        r.status = (adm.kind == AdmissionDecision::Kind::Defer) ? JobStatus::Deferred : JobStatus::Rejected;
+        r.error = adm.reason;
+        r.retryAfterMs = adm.retryAfterMs;
+        sendJobResult(id, r);
+        qInfo() << "SUBMIT from" << id << "request" << m.requestId << jobStatusName(r.status) << ":" << adm.reason;
+        return;
+    }
+
+    // Jobs run on the ordered interval; each subscriber gets the value with its own orientation.
+    spec.a = key.lo;
+    spec.b = key.hi;
+
+    const quint64 jobId = submitJob(spec);
+    JobTicket &ticket = m_tickets[jobId];
+    ticket.key = key;
+    ticket.subscribers.push_back(sub);
+    m_inflight.insert(key, jobId);
+    qInfo() << "SUBMIT from" << id << "request" << m.requestId << "-> job" << jobId << ", tenant=" << spec.tenant
+            << ", priority=" << priorityName(spec.priority) << ", method=" << methodName(spec.method)
+            << ", interval=[" << m.a << "," << m.b << "], h=" << spec.h;
+}
+
+quint64 ServerApp::submitJob(const JobSpec &spec) {
+    const quint64 jobId = m_scheduler.submit(spec);
+    ++m_jobsSubmitted;
+    JobTicket &t = m_tickets[jobId];
+    t.spec = spec;
+    t.timer.start();
+    t.submitUs = traceClockUs();
+    if (!m_traceDir.isEmpty()) {
+        t.trace = JobTrace(t.submitUs);
+        t.trace.setProcessName(0, "server");
+        t.trace.setThreadName(0, 0, "scheduler");
+    }
+    return jobId;
+}
+
+void ServerApp::maybeStartOneShot() {
+    if (m_serviceMode || m_oneShotJobId != 0 || m_expectedClients <= 0) {
+        return;
+    }
+    if (m_scheduler.workerCount() < m_expectedClients) {
+        return;
+    }
+
+    if (!m_batch.empty()) {
+        qInfo() << "Dispatching" << m_batch.size() << "jobs from job file. Workers=" << m_scheduler.workerCount();
+        startBatchJob();
+        return;
+    }
+    qInfo() << "Dispatching tasks. Workers=" << m_scheduler.workerCount() << ", method=" << methodName(m_oneShotSpec.method)
+            << ", interval=[" << m_oneShotSpec.a << "," << m_oneShotSpec.b << "], h=" << m_oneShotSpec.h;
+    m_oneShotJobId = submitJob(m_oneShotSpec);
+}
+
+void ServerApp::startBatchJob() {
+    const SubmitMsg &m = m_batch[m_batchResults.size()];
+    JobSpec spec;
+    spec.a = m.a;
+    spec.b = m.b;
+    spec.h = m.h;
+    spec.method = m.method;
+    spec.tenant = m.tenant.isEmpty() ? QStringLiteral("default") : m.tenant;
+    spec.priority = m.priority;
+    m_oneShotJobId = submitJob(spec);
+}
+
+void ServerApp::finishBatchJob(const JobResultMsg &r) {
+    const size_t index = m_batchResults.size();
+    m_batchResults.push_back({m_batch[index], r});
+    qInfo() << "BATCH JOB" << index + 1 << "of" << m_batch.size() << jobStatusName(r.status) << ": value=" << r.value
+            << ", time=" << r.elapsedMs << "ms";
+    if (m_batchResults.size() < m_batch.size()) {
+        // Back to back: every job gets the whole pool, so its timings are comparable across the sweep. Finished jobs
+        // are handled at the end of pump(), so the next one is scheduled from the event loop rather than recursively.
+        QTimer::singleShot(0, this, [this]() {
+            startBatchJob();
+            pump();
+        });
+        return;
+    }
+
+    int failed = 0;
+    for (const JobFileResult &res : m_batchResults) {
+        failed += (res.result.status != JobStatus::Ok) ? 1 : 0;
+    }
+    qInfo() << "BATCH DONE:" << m_batchResults.size() << "jobs," << failed << "failed";
+    if (m_batchOutPath.isEmpty()) {
+        QTextStream out(stdout);
+        out << jobResultsCsv(m_batchResults) << Qt::flush;
+    } else if (saveJobResults(m_batchOutPath, m_batchResults)) {
+        qInfo() << "Results written to" << m_batchOutPath;
+    } else {
+        qCritical() << "Failed to write results to" << m_batchOutPath;
+        failed = std::max(failed, 1);
+    }
+    quitOneShot(failed == 0 ? 0 : 1);
+}
+
+void ServerApp::pump() {
+    for (const Assignment &as : m_scheduler.schedule()) {
+        sendTask(as);
+    }
+    sendCancels(m_scheduler.preempt());
+    for (const JobOutcome &o : m_scheduler.takeFinished()) {
+        finishJob(o);
+    }
+    updatePeerCores();
+}
+
+void ServerApp::sendTask(const Assignment &as) {
+    auto it = m_connections.find(as.worker);
+    if (it == m_connections.end()) {
+        return;
+    }
+
+    TaskMsg t;
+    t.a = as.unit.a;
+    t.b = as.unit.b;
+    t.h = as.unit.h;
+    t.method = as.unit.method;
+    t.clientIndex = it->workerIndex;
+    t.clientCount = static_cast<quint32>(m_scheduler.workerCount());
+    t.jobId = as.unit.jobId;
+    t.unitId = as.unit.unitId;
+
+    t.verifyBlocks = static_cast<quint32>(m_verifier.blocks());
+    if (!m_traceDir.isEmpty()) {
+        t.flags |= TaskTrace;
+    }
+
+    const qint64 nowUs = traceClockUs();
+    const auto ticket = m_tickets.find(t.jobId);
+    if (ticket != m_tickets.end() && ticket->dispatchMs < 0) {
+        ticket->dispatchMs = ticket->timer.elapsed();
+        ticket->firstDispatchUs = nowUs;
+    }
+
+    it->unitTimer.start();
+    it->unitSentUs = nowUs;
+    it->framed->sendFrame(m_codec.serialize(MessageType::Task, t));
+    qCDebug(lcMessages) << "Sent TASK to client" << as.worker << "job" << t.jobId << "unit" << t.unitId << ": [" << t.a
+                        << "," << t.b << "]";
+}
+
+void ServerApp::sendCancels(const std::vector<Assignment> &victims) {
+    for (const Assignment &as : victims) {
+        const auto it = m_connections.constFind(as.worker);
+        if (it == m_connections.constEnd()) {
+            continue;
+        }
+        CancelMsg m;
+        m.jobId = as.unit.jobId;
+        m.unitId = as.unit.unitId;
+        it->framed->sendFrame(m_codec.serialize(MessageType::Cancel, m));
+        qCDebug(lcMessages) << "Sent CANCEL to client" << as.worker << "job" << m.jobId << "unit" << m.unitId;
+    }
+}
+
+void ServerApp::sendJobResult(int connection, const JobResultMsg &m) {
+    if (connection == kGatewayConnection) {
+        m_gateway.deliver(m);
+        return;
+    }
+    const auto it = m_connections.constFind(connection);
+    if (it == m_connections.constEnd()) {
+        return;
+    }
+    it->framed->sendFrame(serializeJobResult(m));
+}
+
+void ServerApp::startVerification(int id, const WorkUnit &unit, const ResultMsg &m, qint64 roundTripNs) {
+    const std::vector<Segment> blocks = m_verifier.unitBlocks(unit);
+    const std::vector<int> samples = m_verifier.pickSamples(static_cast<int>(blocks.size()), *QRandomGenerator::global());
+    const QString workerId = m_connections.value(id).workerId;
+    const qint64 startUs = traceClockUs();
+
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this,
+            [this, watcher, id, workerId, unit, m, startUs, roundTripNs]() {
+                watcher->deleteLater();
+                const QString problem = watcher->result();
+                const auto ticket = m_tickets.find(m.jobId);
+                if (!m_traceDir.isEmpty() && ticket != m_tickets.end()) {
+                    ticket->trace.addSpan(0, 0, "verify unit " + QString::number(m.unitId), startUs, traceClockUs(),
+                                          QJsonObject{{"ok", problem.isEmpty()}});
+                }
+                if (problem.isEmpty()) {
+                    ++m_verifiedUnits;
+                    m_scheduler.acceptHeld(unit.unitId, m.value);
+                    recordProfile(workerId, unit, roundTripNs);
+                    recordUnitStats(workerId, unit, m, roundTripNs);
+                    qCDebug(lcMessages) << "RESULT from client" << id << "job" << m.jobId << "unit" << m.unitId << ":"
+                                        << m.value << "(verified)";
+                } else {
+                    m_scheduler.rejectHeld(unit.unitId);
+                    if (m_connections.contains(id)) {
+                        quarantine(id, problem);
+                    } else {
+                        qCritical() << "Result verification failed for departed worker" << workerId << ":" << problem;
+                        if (!workerId.isEmpty()) {
+                            m_quarantined.insert(workerId);
+                        }
+                    }
+                }
+                pump();
+            });
+
+    const ResultVerifier verifier = m_verifier;
+    watcher->setFuture(QtConcurrent::run([verifier, unit, blocks, samples, sums = m.blockSums]() {
+        return verifier.recheck(unit, blocks, samples, sums);
+    }));
+}
+
+void ServerApp::quarantine(int id, const QString &reason) {
+    const auto it = m_connections.find(id);
+    if (it == m_connections.end()) {
+        return;
+    }
+    qCritical() << "Result verification failed for client" << id << ", id=" << it->workerId << ":" << reason
+                << "- quarantined (" << m_verifiedUnits << "units verified so far)";
+    if (!it->workerId.isEmpty()) {
+        m_quarantined.insert(it->workerId);
+    }
+
+    m_scheduler.removeWorker(id);
+    ErrorMsg err;
+    err.text = "result verification failed: " + reason;
+    it->framed->sendFrame(serializeError(err));
+    it->framed->socket()->disconnectFromHost();
+}
+
+void ServerApp::handlePeerTask(int peer, const TaskMsg &t) {
+    PeerLink *link = m_peers[peer];
+    std::vector<Segment> blocks;
+    try {
+        Integrator::validate(t.a, t.b, t.h);
+        blocks = Integrator::partition(t.a, t.b, t.h, std::max<int>(1, static_cast<int>(t.verifyBlocks)));
+    } catch (const std::exception &e) {
+        ErrorMsg err;
+        err.text = QString::fromUtf8(e.what());
+        link->sendError(err);
+        return;
+    }
+
+    const FederatedKey key(peer, t.unitId);
+    FederatedUnit &u = m_federatedUnits[key];
+    u.task = t;
+    u.timer.start();
+    u.blockSums = QVector<double>(static_cast<int>(blocks.size()), 0.0);
+    u.remaining = static_cast<int>(blocks.size());
+
+    // Verification blocks become separate jobs so their sums can be reported back exactly.
+    for (int i = 0; i < static_cast<int>(blocks.size()); ++i) {
+        JobSpec spec;
+        spec.a = blocks[static_cast<size_t>(i)].a;
+        spec.b = blocks[static_cast<size_t>(i)].b;
+        spec.h = t.h;
+        spec.method = t.method;
+        spec.tenant = QStringLiteral("federation");
+        spec.priority = JobPriority::Batch;
+        spec.federated = true;
+        m_federatedJobs.insert(submitJob(spec), FederatedBlock{key, i});
+    }
+    qCDebug(lcMessages) << "TASK from peer" << link->address() << "job" << t.jobId << "unit" << t.unitId << ": [" << t.a
+                        << "," << t.b << "] as" << blocks.size() << "local jobs";
+    pump();
+}
+
+void ServerApp::handlePeerCancel(int peer, const CancelMsg &m) {
+    const auto it = m_federatedUnits.find(FederatedKey(peer, m.unitId));
+    if (it == m_federatedUnits.end()) {
+        return;
+    }
+    it->cancelled = true;
+    std::vector<quint64> jobs;
+    for (auto j = m_federatedJobs.cbegin(); j != m_federatedJobs.cend(); ++j) {
+        if (j->unit == it.key()) {
+            jobs.push_back(j.key());
+        }
+    }
+    qCDebug(lcMessages) << "CANCEL from peer" << m_peers[peer]->address() << "unit" << m.unitId;
+    for (const quint64 jobId : jobs) {
+        sendCancels(m_scheduler.cancelJob(jobId));
+    }
+    pump();
+}
+
+void ServerApp::dropPeerUnits(int peer) {
+    std::vector<quint64> jobs;
+    for (auto j = m_federatedJobs.cbegin(); j != m_federatedJobs.cend(); ++j) {
+        if (j->unit.first == peer) {
+            jobs.push_back(j.key());
+        }
+    }
+    // The peer requeues these units itself, so the local jobs are simply dropped.
+    for (const quint64 jobId : jobs) {
+        m_federatedJobs.remove(jobId);
+        sendCancels(m_scheduler.cancelJob(jobId));
+    }
+    for (auto it = m_federatedUnits.begin(); it != m_federatedUnits.end();) {
+        it = (it.key().first == peer) ? m_federatedUnits.erase(it) : std::next(it);
+    }
+    pump();
+}
+
+void ServerApp::finishFederatedBlock(const FederatedBlock &fb, const JobOutcome &o) {
+    const auto it = m_federatedUnits.find(fb.unit);
+    if (it == m_federatedUnits.end()) {
+        return;
+    }
+    FederatedUnit &u = *it;
+    if (o.status == JobStatus::Ok) {
+        u.blockSums[fb.block] = o.value;
+    } else if (o.status == JobStatus::Cancelled) {
+        u.cancelled = true;
+    } else if (u.error.isEmpty()) {
+        u.error = o.error;
+    }
+    if (--u.remaining > 0) {
+        return;
+    }
+
+    PeerLink *link = m_peers[fb.unit.first];
+    if (!u.error.isEmpty()) {
+        ErrorMsg err;
+        err.text = u.error;
+        link->sendError(err);
+    } else {
+        ResultMsg r;
+        r.jobId = u.task.jobId;
+        r.unitId = u.task.unitId;
+        if (u.cancelled) {
+            r.flags = ResultCancelled;
+        } else {
+            for (const double v : u.blockSums) {
+                r.value += v;
+            }
+            if (u.task.verifyBlocks > 0) {
+                r.blockSums = u.blockSums;
+            }
+            r.computeMs = static_cast<double>(u.timer.nsecsElapsed()) / 1e6;
+        }
+        link->sendResult(r);
+        qCDebug(lcMessages) << "Sent RESULT to peer" << link->address() << "job" << r.jobId << "unit" << r.unitId << ":"
+                            << (u.cancelled ? QStringLiteral("cancelled") : QString::number(r.value, 'g', 17));
+    }
+    m_federatedUnits.erase(it);
+}
+
+void ServerApp::updatePeerCores() {
+    if (m_peers.isEmpty()) {
+        return;
+    }
+    quint32 cores = 0;
+    for (const Connection &c : m_connections) {
+        if (c.role == Role::Worker && !c.coordinator && !c.draining) {
+            cores += c.cores;
+        }
+    }
+    for (PeerLink *link : m_peers) {
+        link->setCores(cores);
+    }
+}
+
+void ServerApp::recordUnitStats(const QString &workerId, const WorkUnit &unit, const ResultMsg &m,
+                                qint64 roundTripNs) {
+    if (roundTripNs < 0) {
+        return;
+    }
+    const QString worker = workerId.isEmpty() ? QStringLiteral("unnamed") : workerId;
+    const double roundTripMs = static_cast<double>(roundTripNs) / 1e6;
+    m_unitLatency.record(roundTripMs / 1e3);
+    const TaskTelemetry &tm = m.telemetry;
+    WorkerThroughput &wt = m_workerThroughput[worker];
+    wt.units += 1;
+    wt.steps += Integrator::stepCount(unit.a, unit.b, unit.h);
+    wt.evaluations += tm.evaluations;
+    wt.computeSeconds += m.computeMs / 1e3;
+    wt.cpuSeconds += tm.cpuMs / 1e3;
+    qCDebug(lcMessages) << "Unit" << m.unitId << "of job" << m.jobId << "on" << worker << ":" << m.computeMs
+                        << "ms wall," << tm.cpuMs << "ms cpu," << tm.threads << "threads," << tm.evaluations
+                        << "evaluations ("
+                        << ((m.computeMs > 0.0) ? static_cast<double>(tm.evaluations) / m.computeMs / 1e3 : 0.0)
+                        << "M/s)," << tm.kernel << ", peak RSS" << tm.peakRssKb << "KiB";
+    const HwCounts hw{tm.cycles, tm.instructions, tm.cacheMisses, tm.branchMisses};
+    if (tm.hwCounters) {
+        wt.hw += hw;
+        qCDebug(lcMessages) << "Unit" << m.unitId << "counters:" << hw.cycles << "cycles," << hw.instructions
+                            << "instructions (IPC" << hw.ipc() << ")," << hw.cacheMisses << "cache misses,"
+                            << hw.branchMisses << "branch misses";
+    }
+
+    const auto ticket = m_tickets.find(m.jobId);
+    if (ticket == m_tickets.end()) {
+        return;
+    }
+    ticket->computeMs += m.computeMs;
+    ticket->networkMs += std::max(0.0, roundTripMs - m.computeMs);
+    ticket->units += 1;
+    ticket->workerComputeMs[worker] += m.computeMs;
+    ticket->cpuMs += tm.cpuMs;
+    ticket->evaluations += tm.evaluations;
+    ticket->workerEvaluations[worker] += tm.evaluations;
+    if (tm.hwCounters) {
+        ticket->hw += hw;
+        ticket->countedUnits += 1;
+    }
+}
+
+void ServerApp::traceUnit(const Connection &c, const ResultMsg &m) {
+    const auto ticket = m_tickets.find(m.jobId);
+    if (ticket == m_tickets.end() || c.unitSentUs == 0) {
+        return;
+    }
+    JobTrace &trace = ticket->trace;
+    const int pid = static_cast<int>(c.workerIndex) + 1;
+    const QString name = c.workerId.isEmpty() ? "worker " + QString::number(c.workerIndex) : c.workerId;
+    const QString unit = QString::number(m.unitId);
+
+    // Server lane of the worker: TASK sent to RESULT received.
+    trace.setThreadName(0, pid, "to " + name);
+    trace.addSpan(0, pid, "unit " + unit, c.unitSentUs, traceClockUs(),
+                  QJsonObject{{"unit", unit}, {"clock_rtt_us", c.clock.rttUs()}});
+    if (!c.clock.valid()) {
+        return;
+    }
+
+    trace.setProcessName(pid, name);
+    trace.setThreadName(pid, 0, "event loop");
+    for (const TraceSpan &s : m.trace) {
+        if (s.thread != 0) {
+            trace.setThreadName(pid, static_cast<int>(s.thread), "compute " + QString::number(s.thread));
+        }
+        const qint64 startUs = c.clock.toLocal(s.startUs);
+        trace.addSpan(pid, static_cast<int>(s.thread), s.name, startUs, startUs + s.durUs, QJsonObject{{"unit", unit}});
+    }
+}
+
+void ServerApp::writeTrace(quint64 jobId, JobTicket &t, const JobOutcome &o, qint64 reduceStartUs) {
+    const qint64 nowUs = traceClockUs();
+    if (t.firstDispatchUs > 0) {
+        t.trace.addSpan(0, 0, "queued", t.submitUs, t.firstDispatchUs);
+    }
+    t.trace.addSpan(0, 0, "reduce", reduceStartUs, nowUs);
+    const QJsonObject args{{"status", jobStatusName(o.status)}, {"value", o.value}, {"units", static_cast<int>(t.units)}};
+    t.trace.addSpan(0, 0, "job " + QString::number(jobId), t.submitUs, nowUs, args);
+
+    const QString path = QDir(m_traceDir).filePath("job-" + QString::number(jobId) + ".json");
+    if (!t.trace.save(path)) {
+        qWarning() << "Failed to write trace" << path;
+        return;
+    }
+    qInfo() << "Trace of job" << jobId << "written to" << path;
+}
+
+QByteArray ServerApp::metricsText() const {
+    int workers = 0;
+    int draining = 0;
+    quint64 cores = 0;
+    for (const Connection &c : m_connections) {
+        if (c.role == Role::Worker) {
+            ++workers;
+            draining += c.draining ? 1 : 0;
+            cores += c.cores;
+        }
+    }
+
+    PrometheusWriter w;
+    w.family("netproj_jobs_submitted_total", "counter", "Jobs accepted by the scheduler.");
+    w.sample("netproj_jobs_submitted_total", static_cast<double>(m_jobsSubmitted));
+    w.family("netproj_jobs_finished_total", "counter", "Jobs finished, by status.");
+    for (auto it = m_jobsFinished.cbegin(); it != m_jobsFinished.cend(); ++it) {
+        w.sample("netproj_jobs_finished_total", static_cast<double>(it.value()), {{"status", it.key()}});
+    }
+    w.family("netproj_result_cache_hits_total", "counter", "Submissions answered from the job history.");
+    w.sample("netproj_result_cache_hits_total", static_cast<double>(m_cacheHits));
+    w.family("netproj_jobs_queued", "gauge", "Active jobs without a running unit.");
+    w.sample("netproj_jobs_queued", m_scheduler.queuedJobs());
+    w.family("netproj_jobs_running", "gauge", "Active jobs with at least one running unit.");
+    w.sample("netproj_jobs_running", m_scheduler.runningJobs());
+
+    w.family("netproj_workers", "gauge", "Connected workers, including peer coordinators.");
+    w.sample("netproj_workers", workers);
+    w.family("netproj_workers_draining", "gauge", "Connected workers that are draining.");
+    w.sample("netproj_workers_draining", draining);
+    w.family("netproj_worker_cores", "gauge", "Cores announced by connected workers.");
+    w.sample("netproj_worker_cores", static_cast<double>(cores));
+    w.family("netproj_worker_units_total", "counter", "Units completed, by worker id.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        w.sample("netproj_worker_units_total", static_cast<double>(it->units), {{"worker", it.key()}});
+    }
+    w.family("netproj_worker_steps_total", "counter", "Integration steps completed, by worker id.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        w.sample("netproj_worker_steps_total", static_cast<double>(it->steps), {{"worker", it.key()}});
+    }
+    w.family("netproj_worker_evaluations_total", "counter", "Integrand evaluations, by worker id.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        w.sample("netproj_worker_evaluations_total", static_cast<double>(it->evaluations), {{"worker", it.key()}});
+    }
+    w.family("netproj_worker_compute_seconds_total", "counter", "Compute time reported, by worker id.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        w.sample("netproj_worker_compute_seconds_total", it->computeSeconds, {{"worker", it.key()}});
+    }
+    w.family("netproj_worker_cpu_seconds_total", "counter", "Worker process CPU time reported, by worker id.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        w.sample("netproj_worker_cpu_seconds_total", it->cpuSeconds, {{"worker", it.key()}});
+    }
+    w.family("netproj_worker_hw_events_total", "counter",
+             "Hardware events of worker compute threads (clients run with --hw-counters), by worker id and event.");
+    for (auto it = m_workerThroughput.cbegin(); it != m_workerThroughput.cend(); ++it) {
+        if (it->hw.cycles == 0) {
+            continue;
+        }
+        w.sample("netproj_worker_hw_events_total", static_cast<double>(it->hw.cycles),
+                 {{"worker", it.key()}, {"event", "cycles"}});
+        w.sample("netproj_worker_hw_events_total", static_cast<double>(it->hw.instructions),
+                 {{"worker", it.key()}, {"event", "instructions"}});
+        w.sample("netproj_worker_hw_events_total", static_cast<double>(it->hw.cacheMisses),
+                 {{"worker", it.key()}, {"event", "cache_misses"}});
+        w.sample("netproj_worker_hw_events_total", static_cast<double>(it->hw.branchMisses),
+                 {{"worker", it.key()}, {"event", "branch_misses"}});
+    }
+    w.family("netproj_units_verified_total", "counter", "Units that passed result verification.");
+    w.sample("netproj_units_verified_total", static_cast<double>(m_verifiedUnits));
+
+    w.family("netproj_messages_received_total", "counter", "Messages received from workers and submitters, by type.");
+    for (auto it = m_messagesIn.cbegin(); it != m_messagesIn.cend(); ++it) {
+        w.sample("netproj_messages_received_total", static_cast<double>(it.value()),
+                 {{"type", messageTypeName(it.key())}});
+    }
+    w.family("netproj_frames_received_total", "counter", "Frames received.");
+    w.sample("netproj_frames_received_total", static_cast<double>(m_traffic.framesIn));
+    w.family("netproj_frames_sent_total", "counter", "Frames sent.");
+    w.sample("netproj_frames_sent_total", static_cast<double>(m_traffic.framesOut));
+    w.family("netproj_received_bytes_total", "counter", "Bytes received, including frame headers.");
+    w.sample("netproj_received_bytes_total", static_cast<double>(m_traffic.bytesIn));
+    w.family("netproj_sent_bytes_total", "counter", "Bytes sent, including frame headers.");
+    w.sample("netproj_sent_bytes_total", static_cast<double>(m_traffic.bytesOut));
+#ifdef NETPROJ_COUNT_ALLOCATIONS
+    w.family("netproj_heap_allocations_total", "counter", "Heap allocations of the server process (all threads).");
+    w.sample("netproj_heap_allocations_total", static_cast<double>(allocationCount()));
+#endif
+
+    w.family("netproj_unit_latency_seconds", "histogram", "Unit dispatch to result time.");
+    w.histogram("netproj_unit_latency_seconds", m_unitLatency);
+    w.family("netproj_job_latency_seconds", "histogram", "Job submission to completion time.");
+    w.histogram("netproj_job_latency_seconds", m_jobLatency);
+    return w.text();
+}
+
+void ServerApp::recordProfile(const QString &workerId, const WorkUnit &unit, qint64 roundTripNs) {
+    if (m_profilesPath.isEmpty() || workerId.isEmpty() || roundTripNs < 0) {
+        return;
+    }
+    const double seconds = static_cast<double>(roundTripNs) / 1e9;
+    const quint64 steps = Integrator::stepCount(unit.a, unit.b, unit.h);
+    m_profiles.record(workerId, unit.method, unit.h, steps, seconds, QDateTime::currentMSecsSinceEpoch());
+    m_profilesDirty = true;
+    if (!m_profileSaveTimer.isActive()) {
+        m_profileSaveTimer.start(kProfileSaveDelayMs);
+    }
+}
+
+void ServerApp::saveProfiles() {
+    m_profileSaveTimer.stop();
+    if (!m_profilesDirty || m_profilesPath.isEmpty()) {
+        return;
+    }
+    m_profilesDirty = false;
+    if (!m_profiles.save(m_profilesPath)) {
+        qWarning() << "Failed to save worker profiles to" << m_profilesPath;
+    }
+}
+
+void ServerApp::finishJob(const JobOutcome &o) {
+    const qint64 reduceStartUs = traceClockUs();
+    JobTicket t = m_tickets.take(o.jobId);
+    const qint64 ms = t.timer.isValid() ? t.timer.elapsed() : 0;
+    ++m_jobsFinished[jobStatusName(o.status)];
+    if (t.timer.isValid()) {
+        m_jobLatency.record(static_cast<double>(t.timer.nsecsElapsed()) / 1e9);
+    }
+    const auto inflight = m_inflight.constFind(t.key);
+    if (inflight != m_inflight.constEnd() && *inflight == o.jobId) {
+        m_inflight.remove(t.key);
+    }
+
+    qInfo() << "JOB" << o.jobId << jobStatusName(o.status) << ": value=" << o.value << ", time=" << ms << "ms"
+            << ", subscribers=" << t.subscribers.size()
+            << (o.error.isEmpty() ? QString() : ", error=" + o.error);
+
+    const auto federated = m_federatedJobs.constFind(o.jobId);
+    if (federated != m_federatedJobs.constEnd()) {
+        const FederatedBlock fb = *federated;
+        m_federatedJobs.erase(federated);
+        finishFederatedBlock(fb, o);
+        return;
+    }
+
+    JobResultMsg r;
+    r.jobId = o.jobId;
+    r.status = o.status;
+    r.error = o.error;
+    r.dispatchMs = t.dispatchMs;
+    r.computeMs = t.computeMs;
+    r.networkMs = t.networkMs;
+    r.units = t.units;
+    r.workerComputeMs = t.workerComputeMs;
+    r.cpuMs = t.cpuMs;
+    r.evaluations = t.evaluations;
+    r.workerEvaluations = t.workerEvaluations;
+    r.requeuedUnits = o.requeuedUnits;
+    r.requeuedSteps = o.requeuedSteps;
+    if (o.requeuedUnits > 0) {
+        qInfo() << "JOB" << o.jobId << "requeued" << o.requeuedUnits << "units," << o.requeuedSteps << "steps";
+    }
+    for (auto it = t.workerEvaluations.cbegin(); it != t.workerEvaluations.cend(); ++it) {
+        const double ms = t.workerComputeMs.value(it.key());
+        qInfo() << "JOB" << o.jobId << "worker" << it.key() << ":" << it.value() << "evaluations in" << ms << "ms ("
+                << ((ms > 0.0) ? static_cast<double>(it.value()) / ms / 1e3 : 0.0) << "M/s)";
+    }
+    if (t.countedUnits > 0) {
+        qInfo() << "JOB" << o.jobId << "counters over" << t.countedUnits << "of" << t.units << "units: IPC"
+                << t.hw.ipc() << "," << t.hw.perKiloInstruction(t.hw.cacheMisses) << "cache misses and"
+                << t.hw.perKiloInstruction(t.hw.branchMisses) << "branch misses per 1k instructions";
+    }
+    for (const Subscriber &s : t.subscribers) {
+        r.requestId = s.requestId;
+        r.value = s.sign * o.value;
+        r.elapsedMs = s.timer.isValid() ? s.timer.elapsed() : ms;
+        sendJobResult(s.connection, r);
+    }
+    if (!m_traceDir.isEmpty()) {
+        writeTrace(o.jobId, t, o, reduceStartUs);
+    }
+    if (m_history.isOpen()) {
+        recordHistory(t, o, ms);
+    }
+
+    if (o.jobId != m_oneShotJobId || m_finished) {
+        return;
+    }
+    if (!m_batch.empty()) {
+        r.value = o.value;
+        r.elapsedMs = ms;
+        finishBatchJob(r);
+        return;
+    }
+
+    if (o.status != JobStatus::Ok) {
+        qCritical() << "Job" << jobStatusName(o.status) << ":" << o.error;
+        quitOneShot(1);
+        return;
+    }
+    qInfo() << "FINAL RESULT:" << o.value << ", time=" << ms << "ms";
+    quitOneShot(0);
+}
+
+void ServerApp::recordHistory(const JobTicket &t, const JobOutcome &o, qint64 elapsedMs) {
+    JobRecord h;
+    h.finishedMs = QDateTime::currentMSecsSinceEpoch();
+    h.jobId = o.jobId;
+    h.a = t.spec.a;
+    h.b = t.spec.b;
+    h.h = t.spec.h;
+    h.method = t.spec.method;
+    h.tenant = t.spec.tenant;
+    h.priority = t.spec.priority;
+    h.status = o.status;
+    h.value = o.value;
+    h.error = o.error;
+    h.elapsedMs = elapsedMs;
+    h.dispatchMs = t.dispatchMs;
+    h.computeMs = t.computeMs;
+    h.networkMs = t.networkMs;
+    h.cpuMs = t.cpuMs;
+    h.units = t.units;
+    h.evaluations = t.evaluations;
+    h.requeuedUnits = o.requeuedUnits;
+    h.workerComputeMs = t.workerComputeMs;
+    h.workerEvaluations = t.workerEvaluations;
+    if (!m_history.append(h)) {
+        qWarning() << "Failed to record job" << o.jobId << "in the job history:" << m_history.error();
+    }
+}
+
+void ServerApp::quitOneShot(int exitCode) {
+    m_finished = true;
+    saveProfiles();
+
+    if (m_pauseOnFinish) {
+        QTextStream in(stdin);
+        QTextStream out(stdout);
+        out << "Press Enter to exit..." << Qt::endl;
+        in.readLine();
+    }
+
+    QCoreApplication::exit(exitCode);
+}
+
+} // namespace netproj
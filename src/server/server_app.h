@@ -0,0 +1,351 @@
+#pragma once
+
+#include "../common/framed_socket.h"
+#include "../common/hw_counters.h"
+#include "../common/job_history.h"
+#include "../common/job_file.h"
+#include "../common/message_codec.h"
+#include "../common/protocol.h"
+#include "../common/session_log.h"
+#include "../common/tracing.h"
+#include "admission_control.h"
+#include "http_server.h"
+#include "job_gateway.h"
+#include "job_scheduler.h"
+#include "job_trace.h"
+#include "metrics.h"
+#include "peer_link.h"
+#include "result_verifier.h"
+#include "worker_profiles.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QTcpServer>
+#include <QTimer>
+#include <QVector>
+
+namespace netproj {
+
+/**
+ * @brief TCP server application.
+ *
+ * Connections identify themselves with their first message: HELLO makes a worker, SUBMIT a submitter.
+ * Jobs are cut into work units by JobScheduler and partial results are reduced per job.
+ *
+ * In one-shot mode the server waits for N workers, runs the single job configured with setTask() and exits.
+ * In service mode it runs until killed and serves jobs from any number of submitters.
+ */
+class ServerApp : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct server app.
+     */
+    explicit ServerApp(QObject *parent = nullptr);
+
+    /**
+     * @brief Save worker profiles that changed since the last save.
+     */
+    ~ServerApp() override;
+
+    /**
+     * @brief Enable/disable pause on finish (wait for Enter before exiting, one-shot mode).
+     */
+    void setPauseOnFinish(bool v) { m_pauseOnFinish = v; }
+
+    /**
+     * @brief Use a persistent worker profile database at path (empty disables profiles).
+     */
+    bool setProfilesPath(const QString &path);
+
+    /**
+     * @brief Set fair-share weight of a tenant.
+     */
+    void setTenantWeight(const QString &tenant, double weight) { m_scheduler.setTenantWeight(tenant, weight); }
+
+    /**
+     * @brief Set how many units each worker's share of a job is cut into.
+     */
+    void setGranularity(int granularity) { m_scheduler.setGranularity(granularity); }
+
+    /**
+     * @brief Set admission limits for submissions (service mode).
+     */
+    void setAdmissionLimits(const AdmissionLimits &limits) { m_admission.setLimits(limits); }
+
+    /**
+     * @brief Attach identical concurrent submissions to the running job instead of computing them again.
+     */
+    void setDeduplication(bool v) { m_dedup = v; }
+
+    /**
+     * @brief Verify worker results by recomputing samples of reported per-block sums.
+     * @param blocks Blocks per unit (0 disables verification).
+     * @param samples Blocks recomputed on the server per unit.
+     */
+    void setVerification(int blocks, int samples) { m_verifier = ResultVerifier(blocks, samples); }
+
+    /**
+     * @brief Start listening on port in one-shot mode and set expected client count.
+     */
+    bool start(quint16 port, int expectedClients);
+
+    /**
+     * @brief Start listening on port in service mode.
+     */
+    bool startService(quint16 port);
+
+    /**
+     * @brief Set integration task parameters (one-shot mode).
+     */
+    void setTask(double a, double b, double h, MethodType method);
+
+    /**
+     * @brief Run jobs back-to-back on the one-shot worker pool instead of the single task, then save their results to
+     * outPath (see saveJobResults(); empty: print CSV to stdout) and quit.
+     */
+    void setJobFile(const std::vector<SubmitMsg> &jobs, const QString &outPath);
+
+    /**
+     * @brief Join the federation of a peer coordinator (service mode, call after startService()).
+     *
+     * The local worker pool is offered to the peer as one worker; units the peer shards onto it run here as
+     * batch jobs of the "federation" tenant, so local submissions keep their priority and fair share.
+     */
+    void addPeer(const QString &host, quint16 port);
+
+    /**
+     * @brief Trace every job into dir/job-<id>.json (Chrome trace format); workers add their own spans.
+     */
+    bool setTraceDir(const QString &dir);
+
+    /**
+     * @brief Serve Prometheus metrics at http://address:port/metrics.
+     */
+    bool startMetrics(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+    /**
+     * @brief Accept jobs over HTTP/JSON at http://address:port/jobs (service mode, see JobGateway).
+     */
+    bool startGateway(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+    /**
+     * @brief Append every completed job to the job history at path (empty disables it, see JobHistory).
+     */
+    bool setHistoryPath(const QString &path);
+
+    /**
+     * @brief Answer submissions of a computation with a successful run in the job history from there (service mode).
+     */
+    void setResultCache(bool v) { m_resultCache = v; }
+
+    /**
+     * @brief Record every frame of every connection with its time into a session log at path (see net_replay).
+     */
+    bool setRecordPath(const QString &path);
+
+    /**
+     * @brief Listening port (0 before start).
+     */
+    quint16 port() const { return m_server.serverPort(); }
+
+private slots:
+    /**
+     * @brief Accept incoming TCP connections.
+     */
+    void onNewConnection();
+
+private:
+    enum class Role {
+        Unknown,
+        Worker,
+        Submitter
+    };
+
+    /**
+     * @brief Per-connection server-side state.
+     */
+    struct Connection {
+        FramedSocket *framed = nullptr;
+        Role role = Role::Unknown;
+        quint32 cores = 0;
+        QString workerId;
+        bool coordinator = false;
+        bool draining = false;
+        quint32 workerIndex = 0;
+        QElapsedTimer unitTimer;
+        qint64 unitSentUs = 0;
+        ClockSync clock;     ///< Worker trace clock relative to ours.
+        ClockSync nextClock; ///< Estimate of the ping burst in progress.
+    };
+
+    /**
+     * @brief Submitter waiting for a job result.
+     */
+    struct Subscriber {
+        int connection = 0;
+        quint64 requestId = 0;
+        double sign = 1.0;
+        QElapsedTimer timer;
+    };
+
+    /**
+     * @brief Unit received from a peer coordinator, computed as one local job per verification block.
+     */
+    struct FederatedUnit {
+        TaskMsg task;
+        QElapsedTimer timer;
+        QVector<double> blockSums;
+        int remaining = 0;
+        bool cancelled = false;
+        QString error;
+    };
+
+    /**
+     * @brief Federated unit identity: peer index and the peer's unit id.
+     */
+    using FederatedKey = QPair<int, quint64>;
+
+    /**
+     * @brief Local job computing one block of a federated unit.
+     */
+    struct FederatedBlock {
+        FederatedKey unit;
+        int block = 0;
+    };
+
+    /**
+     * @brief Server-side bookkeeping of an active job.
+     */
+    struct JobTicket {
+        JobSpec spec;
+        JobKey key;
+        QVector<Subscriber> subscribers;
+        QElapsedTimer timer;
+        qint64 dispatchMs = -1;
+        double computeMs = 0.0;
+        double networkMs = 0.0;
+        quint32 units = 0;
+        QMap<QString, double> workerComputeMs;
+        double cpuMs = 0.0;
+        quint64 evaluations = 0;
+        QMap<QString, quint64> workerEvaluations;
+        HwCounts hw;             ///< Hardware counts of the units that reported them.
+        quint32 countedUnits = 0;
+        qint64 submitUs = 0;
+        qint64 firstDispatchUs = 0;
+        JobTrace trace;
+    };
+
+    /**
+     * @brief Cumulative throughput of one worker id.
+     */
+    struct WorkerThroughput {
+        quint64 units = 0;
+        quint64 steps = 0;
+        quint64 evaluations = 0;
+        double computeSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        HwCounts hw;
+    };
+
+    bool listen(quint16 port);
+    void onConnectionClosed(int id);
+    void onFrame(int id, const QByteArray &payload);
+    void handleHello(int id, const HelloMsg &m);
+    void handleResult(int id, const ResultMsg &m);
+    void handleWorkerError(int id, const ErrorMsg &m);
+    void handleDrain(int id, const DrainMsg &m);
+    void handlePong(int id, const PongMsg &m);
+    void sendPing(int id, quint32 seq);
+    void resyncClocks();
+    void traceUnit(const Connection &c, const ResultMsg &m);
+    void writeTrace(quint64 jobId, JobTicket &t, const JobOutcome &o, qint64 reduceStartUs);
+    void recordHistory(const JobTicket &t, const JobOutcome &o, qint64 elapsedMs);
+    void handleSubmit(int id, const SubmitMsg &m);
+    void admit(int id, const SubmitMsg &m);
+    void submitGatewayJobs(const std::vector<SubmitMsg> &jobs);
+    void handlePeerTask(int peer, const TaskMsg &t);
+    void handlePeerCancel(int peer, const CancelMsg &m);
+    void dropPeerUnits(int peer);
+    void finishFederatedBlock(const FederatedBlock &fb, const JobOutcome &o);
+    void updatePeerCores();
+
+    quint64 submitJob(const JobSpec &spec);
+    void pump();
+    void sendTask(const Assignment &as);
+    void sendCancels(const std::vector<Assignment> &victims);
+    void finishJob(const JobOutcome &o);
+    void maybeStartOneShot();
+    void startBatchJob();
+    void finishBatchJob(const JobResultMsg &r);
+    void quitOneShot(int exitCode);
+    void recordProfile(const QString &workerId, const WorkUnit &unit, qint64 roundTripNs);
+    void saveProfiles();
+    void recordUnitStats(const QString &workerId, const WorkUnit &unit, const ResultMsg &m, qint64 roundTripNs);
+    void startVerification(int id, const WorkUnit &unit, const ResultMsg &m, qint64 roundTripNs);
+    void quarantine(int id, const QString &reason);
+    void sendJobResult(int connection, const JobResultMsg &m);
+    QByteArray metricsText() const;
+
+    QTcpServer m_server;
+    QHash<int, Connection> m_connections;
+    int m_nextConnectionId = 1;
+    quint32 m_nextWorkerIndex = 0;
+
+    JobScheduler m_scheduler;
+    AdmissionController m_admission;
+    QHash<quint64, JobTicket> m_tickets;
+    QHash<JobKey, quint64> m_inflight;
+    bool m_dedup = true;
+
+    bool m_serviceMode = false;
+    int m_expectedClients = 0;
+    JobSpec m_oneShotSpec;
+    quint64 m_oneShotJobId = 0;
+    bool m_finished = false;
+    bool m_pauseOnFinish = false;
+    std::vector<SubmitMsg> m_batch; ///< Jobs of the job file, run one after the other.
+    std::vector<JobFileResult> m_batchResults;
+    QString m_batchOutPath;
+
+    WorkerProfileStore m_profiles;
+    QString m_profilesPath;
+    QTimer m_profileSaveTimer; ///< Saves changed profiles a while after the first change.
+    bool m_profilesDirty = false;
+
+    ResultVerifier m_verifier;
+    QSet<QString> m_quarantined;
+    quint64 m_verifiedUnits = 0;
+
+    QVector<PeerLink *> m_peers;
+    QHash<FederatedKey, FederatedUnit> m_federatedUnits;
+    QHash<quint64, FederatedBlock> m_federatedJobs;
+
+    JobHistory m_history;
+    bool m_resultCache = false;
+    quint64 m_cacheHits = 0;
+
+    QString m_traceDir;
+    QTimer m_clockTimer;
+
+    HttpServer m_metricsHttp;
+    JobGateway m_gateway;
+    FrameCounters m_traffic;
+    QMap<MessageType, quint64> m_messagesIn;
+    quint64 m_jobsSubmitted = 0;
+    QMap<QString, quint64> m_jobsFinished;
+    QMap<QString, WorkerThroughput> m_workerThroughput;
+    LatencyHistogram m_unitLatency; ///< TASK sent to RESULT received.
+    LatencyHistogram m_jobLatency;  ///< Job submitted to finished.
+
+    SessionRecorder m_recorder;
+    QTimer m_recordFlushTimer; ///< Writes out buffered records while no new ones arrive.
+    MessageCodec m_codec; ///< Parses every inbound message and serializes TASK, CANCEL and PING without allocating.
+};
+
+} // namespace netproj
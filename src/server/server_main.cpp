@@ -1,301 +1,211 @@
-#include "../common/framed_socket.h"
+#include "server_app.h"
+
+#include "../common/async_log.h"
 #include "../common/integrator.h"
-#include "../common/message_io.h"
 
 #include <QCoreApplication>
-#include <QDateTime>
-#include <QElapsedTimer>
+#include <QFile>
 #include <QHostAddress>
-#include <QIODevice>
-#include <QTextStream>
-#include <QTcpServer>
-#include <QTcpSocket>
-
 #include <QRegularExpression>
 #include <QStringList>
+#include <QTextStream>
 
-namespace netproj {
-
-/**
- * @brief Per-client server-side state.
- */
-struct ClientState {
-    FramedSocket *framed = nullptr;
-    quint32 cores = 0;
-    bool helloReceived = false;
-    bool resultReceived = false;
-    double result = 0.0;
-};
+#include <exception>
 
 /**
- * @brief Parse method id from CLI input.
+ * @brief Value following a command line option, or empty string.
  */
-static MethodType parseMethod(int v) {
-    switch (v) {
-    case 1:
-        return MethodType::MidpointRectangles;
-    case 2:
-        return MethodType::Trapezoids;
-    case 3:
-        return MethodType::Simpson;
-    default:
-        return MethodType::Simpson;
+static QString argValue(const QStringList &args, const QString &name) {
+    const int idx = args.indexOf(name);
+    if (idx >= 0 && idx + 1 < args.size()) {
+        return args[idx + 1];
     }
+    return QString();
 }
 
 /**
- * @brief Get method name for logging.
+ * @brief Apply all "--tenant-weight name=weight" options.
  */
-static QString methodName(MethodType m) {
-    switch (m) {
-    case MethodType::MidpointRectangles:
-        return "midpoint_rectangles";
-    case MethodType::Trapezoids:
-        return "trapezoids";
-    case MethodType::Simpson:
-        return "simpson";
-    default:
-        return "unknown";
+static bool applyTenantWeights(const QStringList &args, netproj::ServerApp &srv) {
+    for (int i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] != "--tenant-weight") {
+            continue;
+        }
+        const QStringList kv = args[i + 1].split('=');
+        bool ok = false;
+        const double w = (kv.size() == 2) ? kv[1].toDouble(&ok) : 0.0;
+        if (!ok || !(w > 0.0) || kv[0].isEmpty()) {
+            qCritical() << "Invalid --tenant-weight" << args[i + 1] << "(expected name=weight)";
+            return false;
+        }
+        srv.setTenantWeight(kv[0], w);
     }
+    return true;
 }
 
 /**
- * @brief TCP server application. Accepts N clients, distributes integration tasks proportionally to core counts,
- * and reduces partial results.
+ * @brief Join every peer coordinator given as "--peer host:port".
  */
-class ServerApp : public QObject {
-    Q_OBJECT
-public:
-    /**
-     * @brief Construct server app.
-     */
-    explicit ServerApp(QObject *parent = nullptr)
-        : QObject(parent) {
-        connect(&m_server, &QTcpServer::newConnection, this, &ServerApp::onNewConnection);
-    }
-
-    /**
-     * @brief Enable/disable pause on finish (wait for Enter before exiting).
-     */
-    void setPauseOnFinish(bool v) { m_pauseOnFinish = v; }
-
-    /**
-     * @brief Start listening on port and set expected client count.
-     */
-    bool start(quint16 port, int expectedClients) {
-        m_expectedClients = expectedClients;
-        if (!m_server.listen(QHostAddress::Any, port)) {
-            qCritical() << "Server listen failed:" << m_server.errorString();
+static bool addPeers(const QStringList &args, netproj::ServerApp &srv) {
+    for (int i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] != "--peer") {
+            continue;
+        }
+        const int colon = args[i + 1].lastIndexOf(':');
+        bool ok = false;
+        const quint16 port = (colon > 0) ? args[i + 1].mid(colon + 1).toUShort(&ok) : 0;
+        if (!ok || port == 0) {
+            qCritical() << "Invalid --peer" << args[i + 1] << "(expected host:port)";
             return false;
         }
-        qInfo() << "Server listening on port" << port << ", expecting" << expectedClients << "clients";
-        return true;
-    }
-
-    /**
-     * @brief Set integration task parameters.
-     */
-    void setTask(double a, double b, double h, MethodType method) {
-        m_a = a;
-        m_b = b;
-        m_h = h;
-        m_method = method;
+        srv.addPeer(args[i + 1].left(colon), port);
     }
+    return true;
+}
 
-private slots:
-    /**
-     * @brief Accept incoming TCP connections.
-     */
-    void onNewConnection() {
-        while (QTcpSocket *sock = m_server.nextPendingConnection()) {
-            sock->setSocketOption(QAbstractSocket::LowDelayOption, 1);
-
-            auto *framed = new FramedSocket(sock, sock);
-            ClientState st;
-            st.framed = framed;
-            m_clients.push_back(st);
-            const int idx = m_clients.size() - 1;
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
 
-            qInfo() << "Client connected" << sock->peerAddress().toString() << ":" << sock->peerPort();
+    QTextStream in(stdin);
+    QTextStream out(stdout);
 
-            connect(framed, &FramedSocket::frameReceived, this, [this, idx](const QByteArray &payload) {
-                onFrame(idx, payload);
-            });
-            connect(framed, &FramedSocket::disconnected, this, [this, idx]() {
-                onClientDisconnected(idx);
-            });
+    const QStringList args = QCoreApplication::arguments();
+    const bool pause = args.contains("--pause");
 
-            if (m_clients.size() == static_cast<size_t>(m_expectedClients)) {
-                qInfo() << "All clients connected. Waiting for HELLO from each client...";
-            }
-        }
+    netproj::LogLevel logLevel = netproj::LogLevel::Info;
+    if (!argValue(args, "--log-level").isEmpty() && !netproj::parseLogLevel(argValue(args, "--log-level"), &logLevel)) {
+        qCritical() << "Invalid --log-level (expected debug, info, warning or error)";
+        return 1;
     }
+    const netproj::AsyncLog log(logLevel, args.contains("--log-json") ? netproj::LogFormat::Json
+                                                                      : netproj::LogFormat::Text);
 
-private:
-    /**
-     * @brief Disconnection handler.
-     */
-    void onClientDisconnected(int idx) {
-        qWarning() << "Client disconnected idx=" << idx;
+    QString profilesPath = "netproj_profiles.json";
+    if (!argValue(args, "--profiles").isEmpty()) {
+        profilesPath = argValue(args, "--profiles");
+    }
+    if (args.contains("--no-profiles")) {
+        profilesPath.clear();
     }
 
-    /**
-     * @brief Handle incoming framed payload from a client.
-     */
-    void onFrame(int idx, const QByteArray &payload) {
-        const auto pm = parseMessage(payload);
-        if (!pm.ok) {
-            qWarning() << "Failed to parse message from client" << idx << ":" << pm.parseError;
-            return;
-        }
-
-        auto &c = m_clients[static_cast<size_t>(idx)];
-
-        if (pm.env.type == MessageType::Hello) {
-            c.helloReceived = true;
-            c.cores = pm.hello.cores;
-            qInfo() << "HELLO from client" << idx << ", cores=" << c.cores;
-            maybeDispatchTasks();
-            return;
+    int verifyBlocks = 0;
+    int verifySamples = 1;
+    if (!argValue(args, "--verify-blocks").isEmpty()) {
+        bool ok = false;
+        verifyBlocks = argValue(args, "--verify-blocks").toInt(&ok);
+        if (!ok || verifyBlocks < 0) {
+            qCritical() << "Invalid --verify-blocks";
+            return 1;
         }
-
-        if (pm.env.type == MessageType::Result) {
-            c.resultReceived = true;
-            c.result = pm.result.value;
-            qInfo() << "RESULT from client" << idx << ":" << c.result;
-            maybeFinalize();
-            return;
+    }
+    if (!argValue(args, "--verify-samples").isEmpty()) {
+        bool ok = false;
+        verifySamples = argValue(args, "--verify-samples").toInt(&ok);
+        if (!ok || verifySamples <= 0) {
+            qCritical() << "Invalid --verify-samples";
+            return 1;
         }
+    }
 
-        if (pm.env.type == MessageType::Error) {
-            qWarning() << "ERROR from client" << idx << ":" << pm.error.text;
-            c.resultReceived = true;
-            c.result = 0.0;
-            maybeFinalize();
-            return;
+    quint16 metricsPort = 0;
+    if (!argValue(args, "--metrics-port").isEmpty()) {
+        bool ok = false;
+        metricsPort = argValue(args, "--metrics-port").toUShort(&ok);
+        if (!ok || metricsPort == 0) {
+            qCritical() << "Invalid --metrics-port";
+            return 1;
         }
-
-        qWarning() << "Unexpected message type from client" << idx;
+    }
+    // Metrics and the job gateway are unauthenticated, so they serve only this machine unless told otherwise.
+    QHostAddress httpAddress(QHostAddress::LocalHost);
+    if (!argValue(args, "--http-bind").isEmpty() && !httpAddress.setAddress(argValue(args, "--http-bind"))) {
+        qCritical() << "Invalid --http-bind";
+        return 1;
     }
 
-    /**
-     * @brief Dispatch tasks when all clients are connected and HELLO is received.
-     */
-    void maybeDispatchTasks() {
-        if (m_dispatched) {
-            return;
-        }
-        if (m_expectedClients <= 0) {
-            return;
+    if (args.contains("--service")) {
+        bool ok = false;
+        const quint16 port = argValue(args, "--port").toUShort(&ok);
+        if (!ok || port == 0) {
+            qCritical() << "Service mode requires --port";
+            return 1;
         }
-        if (m_clients.size() != static_cast<size_t>(m_expectedClients)) {
-            return;
-        }
-        for (const auto &c : m_clients) {
-            if (!c.helloReceived) {
-                return;
+        int granularity = 4;
+        if (!argValue(args, "--granularity").isEmpty()) {
+            granularity = argValue(args, "--granularity").toInt(&ok);
+            if (!ok || granularity <= 0) {
+                qCritical() << "Invalid --granularity";
+                return 1;
             }
         }
 
-        quint64 totalCores = 0;
-        for (const auto &c : m_clients) {
-            totalCores += std::max<quint32>(1u, c.cores);
+        netproj::AdmissionLimits limits;
+        if (!argValue(args, "--max-jobs").isEmpty()) {
+            limits.maxActiveJobs = argValue(args, "--max-jobs").toInt(&ok);
+            if (!ok) {
+                qCritical() << "Invalid --max-jobs";
+                return 1;
+            }
         }
-
-        qInfo() << "Dispatching tasks. Total cores=" << totalCores << ", method=" << methodName(m_method)
-                << ", interval=[" << m_a << "," << m_b << "], h=" << m_h;
-
-        const double len = (m_b - m_a);
-        double cursor = m_a;
-
-        for (size_t i = 0; i < m_clients.size(); ++i) {
-            const quint32 cores = std::max<quint32>(1u, m_clients[i].cores);
-            const double frac = static_cast<double>(cores) / static_cast<double>(totalCores);
-            const double partLen = len * frac;
-            const double aPart = cursor;
-            const double bPart = (i + 1 == m_clients.size()) ? m_b : (cursor + partLen);
-            cursor = bPart;
-
-            TaskMsg t;
-            t.a = aPart;
-            t.b = bPart;
-            t.h = m_h;
-            t.method = m_method;
-            t.clientIndex = static_cast<quint32>(i);
-            t.clientCount = static_cast<quint32>(m_clients.size());
-
-            m_clients[i].framed->sendFrame(serializeTask(t));
-            qInfo() << "Sent TASK to client" << static_cast<int>(i) << ": [" << aPart << "," << bPart << "]";
+        if (!argValue(args, "--max-tenant-jobs").isEmpty()) {
+            limits.maxTenantJobs = argValue(args, "--max-tenant-jobs").toInt(&ok);
+            if (!ok) {
+                qCritical() << "Invalid --max-tenant-jobs";
+                return 1;
+            }
         }
-
-        m_timer.start();
-        m_dispatched = true;
-    }
-
-    /**
-     * @brief Finalize reduction when all partial results are received.
-     */
-    void maybeFinalize() {
-        if (!m_dispatched || m_finished) {
-            return;
+        if (!argValue(args, "--max-queue-delay").isEmpty()) {
+            limits.maxQueueDelaySec = argValue(args, "--max-queue-delay").toDouble(&ok);
+            if (!ok) {
+                qCritical() << "Invalid --max-queue-delay";
+                return 1;
+            }
         }
 
-        for (const auto &c : m_clients) {
-            if (!c.resultReceived) {
-                return;
+        netproj::ServerApp srv;
+        srv.setGranularity(granularity);
+        srv.setAdmissionLimits(limits);
+        srv.setDeduplication(!args.contains("--no-dedup"));
+        srv.setVerification(verifyBlocks, verifySamples);
+        if (!applyTenantWeights(args, srv) || !srv.setProfilesPath(profilesPath) ||
+            !srv.setTraceDir(argValue(args, "--trace-dir")) || !srv.setHistoryPath(argValue(args, "--history"))) {
+            return 1;
+        }
+        if (args.contains("--result-cache")) {
+            if (argValue(args, "--history").isEmpty()) {
+                qCritical() << "--result-cache requires --history";
+                return 1;
             }
+            srv.setResultCache(true);
         }
-
-        double sum = 0.0;
-        for (const auto &c : m_clients) {
-            sum += c.result;
+        if (!argValue(args, "--record").isEmpty() && !srv.setRecordPath(argValue(args, "--record"))) {
+            return 1;
         }
-
-        const qint64 ms = m_timer.elapsed();
-        qInfo() << "FINAL RESULT:" << sum << ", time=" << ms << "ms";
-        m_finished = true;
-
-        if (m_pauseOnFinish) {
-            QTextStream in(stdin);
-            QTextStream out(stdout);
-            out << "Press Enter to exit..." << Qt::endl;
-            in.readLine();
+        if (!srv.startService(port) || !addPeers(args, srv)) {
+            return 1;
         }
-
-        QCoreApplication::quit();
+        if (metricsPort != 0 && !srv.startMetrics(metricsPort, httpAddress)) {
+            return 1;
+        }
+        if (!argValue(args, "--gateway-port").isEmpty()) {
+            const quint16 gatewayPort = argValue(args, "--gateway-port").toUShort(&ok);
+            if (!ok || gatewayPort == 0) {
+                qCritical() << "Invalid --gateway-port";
+                return 1;
+            }
+            if (!srv.startGateway(gatewayPort, httpAddress)) {
+                return 1;
+            }
+        }
+        return app.exec();
     }
 
-    QTcpServer m_server;
-    QVector<ClientState> m_clients;
-    int m_expectedClients = 0;
-
-    double m_a = 2.0;
-    double m_b = 10.0;
-    double m_h = 1e-4;
-    MethodType m_method = MethodType::Simpson;
-
-    bool m_dispatched = false;
-    bool m_finished = false;
-    QElapsedTimer m_timer;
-
-    bool m_pauseOnFinish = false;
-};
-
-} // namespace netproj
-
-#include "server_main.moc"
-
-int main(int argc, char *argv[]) {
-    QCoreApplication app(argc, argv);
-
-    QTextStream in(stdin);
-    QTextStream out(stdout);
-
-    const QStringList args = QCoreApplication::arguments();
-    const bool pause = args.contains("--pause");
-
-    out << "Enter port: " << Qt::flush;
-    const QString portLine = in.readLine().trimmed();
+    // Job-file mode runs unattended, so port and client count may come from the command line as well.
+    QString portLine = argValue(args, "--port");
+    if (portLine.isEmpty()) {
+        out << "Enter port: " << Qt::flush;
+        portLine = in.readLine().trimmed();
+    }
     bool ok = false;
     const quint16 port = static_cast<quint16>(portLine.toUShort(&ok));
     if (!ok || port == 0) {
@@ -303,50 +213,84 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    out << "Enter expected client count N: " << Qt::flush;
-    const QString nLine = in.readLine().trimmed();
+    QString nLine = argValue(args, "--clients");
+    if (nLine.isEmpty()) {
+        out << "Enter expected client count N: " << Qt::flush;
+        nLine = in.readLine().trimmed();
+    }
     const int n = nLine.toInt(&ok);
     if (!ok || n <= 0) {
         qCritical() << "Invalid client count";
         return 1;
     }
 
-    out << "Enter A B h method(1=mid,2=trap,3=simp): " << Qt::flush;
-    const QString paramsLine = in.readLine().trimmed();
-    const QStringList parts = paramsLine.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-    if (parts.size() < 4) {
-        qCritical() << "Invalid parameters line";
+    netproj::ServerApp srv;
+    srv.setPauseOnFinish(pause);
+    srv.setVerification(verifyBlocks, verifySamples);
+    if (!srv.setProfilesPath(profilesPath) || !srv.setTraceDir(argValue(args, "--trace-dir")) ||
+        !srv.setHistoryPath(argValue(args, "--history"))) {
         return 1;
     }
 
-    const double a = parts[0].toDouble(&ok);
-    if (!ok) {
-        qCritical() << "Invalid A";
-        return 1;
-    }
-    const double b = parts[1].toDouble(&ok);
-    if (!ok) {
-        qCritical() << "Invalid B";
-        return 1;
-    }
-    const double h = parts[2].toDouble(&ok);
-    if (!ok || !(h > 0.0)) {
-        qCritical() << "Invalid step h";
-        return 1;
-    }
-    const int method = parts[3].toInt(&ok);
-    if (!ok) {
-        qCritical() << "Invalid method";
-        return 1;
-    }
+    const QString jobsPath = argValue(args, "--jobs");
+    if (!jobsPath.isEmpty()) {
+        QFile f(jobsPath);
+        if (!f.open(QIODevice::ReadOnly)) {
+            qCritical() << "Cannot read job file" << jobsPath;
+            return 1;
+        }
+        std::vector<netproj::SubmitMsg> jobs;
+        QString error;
+        if (!netproj::parseJobFile(f.readAll(), &jobs, &error)) {
+            qCritical() << "Invalid job file" << jobsPath << ":" << error;
+            return 1;
+        }
+        qInfo() << "Loaded" << jobs.size() << "jobs from" << jobsPath;
+        srv.setJobFile(jobs, argValue(args, "--out"));
+    } else {
+        out << "Enter A B h method(1=mid,2=trap,3=simp): " << Qt::flush;
+        const QString paramsLine = in.readLine().trimmed();
+        const QStringList parts = paramsLine.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        if (parts.size() < 4) {
+            qCritical() << "Invalid parameters line";
+            return 1;
+        }
 
-    netproj::ServerApp srv;
-    srv.setPauseOnFinish(pause);
-    srv.setTask(a, b, h, netproj::parseMethod(method));
+        const double a = parts[0].toDouble(&ok);
+        if (!ok) {
+            qCritical() << "Invalid A";
+            return 1;
+        }
+        const double b = parts[1].toDouble(&ok);
+        if (!ok) {
+            qCritical() << "Invalid B";
+            return 1;
+        }
+        const double h = parts[2].toDouble(&ok);
+        if (!ok || !(h > 0.0)) {
+            qCritical() << "Invalid step h";
+            return 1;
+        }
+        const int method = parts[3].toInt(&ok);
+        if (!ok) {
+            qCritical() << "Invalid method";
+            return 1;
+        }
+        try {
+            netproj::Integrator::validate(a, b, h);
+        } catch (const std::exception &e) {
+            qCritical() << "Invalid parameters:" << e.what();
+            return 1;
+        }
+        srv.setTask(a, b, h, netproj::parseMethod(method));
+    }
 
     if (!srv.start(port, n)) {
         return 1;
     }
+    if (metricsPort != 0 && !srv.startMetrics(metricsPort, httpAddress)) {
+        return 1;
+    }
 
     return app.exec();
 }
@@ -0,0 +1,159 @@
+#include "worker_profiles.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+
+namespace netproj {
+
+/**
+ * @brief Upper bound for the accumulated weight, so new observations always move the estimate noticeably.
+ */
+static constexpr double kMaxWeight = 16.0;
+
+/**
+ * @brief Entries whose decayed weight falls below this value are considered stale.
+ */
+static constexpr double kMinWeight = 0.05;
+
+WorkerProfileStore::WorkerProfileStore(double halfLifeSec)
+    : m_halfLifeSec(halfLifeSec > 0.0 ? halfLifeSec : 1.0) {
+}
+
+QString WorkerProfileStore::precisionKey(double h) {
+    if (!(h > 0.0)) {
+        return "invalid";
+    }
+    const int exp = static_cast<int>(std::floor(std::log10(h)));
+    return QString("1e%1").arg(exp);
+}
+
+QString WorkerProfileStore::entryKey(const QString &workerId, MethodType method, const QString &precision) {
+    return workerId + '|' + QString::number(static_cast<int>(method)) + '|' + precision;
+}
+
+double WorkerProfileStore::decayedWeight(const Entry &e, qint64 nowMs) const {
+    const double ageSec = std::max<qint64>(0, nowMs - e.updatedMs) / 1000.0;
+    return e.weight * std::exp2(-ageSec / m_halfLifeSec);
+}
+
+void WorkerProfileStore::record(const QString &workerId, MethodType method, double h, quint64 steps, double seconds,
+                                qint64 nowMs) {
+    if (workerId.isEmpty() || steps == 0 || !(seconds > 0.0)) {
+        return;
+    }
+
+    const double sample = static_cast<double>(steps) / seconds;
+    const QString precision = precisionKey(h);
+    Entry &e = m_entries[entryKey(workerId, method, precision)];
+
+    const double w = decayedWeight(e, nowMs);
+    e.workerId = workerId;
+    e.method = method;
+    e.precision = precision;
+    e.rate = (e.rate * w + sample) / (w + 1.0);
+    e.weight = std::min(kMaxWeight, w + 1.0);
+    e.updatedMs = nowMs;
+}
+
+std::optional<double> WorkerProfileStore::rate(const QString &workerId, MethodType method, double h,
+                                               qint64 nowMs) const {
+    const auto it = m_entries.constFind(entryKey(workerId, method, precisionKey(h)));
+    if (it != m_entries.constEnd() && decayedWeight(*it, nowMs) >= kMinWeight) {
+        return it->rate;
+    }
+
+    // Cost per step barely depends on h, so other precision buckets of the same method are a good estimate.
+    double weightSum = 0.0;
+    double rateSum = 0.0;
+    for (const Entry &e : m_entries) {
+        if (e.workerId != workerId || e.method != method) {
+            continue;
+        }
+        const double w = decayedWeight(e, nowMs);
+        if (w < kMinWeight) {
+            continue;
+        }
+        weightSum += w;
+        rateSum += e.rate * w;
+    }
+    if (weightSum > 0.0) {
+        return rateSum / weightSum;
+    }
+    return std::nullopt;
+}
+
+bool WorkerProfileStore::load(const QString &path) {
+    QFile file(path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    // Stored weights are decayed with the configured half-life from now on; a different one changes how fast the
+    // saved profiles age, so say so rather than switching silently.
+    const double savedHalfLifeSec = doc.object().value("half_life_sec").toDouble(m_halfLifeSec);
+    if (savedHalfLifeSec != m_halfLifeSec) {
+        qWarning() << "Worker profiles in" << path << "were saved with a half-life of" << savedHalfLifeSec
+                   << "s; using" << m_halfLifeSec << "s";
+    }
+
+    m_entries.clear();
+    const QJsonArray profiles = doc.object().value("profiles").toArray();
+    for (const QJsonValue &v : profiles) {
+        const QJsonObject o = v.toObject();
+        Entry e;
+        e.workerId = o.value("worker").toString();
+        e.method = static_cast<MethodType>(o.value("method").toInt());
+        e.precision = o.value("precision").toString();
+        e.rate = o.value("rate").toDouble();
+        e.weight = o.value("weight").toDouble();
+        e.updatedMs = static_cast<qint64>(o.value("updated_ms").toDouble());
+        if (e.workerId.isEmpty() || !(e.rate > 0.0)) {
+            continue;
+        }
+        m_entries.insert(entryKey(e.workerId, e.method, e.precision), e);
+    }
+    return true;
+}
+
+bool WorkerProfileStore::save(const QString &path) const {
+    QJsonArray profiles;
+    for (const Entry &e : m_entries) {
+        QJsonObject o;
+        o.insert("worker", e.workerId);
+        o.insert("method", static_cast<int>(e.method));
+        o.insert("precision", e.precision);
+        o.insert("rate", e.rate);
+        o.insert("weight", e.weight);
+        o.insert("updated_ms", static_cast<double>(e.updatedMs));
+        profiles.append(o);
+    }
+
+    QJsonObject root;
+    root.insert("half_life_sec", m_halfLifeSec);
+    root.insert("profiles", profiles);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+} // namespace netproj
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../common/protocol.h"
+
+#include <QHash>
+#include <QString>
+
+#include <optional>
+
+namespace netproj {
+
+/**
+ * @brief Persistent per-worker throughput database.
+ *
+ * Observed throughput (integration steps per second) is kept per worker id, method and precision bucket
+ * of the step h. Older observations lose weight exponentially with the configured half-life, so a worker
+ * that got throttled or had its hardware replaced converges to its new speed after a few tasks.
+ *
+ * The store is saved as a small JSON file and is used by the server to size the first assignments of a job.
+ */
+class WorkerProfileStore {
+public:
+    /**
+     * @brief Construct an empty store.
+     * @param halfLifeSec Age (seconds) after which an observation keeps half of its weight.
+     */
+    explicit WorkerProfileStore(double halfLifeSec = 7.0 * 24.0 * 3600.0);
+
+    /**
+     * @brief Load profiles from a JSON file. A missing file is not an error (empty store).
+     *
+     * The store keeps its own half-life and warns if the file was saved with another one.
+     * @return false if the file exists but cannot be read or parsed.
+     */
+    bool load(const QString &path);
+
+    /**
+     * @brief Save profiles to a JSON file.
+     */
+    bool save(const QString &path) const;
+
+    /**
+     * @brief Record one finished task of a worker.
+     *
+     * @param workerId Stable worker identifier from HELLO.
+     * @param method Integration method of the task.
+     * @param h Step of the task.
+     * @param steps Number of steps computed.
+     * @param seconds Wall time the task took.
+     * @param nowMs Current time (ms since epoch).
+     */
+    void record(const QString &workerId, MethodType method, double h, quint64 steps, double seconds, qint64 nowMs);
+
+    /**
+     * @brief Predicted throughput (steps/second) of a worker, if it has a sufficiently fresh profile.
+     *
+     * Falls back to other precision buckets of the same method when the exact bucket is unknown.
+     */
+    std::optional<double> rate(const QString &workerId, MethodType method, double h, qint64 nowMs) const;
+
+    /**
+     * @brief Number of (worker, method, precision) entries.
+     */
+    int size() const { return m_entries.size(); }
+
+    /**
+     * @brief Precision bucket name for a step, e.g. "1e-4" for h in [1e-4, 1e-3).
+     */
+    static QString precisionKey(double h);
+
+private:
+    struct Entry {
+        QString workerId;
+        MethodType method = MethodType::Simpson;
+        QString precision;
+        double rate = 0.0;
+        double weight = 0.0;
+        qint64 updatedMs = 0;
+    };
+
+    static QString entryKey(const QString &workerId, MethodType method, const QString &precision);
+    double decayedWeight(const Entry &e, qint64 nowMs) const;
+
+    double m_halfLifeSec;
+    QHash<QString, Entry> m_entries;
+};
+
+} // namespace netproj
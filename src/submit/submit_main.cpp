@@ -0,0 +1,153 @@
+#include "../sdk/job_client.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+namespace netproj {
+
+/**
+ * @brief Submitter application: sends jobs to a service-mode server and prints their results.
+ *
+ * All jobs are pipelined over one JobClient connection; results may arrive in any order.
+ */
+class SubmitApp : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct submitter app.
+     */
+    explicit SubmitApp(QObject *parent = nullptr)
+        : QObject(parent) {
+        connect(&m_client, &JobClient::connected, this,
+                [this]() { qInfo() << "Submitted" << m_client.inFlight() << "jobs"; });
+        connect(&m_client, &JobClient::disconnected, this, [](const QString &reason) {
+            qWarning() << "Disconnected:" << reason;
+            QCoreApplication::quit();
+        });
+    }
+
+    /**
+     * @brief Set jobs to submit.
+     */
+    void setJobs(const QVector<SubmitMsg> &jobs) { m_jobs = jobs; }
+
+    /**
+     * @brief Resubmit deferred jobs after the server's retry hint (default) or treat deferral as failure.
+     */
+    void setRetryDeferred(bool v) { m_client.setRetryDeferred(v); }
+
+    /**
+     * @brief Connect to server by host and port and submit all jobs.
+     */
+    void connectTo(const QString &host, quint16 port) {
+        for (const SubmitMsg &m : m_jobs) {
+            m_client.submit(m, [this](const JobResultMsg &r) { onResult(r); });
+        }
+        m_pending = m_jobs.size();
+        m_client.connectToServer(host, port);
+    }
+
+    /**
+     * @brief Process exit code: 0 if every job succeeded.
+     */
+    int exitCode() const { return m_failed == 0 && m_pending == 0 ? 0 : 1; }
+
+private:
+    /**
+     * @brief Print one job's result; quit after the last one.
+     */
+    void onResult(const JobResultMsg &r) {
+        QTextStream out(stdout);
+        out << "request " << r.requestId << " job " << r.jobId << " " << jobStatusName(r.status) << " value "
+            << QString::number(r.value, 'g', 17) << " time " << r.elapsedMs << "ms";
+        if (!r.error.isEmpty()) {
+            out << " error \"" << r.error << "\"";
+        }
+        out << Qt::endl;
+
+        if (r.status != JobStatus::Ok) {
+            ++m_failed;
+        }
+        if (--m_pending == 0) {
+            QCoreApplication::quit();
+        }
+    }
+
+    JobClient m_client;
+    QVector<SubmitMsg> m_jobs;
+    int m_pending = 0;
+    int m_failed = 0;
+};
+
+} // namespace netproj
+
+#include "submit_main.moc"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QTextStream in(stdin);
+    QTextStream out(stdout);
+
+    const QStringList args = QCoreApplication::arguments();
+
+    QString host = "127.0.0.1";
+    quint16 port = 0;
+    QString tenant = "default";
+    netproj::JobPriority priority = netproj::JobPriority::Normal;
+    QStringList jobLines;
+
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        const QString &opt = args[i];
+        const QString &val = args[i + 1];
+        if (opt == "--host") {
+            host = val;
+        } else if (opt == "--port") {
+            port = val.toUShort();
+        } else if (opt == "--tenant") {
+            tenant = val;
+        } else if (opt == "--priority") {
+            if (!netproj::parsePriority(val, &priority)) {
+                qCritical() << "Invalid --priority (expected batch, normal or interactive)";
+                return 1;
+            }
+        } else if (opt == "--job") {
+            jobLines.push_back(val);
+        } else {
+            continue;
+        }
+        ++i;
+    }
+
+    if (port == 0) {
+        qCritical() << "Missing or invalid --port";
+        return 1;
+    }
+    if (jobLines.isEmpty()) {
+        out << "Enter A B h method(1=mid,2=trap,3=simp): " << Qt::flush;
+        jobLines.push_back(in.readLine());
+    }
+
+    QVector<netproj::SubmitMsg> jobs;
+    for (const QString &line : jobLines) {
+        netproj::SubmitMsg m;
+        QString error;
+        if (!netproj::parseJobLine(line, &m, &error)) {
+            qCritical() << "Invalid job:" << error;
+            return 1;
+        }
+        m.tenant = tenant;
+        m.priority = priority;
+        jobs.push_back(m);
+    }
+
+    netproj::SubmitApp submitter;
+    submitter.setJobs(jobs);
+    submitter.setRetryDeferred(!args.contains("--no-retry"));
+    submitter.connectTo(host, port);
+
+    const int rc = app.exec();
+    return rc != 0 ? rc : submitter.exitCode();
+}
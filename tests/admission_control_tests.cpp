@@ -0,0 +1,66 @@
+#include "../src/server/admission_control.h"
+
+#include <gtest/gtest.h>
+
+using netproj::AdmissionController;
+using netproj::AdmissionDecision;
+using netproj::AdmissionLimits;
+using netproj::JobPriority;
+using netproj::JobScheduler;
+using netproj::JobSpec;
+
+static JobSpec makeJob(double b, JobPriority priority = JobPriority::Normal) {
+    JobSpec s;
+    s.a = 2.0;
+    s.b = b;
+    s.h = 1e-3;
+    s.tenant = "t";
+    s.priority = priority;
+    return s;
+}
+
+TEST(AdmissionControl, RejectsJobLargerThanDelayBound) {
+    JobScheduler sched;
+    sched.setDefaultCoreRate(1000.0);
+    sched.addWorker(1, 1);
+
+    AdmissionLimits limits;
+    limits.maxQueueDelaySec = 10.0;
+    AdmissionController adm;
+    adm.setLimits(limits);
+
+    // 8000 steps at 1000 steps/s fits, 98000 steps does not.
+    EXPECT_EQ(adm.evaluate(makeJob(10.0), sched).kind, AdmissionDecision::Kind::Admit);
+    EXPECT_EQ(adm.evaluate(makeJob(100.0), sched).kind, AdmissionDecision::Kind::Reject);
+}
+
+TEST(AdmissionControl, DefersBehindBacklogButNotAboveIt) {
+    JobScheduler sched;
+    sched.setDefaultCoreRate(1000.0);
+    sched.addWorker(1, 1);
+    sched.submit(makeJob(10.0, JobPriority::Batch));
+
+    AdmissionLimits limits;
+    limits.maxQueueDelaySec = 10.0;
+    AdmissionController adm;
+    adm.setLimits(limits);
+
+    const AdmissionDecision d = adm.evaluate(makeJob(10.0, JobPriority::Batch), sched);
+    EXPECT_EQ(d.kind, AdmissionDecision::Kind::Defer);
+    EXPECT_GT(d.retryAfterMs, 0);
+
+    // Interactive jobs preempt the batch backlog, so it does not count against them.
+    EXPECT_EQ(adm.evaluate(makeJob(10.0, JobPriority::Interactive), sched).kind, AdmissionDecision::Kind::Admit);
+}
+
+TEST(AdmissionControl, DefersWhenQueueIsFull) {
+    JobScheduler sched;
+    sched.submit(makeJob(10.0));
+
+    AdmissionLimits limits;
+    limits.maxActiveJobs = 1;
+    AdmissionController adm;
+    adm.setLimits(limits);
+
+    EXPECT_EQ(adm.evaluate(makeJob(10.0), sched).kind, AdmissionDecision::Kind::Defer);
+}
@@ -0,0 +1,83 @@
+#include "../src/common/async_log.h"
+#include "../src/common/spsc_ring.h"
+
+#include <QDebug>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using netproj::AsyncLog;
+using netproj::LogFormat;
+using netproj::LogLevel;
+using netproj::SpscRing;
+
+TEST(SpscRing, FifoUntilFull) {
+    SpscRing<int> ring(3);
+    EXPECT_EQ(ring.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.push(int(i)));
+    }
+    EXPECT_FALSE(ring.push(4));
+
+    int v = -1;
+    EXPECT_TRUE(ring.pop(&v));
+    EXPECT_EQ(v, 0);
+    EXPECT_TRUE(ring.push(4));
+    for (int i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(ring.pop(&v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(ring.pop(&v));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRing, ConcurrentProducerKeepsOrder) {
+    constexpr int kItems = 200000;
+    SpscRing<int> ring(64);
+    std::thread producer([&ring] {
+        for (int i = 0; i < kItems; ++i) {
+            while (!ring.push(int(i))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    while (expected < kItems) {
+        int v = -1;
+        if (ring.pop(&v)) {
+            ASSERT_EQ(v, expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(AsyncLog, WritesEnabledLevelsInOrder) {
+    FILE *f = std::tmpfile();
+    ASSERT_NE(f, nullptr);
+    {
+        AsyncLog log(LogLevel::Info, LogFormat::Text, f);
+        qCDebug(netproj::lcMessages) << "per-message detail";
+        std::thread other([] {
+            qInfo() << "first";
+        });
+        other.join();
+        qWarning() << "second";
+    }
+    std::string text(4096, '\0');
+    std::rewind(f);
+    text.resize(std::fread(&text[0], 1, text.size(), f));
+    std::fclose(f);
+
+    EXPECT_EQ(text.find("per-message detail"), std::string::npos);
+    const size_t first = text.find("INFO    [");
+    const size_t second = text.find("WARNING [");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_NE(text.find("first"), std::string::npos);
+}
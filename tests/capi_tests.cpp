@@ -0,0 +1,174 @@
+#include "../include/netproj/netproj.h"
+#include "../src/common/frame_decoder.h"
+#include "../src/common/integrator.h"
+#include "../src/common/message_io.h"
+
+#include <gtest/gtest.h>
+
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Service-mode server stand-in on a thread of its own, since the C client blocks the test's thread.
+ *
+ * Accepts one connection and answers every SUBMIT with a JOB_RESULT of value a + b (error: the tenant) until the
+ * client disconnects.
+ */
+class FakeServer {
+public:
+    FakeServer() {
+        std::promise<quint16> listening;
+        std::future<quint16> port = listening.get_future();
+        m_thread = std::thread([this, &listening]() { run(&listening); });
+        m_port = port.get();
+    }
+
+    ~FakeServer() { m_thread.join(); }
+
+    quint16 port() const { return m_port; }
+
+private:
+    void run(std::promise<quint16> *listening) {
+        QTcpServer server;
+        if (!server.listen(QHostAddress::LocalHost, 0)) {
+            listening->set_value(0);
+            return;
+        }
+        listening->set_value(server.serverPort());
+        if (!server.waitForNewConnection(5000)) {
+            return;
+        }
+        std::unique_ptr<QTcpSocket> socket(server.nextPendingConnection());
+        netproj::FrameDecoder decoder;
+        QByteArray frame;
+        while (socket->waitForReadyRead(5000)) {
+            decoder.append(socket->readAll());
+            while (decoder.nextView(&frame)) {
+                const netproj::ParsedMessage pm = netproj::parseMessage(frame);
+                if (!pm.ok || pm.env.type != netproj::MessageType::Submit) {
+                    continue;
+                }
+                netproj::JobResultMsg r;
+                r.requestId = pm.submit.requestId;
+                r.jobId = 40 + pm.submit.requestId;
+                r.status = netproj::JobStatus::Ok;
+                r.value = pm.submit.a + pm.submit.b;
+                r.elapsedMs = 12;
+                r.units = 3;
+                r.error = pm.submit.tenant;
+                socket->write(netproj::FrameDecoder::encode(netproj::serializeJobResult(r)));
+                socket->waitForBytesWritten(5000);
+            }
+        }
+    }
+
+    std::thread m_thread;
+    quint16 m_port = 0;
+};
+
+netproj_job sampleJob() {
+    netproj_job job{};
+    job.struct_size = sizeof job;
+    job.a = 2.0;
+    job.b = 10.0;
+    job.h = 1e-4;
+    job.method = NETPROJ_METHOD_SIMPSON;
+    job.priority = NETPROJ_PRIORITY_NORMAL;
+    job.tenant = "analytics";
+    return job;
+}
+
+} // namespace
+
+TEST(CApi, IntegratesLikeIntegrator) {
+    EXPECT_EQ(netproj_api_version(), NETPROJ_API_VERSION);
+
+    double value = 0.0;
+    ASSERT_EQ(netproj_integrate(2.0, 10.0, 1e-4, NETPROJ_METHOD_SIMPSON, &value), NETPROJ_OK);
+    EXPECT_EQ(value, netproj::Integrator::integrate(2.0, 10.0, 1e-4, netproj::MethodType::Simpson));
+    ASSERT_EQ(netproj_integrate(2.0, 3.0, 1e-3, NETPROJ_METHOD_MIDPOINT, &value), NETPROJ_OK);
+    EXPECT_EQ(value, netproj::Integrator::integrate(2.0, 3.0, 1e-3, netproj::MethodType::MidpointRectangles));
+    EXPECT_EQ(netproj_step_count(2.0, 3.0, 0.1), 10u);
+    EXPECT_EQ(netproj_step_count(2.0, 3.0, 0.0), 0u);
+}
+
+TEST(CApi, ReportsErrorsInsteadOfThrowing) {
+    double value = 0.0;
+    EXPECT_EQ(netproj_integrate(0.5, 2.0, 0.1, NETPROJ_METHOD_TRAPEZOIDS, &value), NETPROJ_ERR_INVALID_ARGUMENT);
+    EXPECT_GT(std::strlen(netproj_last_error()), 0u);
+    EXPECT_EQ(netproj_integrate(2.0, 10.0, 0.0, NETPROJ_METHOD_SIMPSON, &value), NETPROJ_ERR_INVALID_ARGUMENT);
+    EXPECT_EQ(netproj_integrate(2.0, 10.0, 0.1, static_cast<netproj_method>(9), &value), NETPROJ_ERR_INVALID_ARGUMENT);
+    EXPECT_EQ(netproj_integrate(2.0, 10.0, 0.1, NETPROJ_METHOD_SIMPSON, nullptr), NETPROJ_ERR_INVALID_ARGUMENT);
+    EXPECT_STREQ(netproj_status_string(NETPROJ_ERR_TIMEOUT), "timed out");
+}
+
+TEST(CApi, ValidatesClientArguments) {
+    netproj_client *client = reinterpret_cast<netproj_client *>(1);
+    EXPECT_EQ(netproj_client_open(nullptr, 5000, 100, &client), NETPROJ_ERR_INVALID_ARGUMENT);
+    EXPECT_EQ(client, nullptr);
+    EXPECT_EQ(netproj_client_open("127.0.0.1", 0, 100, &client), NETPROJ_ERR_INVALID_ARGUMENT);
+    netproj_client_close(nullptr);
+
+    netproj_job job{};
+    netproj_job_result result{};
+    EXPECT_EQ(netproj_client_submit(nullptr, &job, &result, 100), NETPROJ_ERR_INVALID_ARGUMENT);
+}
+
+TEST(CApi, FailsToConnectToClosedPort) {
+    // Port 1 (tcpmux) is not served on test machines, so the connection is refused at once.
+    netproj_client *client = nullptr;
+    EXPECT_EQ(netproj_client_open("127.0.0.1", 1, 2000, &client), NETPROJ_ERR_CONNECT);
+    EXPECT_EQ(client, nullptr);
+    EXPECT_GT(std::strlen(netproj_last_error()), 0u);
+}
+
+TEST(CApi, SubmitsJobsAndFillsResults) {
+    FakeServer server;
+    ASSERT_NE(server.port(), 0);
+    netproj_client *client = nullptr;
+    ASSERT_EQ(netproj_client_open("127.0.0.1", server.port(), 5000, &client), NETPROJ_OK) << netproj_last_error();
+
+    const netproj_job job = sampleJob();
+    netproj_job_result result{};
+    result.struct_size = sizeof result;
+    ASSERT_EQ(netproj_client_submit(client, &job, &result, 5000), NETPROJ_OK) << netproj_last_error();
+    EXPECT_EQ(result.struct_size, sizeof result);
+    EXPECT_EQ(result.job_id, 41u);
+    EXPECT_EQ(result.status, NETPROJ_JOB_OK);
+    EXPECT_DOUBLE_EQ(result.value, 12.0);
+    EXPECT_EQ(result.elapsed_ms, 12);
+    EXPECT_EQ(result.units, 3u);
+    EXPECT_STREQ(result.error, "analytics");
+
+    // A caller built against a newer header passes larger structures; fields unknown here come back zero.
+    struct {
+        netproj_job_result v1;
+        uint64_t added;
+    } newer{};
+    newer.v1.struct_size = sizeof newer;
+    newer.added = 99;
+    ASSERT_EQ(netproj_client_submit(client, &job, &newer.v1, 5000), NETPROJ_OK) << netproj_last_error();
+    EXPECT_EQ(newer.v1.struct_size, sizeof newer);
+    EXPECT_EQ(newer.v1.job_id, 42u);
+    EXPECT_EQ(newer.added, 0u);
+
+    // Anything smaller than the first version of a structure is a caller that did not set struct_size.
+    netproj_job_result truncated{};
+    truncated.struct_size = offsetof(netproj_job_result, error);
+    EXPECT_EQ(netproj_client_submit(client, &job, &truncated, 5000), NETPROJ_ERR_INVALID_ARGUMENT);
+    netproj_job unsized = job;
+    unsized.struct_size = 0;
+    EXPECT_EQ(netproj_client_submit(client, &unsized, &result, 5000), NETPROJ_ERR_INVALID_ARGUMENT);
+
+    netproj_client_close(client);
+}
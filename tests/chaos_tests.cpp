@@ -0,0 +1,74 @@
+#include "../src/harness/chaos.h"
+
+#include <gtest/gtest.h>
+
+using netproj::ChaosSpec;
+using netproj::FaultKind;
+using netproj::FaultPlan;
+
+TEST(Chaos, ParsesFaultSpec) {
+    ChaosSpec spec;
+    QString error;
+    ASSERT_TRUE(netproj::parseChaos("kill-every=5000, pause-every=2000,pause=300,restart-delay=100", &spec, &error));
+    EXPECT_DOUBLE_EQ(spec.killEveryMs, 5000.0);
+    EXPECT_DOUBLE_EQ(spec.pauseEveryMs, 2000.0);
+    EXPECT_DOUBLE_EQ(spec.pauseMs, 300.0);
+    EXPECT_DOUBLE_EQ(spec.restartEveryMs, 0.0);
+    EXPECT_DOUBLE_EQ(spec.restartDelayMs, 100.0);
+
+    EXPECT_FALSE(netproj::parseChaos("crash-every=10", &spec, &error));
+    EXPECT_FALSE(netproj::parseChaos("kill-every=x", &spec, &error));
+    // Without any fault rate a chaos run would be a plain benchmark.
+    EXPECT_FALSE(netproj::parseChaos("pause=100", &spec, &error));
+}
+
+TEST(Chaos, DrawsFaultsByRate) {
+    ChaosSpec spec;
+    spec.killEveryMs = 1000.0;
+    spec.pauseEveryMs = 250.0;
+    FaultPlan plan(spec, 7);
+
+    const int n = 20000;
+    int kills = 0;
+    int pauses = 0;
+    qint64 totalMs = 0;
+    for (int i = 0; i < n; ++i) {
+        const netproj::FaultEvent e = plan.next();
+        ASSERT_GE(e.delayMs, 0);
+        totalMs += e.delayMs;
+        kills += (e.kind == FaultKind::Kill) ? 1 : 0;
+        pauses += (e.kind == FaultKind::Pause) ? 1 : 0;
+    }
+    EXPECT_EQ(kills + pauses, n);
+    // Pauses are four times as frequent; together one fault every 200 ms on average.
+    EXPECT_NEAR(static_cast<double>(pauses) / n, 0.8, 0.02);
+    EXPECT_NEAR(static_cast<double>(totalMs) / n, 200.0, 10.0);
+
+    FaultPlan again(spec, 7);
+    FaultPlan other(spec, 7);
+    for (int i = 0; i < 100; ++i) {
+        const netproj::FaultEvent a = again.next();
+        const netproj::FaultEvent b = other.next();
+        EXPECT_EQ(a.delayMs, b.delayMs);
+        EXPECT_EQ(a.kind, b.kind);
+        EXPECT_EQ(again.pick(5), other.pick(5));
+    }
+}
+
+TEST(Chaos, ComparesResultsUpToSummationOrder) {
+    EXPECT_TRUE(netproj::sameResult(5.120435, 5.120435 * (1.0 + 1e-13)));
+    EXPECT_FALSE(netproj::sameResult(5.120435, 5.120436));
+    // A unit lost twice or summed twice is off by a whole unit's contribution.
+    EXPECT_FALSE(netproj::sameResult(5.120435, 5.120435 * 1.01));
+    EXPECT_TRUE(netproj::sameResult(0.0, 1e-12));
+}
+
+TEST(Chaos, SummarizesRecoveryTimes) {
+    netproj::RecoveryStats s;
+    EXPECT_DOUBLE_EQ(s.meanMs(), 0.0);
+    s.add(100.0);
+    s.add(300.0);
+    EXPECT_EQ(s.count, 2);
+    EXPECT_DOUBLE_EQ(s.meanMs(), 200.0);
+    EXPECT_DOUBLE_EQ(s.maxMs, 300.0);
+}
@@ -0,0 +1,74 @@
+#include "../src/common/frame_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using netproj::FrameDecoder;
+
+TEST(FrameDecoder, ReassemblesFragmentedFrames) {
+    const QByteArray stream = FrameDecoder::encode("hello") + FrameDecoder::encode("world!");
+
+    FrameDecoder d;
+    std::vector<QByteArray> out;
+    QByteArray payload;
+    for (qsizetype i = 0; i < stream.size(); ++i) {
+        d.append(stream.mid(i, 1));
+        while (d.next(&payload)) {
+            out.push_back(payload);
+        }
+    }
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0], QByteArray("hello"));
+    EXPECT_EQ(out[1], QByteArray("world!"));
+    EXPECT_EQ(d.buffered(), 0);
+}
+
+TEST(FrameDecoder, SplitsCoalescedFrames) {
+    QByteArray stream;
+    for (int i = 0; i < 100; ++i) {
+        stream.append(FrameDecoder::encode(QByteArray(i, 'x')));
+    }
+    // Leave a partial header of the next frame behind.
+    stream.append(FrameDecoder::encode("tail").left(2));
+
+    FrameDecoder d;
+    d.append(stream);
+    QByteArray payload;
+    int n = 0;
+    while (d.next(&payload)) {
+        EXPECT_EQ(payload.size(), n);
+        ++n;
+    }
+    EXPECT_EQ(n, 100);
+    EXPECT_EQ(d.buffered(), 2);
+
+    d.append(FrameDecoder::encode("tail").mid(2));
+    ASSERT_TRUE(d.next(&payload));
+    EXPECT_EQ(payload, QByteArray("tail"));
+}
+
+TEST(FrameDecoder, DecodesInPlaceReads) {
+    QByteArray stream;
+    for (int i = 0; i < 50; ++i) {
+        stream.append(FrameDecoder::encode(QByteArray(i, static_cast<char>('a' + i % 26))));
+    }
+
+    FrameDecoder d;
+    QByteArray payload;
+    int n = 0;
+    // Reads of 7 bytes into room for 16, as a socket with fewer bytes available than asked for.
+    for (qsizetype off = 0; off < stream.size(); off += 7) {
+        const qsizetype got = std::min<qsizetype>(7, stream.size() - off);
+        std::memcpy(d.prepareAppend(16), stream.constData() + off, static_cast<size_t>(got));
+        d.commitAppend(got);
+        while (d.nextView(&payload)) {
+            EXPECT_EQ(payload, QByteArray(n, static_cast<char>('a' + n % 26)));
+            ++n;
+        }
+    }
+    EXPECT_EQ(n, 50);
+    EXPECT_EQ(d.buffered(), 0);
+}
@@ -10,7 +10,24 @@ TEST(Integrator, RejectsZeroStep) {
     EXPECT_THROW(netproj::Integrator::integrate(2.0, 10.0, 0.0, netproj::MethodType::Simpson), std::invalid_argument);
 }
 
+TEST(Integrator, RejectsTooManySteps) {
+    EXPECT_THROW(netproj::Integrator::validate(2.0, 1e300, 1e-300), std::invalid_argument);
+    EXPECT_THROW(netproj::Integrator::validate(-1e308, 0.5, 1e-300), std::invalid_argument);
+    EXPECT_NO_THROW(netproj::Integrator::validate(2.0, 10.0, 1e-9));
+}
+
 TEST(Integrator, ReferenceIntegralSimpson) {
     const double v = netproj::Integrator::integrate(2.0, 10.0, 1e-4, netproj::MethodType::Simpson);
     EXPECT_NEAR(v, 5.120435, 2e-3);
 }
+
+TEST(Integrator, EvaluationCount) {
+    using netproj::Integrator;
+    using netproj::MethodType;
+    EXPECT_EQ(Integrator::evaluationCount(2.0, 3.0, 0.1, MethodType::MidpointRectangles), 10u);
+    EXPECT_EQ(Integrator::evaluationCount(3.0, 2.0, 0.1, MethodType::Trapezoids), 20u);
+    EXPECT_EQ(Integrator::evaluationCount(2.0, 3.0, 0.1, MethodType::Simpson), 11u);
+    EXPECT_EQ(Integrator::evaluationCount(2.0, 3.1, 0.1, MethodType::Simpson), 11u);
+    EXPECT_EQ(Integrator::evaluationCount(2.0, 2.15, 0.1, MethodType::Simpson), 2u);
+    EXPECT_EQ(Integrator::evaluationCount(2.0, 2.0, 0.1, MethodType::Simpson), 0u);
+}
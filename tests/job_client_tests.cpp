@@ -0,0 +1,53 @@
+#include "../src/sdk/job_client.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+
+using netproj::IntegrateAwaiter;
+using netproj::JobClient;
+using netproj::JobResultMsg;
+using netproj::JobStatus;
+using netproj::SubmitMsg;
+
+namespace {
+
+/**
+ * @brief Stands in for std::coroutine_handle<>, so the awaiter can be driven from C++17.
+ */
+struct FakeHandle {
+    int *resumed = nullptr;
+    void resume() const { ++*resumed; }
+};
+
+} // namespace
+
+TEST(JobClient, CompletesOutstandingJobsWhenDestroyed) {
+    auto client = std::make_unique<JobClient>();
+    std::optional<JobResultMsg> first;
+    SubmitMsg job;
+    job.a = 2.0;
+    job.b = 10.0;
+    job.h = 1e-6;
+    EXPECT_EQ(client->submit(job, [&first](const JobResultMsg &r) { first = r; }), 1u);
+
+    int resumed = 0;
+    IntegrateAwaiter awaiter = client->integrate(job);
+    EXPECT_FALSE(awaiter.await_ready());
+    awaiter.await_suspend(FakeHandle{&resumed});
+    EXPECT_EQ(client->inFlight(), 2);
+    EXPECT_EQ(resumed, 0);
+
+    // Never connected, so both jobs are still queued; an awaiting coroutine must not be left suspended.
+    client.reset();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->requestId, 1u);
+    EXPECT_EQ(first->status, JobStatus::Failed);
+    EXPECT_EQ(first->error, "client destroyed");
+    EXPECT_EQ(resumed, 1);
+    const JobResultMsg second = awaiter.await_resume();
+    EXPECT_EQ(second.requestId, 2u);
+    EXPECT_EQ(second.status, JobStatus::Failed);
+    EXPECT_FALSE(second.error.isEmpty());
+}
@@ -0,0 +1,106 @@
+#include "../src/common/job_file.h"
+
+#include <gtest/gtest.h>
+
+using netproj::JobFileResult;
+using netproj::JobStatus;
+using netproj::MethodType;
+using netproj::SubmitMsg;
+
+TEST(JobFile, ParsesJobLines) {
+    SubmitMsg m;
+    QString error;
+    ASSERT_TRUE(netproj::parseJobLine("  2 10\t1e-6 2 ", &m, &error));
+    EXPECT_DOUBLE_EQ(m.a, 2.0);
+    EXPECT_DOUBLE_EQ(m.b, 10.0);
+    EXPECT_DOUBLE_EQ(m.h, 1e-6);
+    EXPECT_EQ(m.method, MethodType::Trapezoids);
+
+    EXPECT_FALSE(netproj::parseJobLine("2 10 1e-6", &m, &error));
+    EXPECT_FALSE(netproj::parseJobLine("2 10 0 3", &m, &error));
+    EXPECT_FALSE(netproj::parseJobLine("2 x 1e-6 3", &m, &error));
+    EXPECT_FALSE(netproj::parseJobLine("2 10 1e-6 7", &m, &error));
+    EXPECT_FALSE(netproj::parseJobLine("2 10 1e-6 0", &m, &error));
+    ASSERT_TRUE(netproj::parseJobLine("2 10 1e-6 simpson", &m, &error));
+    EXPECT_EQ(m.method, MethodType::Simpson);
+}
+
+TEST(JobFile, ParsesMethodAndStatusNames) {
+    MethodType m = MethodType::Simpson;
+    ASSERT_TRUE(netproj::parseMethodName("1", &m));
+    EXPECT_EQ(m, MethodType::MidpointRectangles);
+    ASSERT_TRUE(netproj::parseMethodName(" Trapezoids ", &m));
+    EXPECT_EQ(m, MethodType::Trapezoids);
+    EXPECT_FALSE(netproj::parseMethodName("4", &m));
+    EXPECT_FALSE(netproj::parseMethodName("2.5", &m));
+    EXPECT_FALSE(netproj::parseMethodName("romberg", &m));
+
+    JobStatus s = JobStatus::Ok;
+    ASSERT_TRUE(netproj::parseJobStatus("deferred", &s));
+    EXPECT_EQ(s, JobStatus::Deferred);
+    EXPECT_FALSE(netproj::parseJobStatus("done", &s));
+}
+
+TEST(JobFile, ParsesLineFilesSkippingComments) {
+    std::vector<SubmitMsg> jobs;
+    QString error;
+    ASSERT_TRUE(netproj::parseJobFile("# sweep\n2 10 1e-4 3\n\n  # h halves\n2 10 5e-5 1\n", &jobs, &error))
+        << error.toStdString();
+    ASSERT_EQ(jobs.size(), 2u);
+    EXPECT_DOUBLE_EQ(jobs[0].h, 1e-4);
+    EXPECT_EQ(jobs[0].method, MethodType::Simpson);
+    EXPECT_EQ(jobs[0].tenant, "default");
+    EXPECT_EQ(jobs[1].method, MethodType::MidpointRectangles);
+
+    EXPECT_FALSE(netproj::parseJobFile("2 10 1e-4 3\n2 10 1e-4\n", &jobs, &error));
+    EXPECT_TRUE(error.startsWith("line 2"));
+    EXPECT_FALSE(netproj::parseJobFile("# nothing to do\n", &jobs, &error));
+    // Rejected like the server would reject it, before any job runs.
+    EXPECT_FALSE(netproj::parseJobFile("2 10 1e-4 3\n0.5 10 1e-4 3\n", &jobs, &error));
+    EXPECT_TRUE(error.startsWith("job 2"));
+}
+
+TEST(JobFile, ParsesJsonArrays) {
+    std::vector<SubmitMsg> jobs;
+    QString error;
+    ASSERT_TRUE(netproj::parseJobFile(R"([{"a": 2, "b": 10, "h": 1e-4, "method": "trapezoids"},
+                                          {"a": 2, "b": 10, "h": 1e-4, "method": 3, "tenant": "lab",
+                                           "priority": "batch"}])",
+                                      &jobs, &error))
+        << error.toStdString();
+    ASSERT_EQ(jobs.size(), 2u);
+    EXPECT_EQ(jobs[0].method, MethodType::Trapezoids);
+    EXPECT_EQ(jobs[0].tenant, "default");
+    EXPECT_EQ(jobs[1].method, MethodType::Simpson);
+    EXPECT_EQ(jobs[1].tenant, "lab");
+    EXPECT_EQ(jobs[1].priority, netproj::JobPriority::Batch);
+
+    EXPECT_FALSE(netproj::parseJobFile(R"([{"a": 2, "b": 10, "h": 1e-4, "method": "gauss"}])", &jobs, &error));
+    EXPECT_FALSE(netproj::parseJobFile(R"([{"a": 2, "b": "10", "h": 1e-4}])", &jobs, &error));
+    EXPECT_FALSE(netproj::parseJobFile("[", &jobs, &error));
+}
+
+TEST(JobFile, WritesCsvRowsInFileOrder) {
+    std::vector<JobFileResult> results(2);
+    results[0].job.a = 2.0;
+    results[0].job.b = 10.0;
+    results[0].job.h = 1e-4;
+    results[0].job.tenant = "lab, north";
+    results[0].result.jobId = 7;
+    results[0].result.status = JobStatus::Ok;
+    results[0].result.elapsedMs = 42;
+    results[1].job = results[0].job;
+    results[1].job.tenant = "default";
+    results[1].result.jobId = 8;
+    results[1].result.status = JobStatus::Failed;
+    results[1].result.error = "no \"workers\"";
+
+    const QStringList lines = QString::fromUtf8(netproj::jobResultsCsv(results)).split('\n', Qt::SkipEmptyParts);
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_TRUE(lines[0].startsWith("index,a,b,h,method,tenant,priority,job_id,status,value,elapsed_ms,"));
+    EXPECT_TRUE(lines[1].startsWith("1,2,10,0.0001,"));
+    EXPECT_TRUE(lines[1].contains(",\"lab, north\","));
+    EXPECT_TRUE(lines[1].contains(",7,ok,"));
+    EXPECT_TRUE(lines[2].startsWith("2,"));
+    EXPECT_TRUE(lines[2].endsWith(",\"no \"\"workers\"\"\""));
+}
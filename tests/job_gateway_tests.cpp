@@ -0,0 +1,120 @@
+#include "../src/server/job_gateway.h"
+
+#include <gtest/gtest.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <optional>
+
+using netproj::HttpRequest;
+using netproj::HttpResponse;
+using netproj::JobGateway;
+using netproj::JobResultMsg;
+using netproj::JobStatus;
+using netproj::SubmitMsg;
+
+namespace {
+
+HttpRequest postJobs(const QByteArray &body, const QString &query = QString()) {
+    HttpRequest req;
+    req.method = "POST";
+    req.path = "/jobs";
+    req.query = query;
+    req.body = body;
+    return req;
+}
+
+JobResultMsg okResult(quint64 requestId, double value) {
+    JobResultMsg r;
+    r.requestId = requestId;
+    r.jobId = 100 + requestId;
+    r.status = JobStatus::Ok;
+    r.value = value;
+    return r;
+}
+
+} // namespace
+
+TEST(JobGateway, BatchesConcurrentRequestsIntoOneSubmission) {
+    JobGateway gateway;
+    std::vector<std::vector<SubmitMsg>> batches;
+    gateway.setSubmitter([&batches](const std::vector<SubmitMsg> &jobs) { batches.push_back(jobs); });
+
+    std::optional<HttpResponse> first;
+    std::optional<HttpResponse> second;
+    gateway.handleSubmit(postJobs(R"({"a": 2, "b": 10, "h": 1e-4, "method": "simpson"})"),
+                         [&first](const HttpResponse &r) { first = r; });
+    gateway.handleSubmit(postJobs(R"([{"a": 2, "b": 20, "h": 1e-4}, {"a": 2, "b": 30, "h": 1e-4}])"),
+                         [&second](const HttpResponse &r) { second = r; });
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->status, 202);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->status, 202);
+    EXPECT_TRUE(batches.empty());
+    EXPECT_EQ(gateway.pendingCount(), 3);
+
+    gateway.flush();
+    ASSERT_EQ(batches.size(), 1u);
+    ASSERT_EQ(batches[0].size(), 3u);
+    EXPECT_EQ(batches[0][0].requestId, 1u);
+    EXPECT_EQ(batches[0][2].requestId, 3u);
+    EXPECT_DOUBLE_EQ(batches[0][2].b, 30.0);
+    gateway.flush();
+    EXPECT_EQ(batches.size(), 1u);
+}
+
+TEST(JobGateway, AnswersWaitingRequestsWhenAllJobsFinish) {
+    JobGateway gateway;
+    gateway.setSubmitter([](const std::vector<SubmitMsg> &) {});
+
+    std::optional<HttpResponse> response;
+    gateway.handleSubmit(postJobs(R"([{"a": 2, "b": 10, "h": 1e-4}, {"a": 2, "b": 20, "h": 1e-4}])", "wait=1"),
+                         [&response](const HttpResponse &r) { response = r; });
+    gateway.flush();
+    EXPECT_FALSE(response.has_value());
+
+    gateway.deliver(okResult(2, 8.5));
+    EXPECT_FALSE(response.has_value());
+    gateway.deliver(okResult(1, 4.25));
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(response->status, 200);
+    EXPECT_EQ(gateway.pendingCount(), 0);
+
+    const QJsonArray jobs = QJsonDocument::fromJson(response->body).object().value("jobs").toArray();
+    ASSERT_EQ(jobs.size(), 2);
+    EXPECT_EQ(jobs[0].toObject().value("id").toInt(), 1);
+    EXPECT_EQ(jobs[0].toObject().value("status").toString(), "ok");
+    EXPECT_DOUBLE_EQ(jobs[0].toObject().value("value").toDouble(), 4.25);
+    EXPECT_DOUBLE_EQ(jobs[1].toObject().value("value").toDouble(), 8.5);
+}
+
+TEST(JobGateway, ReportsJobsForPolling) {
+    JobGateway gateway;
+    gateway.setSubmitter([](const std::vector<SubmitMsg> &) {});
+    std::optional<HttpResponse> response;
+    gateway.handleSubmit(postJobs("2 10 1e-4 3"), [&response](const HttpResponse &r) { response = r; });
+    ASSERT_TRUE(response.has_value());
+
+    HttpRequest poll;
+    poll.method = "GET";
+    poll.path = "/jobs";
+    poll.query = "id=1";
+    EXPECT_EQ(QJsonDocument::fromJson(gateway.handleStatus(poll).body).object().value("status").toString(), "pending");
+    gateway.deliver(okResult(1, 4.0));
+    const HttpResponse done = gateway.handleStatus(poll);
+    EXPECT_EQ(done.status, 200);
+    EXPECT_EQ(QJsonDocument::fromJson(done.body).object().value("status").toString(), "ok");
+
+    poll.query = "id=7";
+    EXPECT_EQ(gateway.handleStatus(poll).status, 404);
+    poll.query = "job=1";
+    EXPECT_EQ(gateway.handleStatus(poll).status, 400);
+
+    response.reset();
+    gateway.handleSubmit(postJobs(R"({"a": 0.5, "b": 10, "h": 1e-4})"),
+                         [&response](const HttpResponse &r) { response = r; });
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(response->status, 400);
+}
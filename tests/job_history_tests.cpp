@@ -0,0 +1,118 @@
+#include "../src/common/job_history.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using netproj::JobHistoryIndex;
+using netproj::JobHistoryLog;
+using netproj::JobHistoryQuery;
+using netproj::JobRecord;
+using netproj::JobStatus;
+using netproj::MethodType;
+
+namespace {
+
+JobRecord record(qint64 finishedMs, double a, double b, double h, double value, const QString &tenant = "default") {
+    JobRecord r;
+    r.finishedMs = finishedMs;
+    r.a = a;
+    r.b = b;
+    r.h = h;
+    r.value = value;
+    r.tenant = tenant;
+    return r;
+}
+
+} // namespace
+
+TEST(JobHistory, RoundTripsRecords) {
+    JobRecord r = record(1700000000000, 10.0, 2.0, 1e-4, -5.1204, "lab");
+    r.jobId = 42;
+    r.method = MethodType::Trapezoids;
+    r.status = JobStatus::Failed;
+    r.error = "worker lost";
+    r.computeMs = 12.5;
+    r.evaluations = 80000;
+    r.workerComputeMs.insert("node-a", 7.5);
+    r.workerEvaluations.insert("node-a", 50000);
+
+    const QByteArray log = JobHistoryLog::header() + JobHistoryLog::encode(r);
+    QString error;
+    ASSERT_TRUE(JobHistoryLog::checkHeader(log.constData(), log.size(), &error)) << error.toStdString();
+
+    JobRecord decoded;
+    const qsizetype frame = log.size() - JobHistoryLog::kHeaderSize;
+    ASSERT_EQ(JobHistoryLog::decode(log.constData() + JobHistoryLog::kHeaderSize, frame, &decoded), frame);
+    EXPECT_EQ(decoded.finishedMs, r.finishedMs);
+    EXPECT_EQ(decoded.jobId, 42u);
+    EXPECT_DOUBLE_EQ(decoded.a, 10.0);
+    EXPECT_DOUBLE_EQ(decoded.value, -5.1204);
+    EXPECT_EQ(decoded.method, MethodType::Trapezoids);
+    EXPECT_EQ(decoded.status, JobStatus::Failed);
+    EXPECT_EQ(decoded.tenant, "lab");
+    EXPECT_EQ(decoded.error, "worker lost");
+    EXPECT_TRUE(std::isnan(decoded.errorEstimate));
+    EXPECT_EQ(decoded.workerEvaluations.value("node-a"), 50000u);
+
+    // A record cut short by a killed writer, or damaged, is not taken for a record.
+    EXPECT_EQ(JobHistoryLog::decode(log.constData() + JobHistoryLog::kHeaderSize, frame - 1, &decoded), 0);
+    QByteArray damaged = log;
+    damaged[damaged.size() - 3] = static_cast<char>(damaged[damaged.size() - 3] ^ 0x10);
+    EXPECT_EQ(JobHistoryLog::decode(damaged.constData() + JobHistoryLog::kHeaderSize, frame, &decoded), 0);
+    EXPECT_FALSE(JobHistoryLog::checkHeader("NPSL\0\1\0\0", 8, &error));
+}
+
+TEST(JobHistory, FindsRecordsByTimeAndParameters) {
+    JobHistoryIndex index;
+    index.add(100, record(1000, 2.0, 10.0, 1e-4, 5.12));
+    index.add(200, record(2000, 10.0, 2.0, 1e-4, -5.12, "lab"));
+    index.add(300, record(3000, 2.0, 20.0, 1e-4, 9.9));
+    JobRecord failed = record(4000, 2.0, 10.0, 1e-5, 0.0);
+    failed.status = JobStatus::Failed;
+    index.add(400, failed);
+
+    JobHistoryQuery q;
+    EXPECT_EQ(index.find(q), (std::vector<qint64>{100, 200, 300, 400}));
+    q.sinceMs = 2000;
+    q.untilMs = 4000;
+    EXPECT_EQ(index.find(q), (std::vector<qint64>{200, 300}));
+
+    JobHistoryQuery byInterval;
+    byInterval.interval = qMakePair(10.0, 2.0);
+    EXPECT_EQ(index.find(byInterval), (std::vector<qint64>{100, 200, 400}));
+    byInterval.h = 1e-4;
+    EXPECT_EQ(index.find(byInterval), (std::vector<qint64>{100, 200}));
+    byInterval.tenant = "lab";
+    EXPECT_EQ(index.find(byInterval), (std::vector<qint64>{200}));
+    byInterval.method = MethodType::Trapezoids;
+    EXPECT_TRUE(index.find(byInterval).empty());
+
+    JobHistoryQuery newest;
+    newest.status = JobStatus::Ok;
+    newest.limit = 2;
+    EXPECT_EQ(index.find(newest), (std::vector<qint64>{200, 300}));
+
+    EXPECT_EQ(index.latestOk(10.0, 2.0, 1e-4, MethodType::Simpson), 200);
+    EXPECT_EQ(index.latestOk(2.0, 10.0, 1e-5, MethodType::Simpson), -1);
+    EXPECT_EQ(index.latestOk(2.0, 10.0, 1e-4, MethodType::Trapezoids), -1);
+}
+
+TEST(JobHistory, EstimatesErrorAgainstOtherStepSizes) {
+    // Synthetic Simpson results with error C*h^4 around the exact value.
+    const double exact = 5.1204;
+    const double c = 2.0e6;
+    const auto simpson = [&](double h) { return exact + c * std::pow(h, 4); };
+
+    JobHistoryIndex index;
+    EXPECT_TRUE(std::isnan(index.errorEstimate(record(1000, 2.0, 10.0, 1e-2, simpson(1e-2)))));
+    index.add(100, record(1000, 2.0, 10.0, 1e-2, simpson(1e-2)));
+    index.add(200, record(2000, 2.0, 10.0, 4e-3, simpson(4e-3)));
+
+    // The nearest other step (4e-3) is used; the reversed interval compares with the negated value.
+    const JobRecord fine = record(3000, 10.0, 2.0, 2e-3, -simpson(2e-3));
+    EXPECT_NEAR(index.errorEstimate(fine), c * std::pow(2e-3, 4), 1e-12);
+    JobRecord trapezoids = fine;
+    trapezoids.method = MethodType::Trapezoids;
+    EXPECT_TRUE(std::isnan(index.errorEstimate(trapezoids)));
+}
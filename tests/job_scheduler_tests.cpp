@@ -0,0 +1,176 @@
+#include "../src/common/integrator.h"
+#include "../src/server/job_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using netproj::Assignment;
+using netproj::JobPriority;
+using netproj::JobScheduler;
+using netproj::JobSpec;
+using netproj::MethodType;
+using netproj::WorkUnit;
+
+static JobSpec makeJob(const QString &tenant, JobPriority priority, double a = 2.0, double b = 10.0, double h = 1e-3) {
+    JobSpec s;
+    s.a = a;
+    s.b = b;
+    s.h = h;
+    s.method = MethodType::Simpson;
+    s.tenant = tenant;
+    s.priority = priority;
+    return s;
+}
+
+/**
+ * @brief Run all work to completion, computing units locally.
+ */
+static void drain(JobScheduler &sched) {
+    for (;;) {
+        const auto assignments = sched.schedule();
+        if (assignments.empty()) {
+            return;
+        }
+        for (const Assignment &as : assignments) {
+            const double v = netproj::Integrator::integrate(as.unit.a, as.unit.b, as.unit.h, as.unit.method);
+            sched.unitCompleted(as.worker, as.unit.unitId, v);
+        }
+    }
+}
+
+TEST(JobScheduler, SplitJobMatchesSingleIntegration) {
+    JobScheduler sched;
+    sched.setGranularity(3);
+    sched.addWorker(1, 4);
+    sched.addWorker(2, 2);
+    sched.addWorker(3, 1);
+
+    const JobSpec spec = makeJob("t", JobPriority::Normal, 10.0, 2.0);
+    const quint64 id = sched.submit(spec);
+    drain(sched);
+
+    const auto finished = sched.takeFinished();
+    ASSERT_EQ(finished.size(), 1u);
+    EXPECT_EQ(finished[0].jobId, id);
+    EXPECT_EQ(finished[0].status, netproj::JobStatus::Ok);
+    const double whole = netproj::Integrator::integrate(2.0, 10.0, 1e-3, MethodType::Simpson);
+    EXPECT_NEAR(finished[0].value, -whole, 1e-9);
+}
+
+TEST(JobScheduler, FairShareAlternatesTenants) {
+    JobScheduler sched;
+    sched.setGranularity(8);
+    sched.addWorker(1, 1);
+
+    sched.submit(makeJob("big", JobPriority::Normal));
+    sched.submit(makeJob("big", JobPriority::Normal));
+    const quint64 small = sched.submit(makeJob("small", JobPriority::Normal));
+
+    // Big tenant gets the first unit, then the small tenant is behind in usage and goes next.
+    auto first = sched.schedule();
+    ASSERT_EQ(first.size(), 1u);
+    sched.unitCompleted(1, first[0].unit.unitId, 0.0);
+    auto second = sched.schedule();
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0].unit.jobId, small);
+}
+
+TEST(JobScheduler, HigherPriorityPreemptsLowerPriority) {
+    JobScheduler sched;
+    sched.addWorker(1, 1);
+
+    sched.submit(makeJob("sweep", JobPriority::Batch));
+    const auto running = sched.schedule();
+    ASSERT_EQ(running.size(), 1u);
+
+    const quint64 urgent = sched.submit(makeJob("ui", JobPriority::Interactive));
+    EXPECT_TRUE(sched.schedule().empty());
+
+    const auto victims = sched.preempt();
+    ASSERT_EQ(victims.size(), 1u);
+    EXPECT_EQ(victims[0].unit.unitId, running[0].unit.unitId);
+    EXPECT_TRUE(sched.preempt().empty());
+
+    sched.unitCancelled(1, victims[0].unit.unitId);
+    const auto next = sched.schedule();
+    ASSERT_EQ(next.size(), 1u);
+    EXPECT_EQ(next[0].unit.jobId, urgent);
+}
+
+TEST(JobScheduler, LostWorkerRequeuesUnit) {
+    JobScheduler sched;
+    sched.addWorker(1, 1);
+    sched.addWorker(2, 1);
+    sched.submit(makeJob("t", JobPriority::Normal));
+
+    const auto assignments = sched.schedule();
+    ASSERT_EQ(assignments.size(), 2u);
+    sched.removeWorker(assignments[0].worker);
+    sched.unitCompleted(assignments[1].worker, assignments[1].unit.unitId,
+                        netproj::Integrator::integrate(assignments[1].unit.a, assignments[1].unit.b,
+                                                       assignments[1].unit.h, assignments[1].unit.method));
+    drain(sched);
+
+    const auto finished = sched.takeFinished();
+    ASSERT_EQ(finished.size(), 1u);
+    EXPECT_NEAR(finished[0].value, netproj::Integrator::integrate(2.0, 10.0, 1e-3, MethodType::Simpson), 1e-9);
+    const WorkUnit &lost = assignments[0].unit;
+    EXPECT_EQ(finished[0].requeuedUnits, 1u);
+    EXPECT_EQ(finished[0].requeuedSteps, static_cast<quint64>(std::llround((lost.b - lost.a) / lost.h)));
+}
+
+TEST(JobScheduler, JobKeyIgnoresOrientationTenantAndPriority) {
+    const JobSpec forward = makeJob("a", JobPriority::Batch, 2.0, 10.0);
+    const JobSpec reversed = makeJob("b", JobPriority::Interactive, 10.0, 2.0);
+    EXPECT_TRUE(netproj::JobKey::of(forward) == netproj::JobKey::of(reversed));
+    EXPECT_EQ(qHash(netproj::JobKey::of(forward)), qHash(netproj::JobKey::of(reversed)));
+    EXPECT_FALSE(netproj::JobKey::of(forward) == netproj::JobKey::of(makeJob("a", JobPriority::Batch, 2.0, 10.0, 1e-4)));
+}
+
+TEST(JobScheduler, RaisedPriorityPreempts) {
+    JobScheduler sched;
+    sched.addWorker(1, 1);
+    sched.submit(makeJob("sweep", JobPriority::Batch));
+    ASSERT_EQ(sched.schedule().size(), 1u);
+
+    const quint64 shared = sched.submit(makeJob("other", JobPriority::Batch, 20.0, 30.0));
+    EXPECT_TRUE(sched.preempt().empty());
+    sched.raisePriority(shared, JobPriority::Interactive);
+    EXPECT_EQ(sched.preempt().size(), 1u);
+}
+
+TEST(JobScheduler, FederatedJobsAreNotRelayed) {
+    JobScheduler sched;
+    sched.addWorker(1, 8, true);
+    JobSpec shard = makeJob("federation", JobPriority::Batch);
+    shard.federated = true;
+    sched.submit(shard);
+    EXPECT_TRUE(sched.schedule().empty());
+
+    sched.addWorker(2, 1);
+    const auto assignments = sched.schedule();
+    ASSERT_EQ(assignments.size(), 1u);
+    EXPECT_EQ(assignments[0].worker, 2);
+}
+
+TEST(JobScheduler, DrainingWorkerHandsBackPartialUnit) {
+    JobScheduler sched;
+    sched.addWorker(1, 1);
+    sched.submit(makeJob("t", JobPriority::Normal));
+    const auto first = sched.schedule();
+    ASSERT_EQ(first.size(), 1u);
+
+    sched.drainWorker(1);
+    const WorkUnit &u = first[0].unit;
+    const quint64 steps = 2 * (netproj::Integrator::stepCount(u.a, u.b, u.h) / 4);
+    const double done = u.a + static_cast<double>(steps) * u.h;
+    EXPECT_TRUE(sched.unitPartial(1, u.unitId, steps, netproj::Integrator::integrate(u.a, done, u.h, u.method)));
+    EXPECT_TRUE(sched.schedule().empty());
+
+    sched.addWorker(2, 1);
+    drain(sched);
+    const auto finished = sched.takeFinished();
+    ASSERT_EQ(finished.size(), 1u);
+    EXPECT_NEAR(finished[0].value, netproj::Integrator::integrate(2.0, 10.0, 1e-3, MethodType::Simpson), 1e-9);
+}
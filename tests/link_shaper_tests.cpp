@@ -0,0 +1,73 @@
+#include "../src/proxy/link_shaper.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using netproj::ImpairmentSpec;
+using netproj::LinkShaper;
+
+TEST(LinkShaper, AddsDelayAndSerializesOnBandwidth) {
+    ImpairmentSpec spec;
+    spec.delayMs = 10.0;
+    spec.bandwidthKbps = 8000.0; // 1 byte per microsecond
+    LinkShaper shaper(spec, 1);
+
+    EXPECT_EQ(shaper.schedule(0, 1000), 1000 + 10000);
+    // Queued behind the first frame on the link.
+    EXPECT_EQ(shaper.schedule(0, 500), 1500 + 10000);
+    // The link is idle again later.
+    EXPECT_EQ(shaper.schedule(100000, 1000), 101000 + 10000);
+}
+
+TEST(LinkShaper, JitterNeverReorders) {
+    ImpairmentSpec spec;
+    spec.delayMs = 5.0;
+    spec.jitterMs = 20.0;
+    LinkShaper shaper(spec, 7);
+
+    qint64 last = 0;
+    for (qint64 t = 0; t < 1000000; t += 1000) {
+        const qint64 d = shaper.schedule(t, 100);
+        EXPECT_GE(d, t + 5000);
+        EXPECT_LE(d, std::max(last, t + 25000));
+        EXPECT_GE(d, last);
+        last = d;
+    }
+}
+
+TEST(LinkShaper, HoldsFramesDuringStalls) {
+    ImpairmentSpec spec;
+    spec.stallEveryMs = 50.0;
+    spec.stallMs = 20.0;
+    LinkShaper shaper(spec, 3);
+
+    int held = 0;
+    for (qint64 t = 0; t < 10000000; t += 1000) {
+        const qint64 d = shaper.schedule(t, 10);
+        EXPECT_GE(d, t);
+        EXPECT_LE(d, t + 20000);
+        held += (d > t) ? 1 : 0;
+    }
+    // About 20 / (50 + 20) of the time is spent stalled.
+    EXPECT_GT(held, 2000);
+    EXPECT_LT(held, 4000);
+}
+
+TEST(LinkShaper, ParsesImpairments) {
+    ImpairmentSpec spec;
+    QString error;
+    ASSERT_TRUE(
+        netproj::parseImpairment("delay=20, jitter=5,bandwidth=10000,stall-every=2000,stall=300", &spec, &error));
+    EXPECT_DOUBLE_EQ(spec.delayMs, 20.0);
+    EXPECT_DOUBLE_EQ(spec.jitterMs, 5.0);
+    EXPECT_DOUBLE_EQ(spec.bandwidthKbps, 10000.0);
+    EXPECT_DOUBLE_EQ(spec.stallEveryMs, 2000.0);
+    EXPECT_DOUBLE_EQ(spec.stallMs, 300.0);
+    EXPECT_FALSE(spec.isNone());
+
+    EXPECT_FALSE(netproj::parseImpairment("latency=20", &spec, &error));
+    EXPECT_FALSE(netproj::parseImpairment("delay=-1", &spec, &error));
+    EXPECT_TRUE(netproj::parseImpairment("", &spec, &error));
+    EXPECT_TRUE(spec.isNone());
+}
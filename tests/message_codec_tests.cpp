@@ -0,0 +1,122 @@
+#include "../src/common/alloc_counter.h"
+#include "../src/common/frame_decoder.h"
+#include "../src/common/message_codec.h"
+
+#include <QtEndian>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace netproj;
+
+namespace {
+
+TaskMsg sampleTask(quint64 unitId) {
+    TaskMsg m;
+    m.a = 2.0;
+    m.b = 2.5;
+    m.h = 1e-7;
+    m.jobId = 42;
+    m.unitId = unitId;
+    m.verifyBlocks = 8;
+    return m;
+}
+
+ResultMsg sampleResult(quint64 unitId) {
+    ResultMsg m;
+    m.jobId = 42;
+    m.unitId = unitId;
+    m.value = 0.3141592653589793;
+    m.computeMs = 12.5;
+    m.blockSums.fill(m.value / 8, 8);
+    m.telemetry.cpuMs = 50.0;
+    m.telemetry.threads = 4;
+    m.telemetry.kernel = "simpson-avx2";
+    return m;
+}
+
+/**
+ * @brief Frame payload into the decoder as FramedSocket does: header and payload read in place, then a view.
+ */
+bool transfer(FrameDecoder *decoder, const QByteArray &payload, QByteArray *received) {
+    char *dst = decoder->prepareAppend(FrameDecoder::kHeaderSize + payload.size());
+    qToBigEndian(static_cast<quint32>(payload.size()), dst);
+    std::memcpy(dst + FrameDecoder::kHeaderSize, payload.constData(), static_cast<size_t>(payload.size()));
+    decoder->commitAppend(FrameDecoder::kHeaderSize + payload.size());
+    return decoder->nextView(received);
+}
+
+} // namespace
+
+TEST(MessageCodec, RoundTripsLikeParseMessage) {
+    MessageCodec codec;
+    const QByteArray task = codec.serialize(MessageType::Task, sampleTask(7));
+    EXPECT_EQ(task, serializeTask(sampleTask(7)));
+
+    const ParsedMessage &pm = codec.parse(task);
+    ASSERT_TRUE(pm.ok) << pm.parseError.toStdString();
+    EXPECT_EQ(pm.env.type, MessageType::Task);
+    EXPECT_EQ(pm.task.unitId, 7u);
+    EXPECT_EQ(pm.task.verifyBlocks, 8u);
+
+    // A shorter message after a longer one must not carry the longer one's tail.
+    const QByteArray result = codec.serialize(MessageType::Result, sampleResult(9));
+    const QByteArray cancel = codec.serialize(MessageType::Cancel, CancelMsg{42, 9});
+    EXPECT_LT(cancel.size(), result.size());
+    EXPECT_EQ(cancel, serializeCancel(CancelMsg{42, 9}));
+
+    EXPECT_TRUE(codec.parse(result).ok);
+    EXPECT_EQ(codec.parse(result).result.telemetry.kernel, QString("simpson-avx2"));
+    EXPECT_EQ(codec.parse(result).result.blockSums.size(), 8);
+
+    EXPECT_FALSE(codec.parse(result.left(result.size() - 3)).ok);
+    EXPECT_FALSE(codec.parse(QByteArray()).ok);
+    // A failed parse does not poison the next one.
+    EXPECT_TRUE(codec.parse(cancel).ok);
+    EXPECT_EQ(codec.parse(cancel).cancel.unitId, 9u);
+}
+
+TEST(MessageCodec, SteadyStateTaskResultLoopDoesNotAllocate) {
+    if (!allocationCountingSupported()) {
+        GTEST_SKIP() << "allocation counting needs glibc";
+    }
+    // Server and worker ends of one connection, each with its own codec and decoder.
+    MessageCodec server;
+    MessageCodec worker;
+    FrameDecoder toWorker;
+    FrameDecoder toServer;
+    TaskMsg task = sampleTask(0);
+    ResultMsg result = sampleResult(0);
+    QByteArray payload;
+
+    bool ok = true;
+    quint64 checksum = 0;
+    const auto exchange = [&](quint64 unitId) {
+        task.unitId = unitId;
+        ok = ok && transfer(&toWorker, server.serialize(MessageType::Task, task), &payload);
+        const ParsedMessage &atWorker = worker.parse(payload);
+        ok = ok && atWorker.ok && atWorker.env.type == MessageType::Task;
+
+        result.unitId = atWorker.task.unitId;
+        ok = ok && transfer(&toServer, worker.serialize(MessageType::Result, result), &payload);
+        const ParsedMessage &atServer = server.parse(payload);
+        ok = ok && atServer.ok && atServer.env.type == MessageType::Result;
+        checksum += atServer.result.unitId;
+    };
+
+    // Warm-up grows every buffer to its steady size.
+    for (quint64 i = 0; i < 16; ++i) {
+        exchange(i);
+    }
+    checksum = 0;
+    const std::size_t before = allocationCount();
+    for (quint64 i = 0; i < 1000; ++i) {
+        exchange(i);
+    }
+    const std::size_t allocations = allocationCount() - before;
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(checksum, 999u * 1000u / 2u);
+    EXPECT_EQ(allocations, 0u) << "allocations per TASK/RESULT exchange: " << static_cast<double>(allocations) / 1000;
+}
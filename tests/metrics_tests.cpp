@@ -0,0 +1,43 @@
+#include "../src/server/metrics.h"
+
+#include <gtest/gtest.h>
+
+using netproj::LatencyHistogram;
+
+TEST(LatencyHistogram, BucketsBoundRelativeError) {
+    EXPECT_EQ(LatencyHistogram::bucketOf(0.0), 0);
+    EXPECT_EQ(LatencyHistogram::bucketOf(LatencyHistogram::kLowestSeconds), 0);
+    EXPECT_EQ(LatencyHistogram::bucketOf(1e6), LatencyHistogram::kBuckets);
+
+    for (double v = 2e-4; v < 1000.0; v *= 1.37) {
+        const int b = LatencyHistogram::bucketOf(v);
+        ASSERT_GT(b, 0);
+        ASSERT_LT(b, LatencyHistogram::kBuckets);
+        EXPECT_LE(v, LatencyHistogram::upperBound(b));
+        EXPECT_GT(v, LatencyHistogram::upperBound(b - 1));
+        EXPECT_LE(LatencyHistogram::upperBound(b) / v, 1.0 + 1.0 / LatencyHistogram::kSubBuckets + 1e-12);
+    }
+    // Powers of two close the last bucket of the octave below.
+    const double edge = 8 * LatencyHistogram::kLowestSeconds;
+    EXPECT_DOUBLE_EQ(LatencyHistogram::upperBound(LatencyHistogram::bucketOf(edge)), edge);
+}
+
+TEST(PrometheusWriter, HistogramIsCumulative) {
+    LatencyHistogram h;
+    h.record(0.001);
+    h.record(0.5);
+    h.record(1e6);
+
+    netproj::PrometheusWriter w;
+    w.family("lat_seconds", "histogram", "Latency.");
+    w.histogram("lat_seconds", h, {{"kind", "unit"}});
+    w.sample("up", 1, {{"name", "a\"b"}});
+    const QString text = QString::fromUtf8(w.text());
+
+    EXPECT_TRUE(text.startsWith("# HELP lat_seconds Latency.\n# TYPE lat_seconds histogram\n"));
+    EXPECT_TRUE(text.contains("lat_seconds_bucket{kind=\"unit\",le=\"0.001\"} 1\n"));
+    EXPECT_TRUE(text.contains("lat_seconds_bucket{kind=\"unit\",le=\"0.512\"} 2\n"));
+    EXPECT_TRUE(text.contains("lat_seconds_bucket{kind=\"unit\",le=\"+Inf\"} 3\n"));
+    EXPECT_TRUE(text.contains("lat_seconds_count{kind=\"unit\"} 3\n"));
+    EXPECT_TRUE(text.contains("up{name=\"a\\\"b\"} 1\n"));
+}
@@ -0,0 +1,61 @@
+#include "../src/server/result_verifier.h"
+
+#include <QRandomGenerator>
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+static netproj::WorkUnit makeUnit() {
+    netproj::WorkUnit u;
+    u.a = 2.0;
+    u.b = 10.0;
+    u.h = 1e-3;
+    u.method = netproj::MethodType::Simpson;
+    return u;
+}
+
+static netproj::ResultMsg honestResult(const netproj::ResultVerifier &v, const netproj::WorkUnit &u) {
+    netproj::ResultMsg r;
+    for (const netproj::Segment &s : v.unitBlocks(u)) {
+        r.blockSums.push_back(netproj::Integrator::integrate(s.a, s.b, u.h, u.method));
+        r.value += r.blockSums.back();
+    }
+    return r;
+}
+
+TEST(ResultVerifier, AcceptsHonestResult) {
+    const netproj::ResultVerifier v(8, 8);
+    const netproj::WorkUnit u = makeUnit();
+    const netproj::ResultMsg r = honestResult(v, u);
+
+    EXPECT_TRUE(v.checkConsistency(u, r).isEmpty());
+    QRandomGenerator rng(1);
+    const auto blocks = v.unitBlocks(u);
+    EXPECT_TRUE(v.recheck(u, blocks, v.pickSamples(static_cast<int>(blocks.size()), rng), r.blockSums).isEmpty());
+}
+
+TEST(ResultVerifier, CatchesCorruptedBlock) {
+    const netproj::ResultVerifier v(8, 8);
+    const netproj::WorkUnit u = makeUnit();
+    netproj::ResultMsg r = honestResult(v, u);
+    r.blockSums[3] += 1e-3;
+    r.value += 1e-3;
+
+    // Consistent sums, but recomputing the block exposes it.
+    EXPECT_TRUE(v.checkConsistency(u, r).isEmpty());
+    QRandomGenerator rng(1);
+    const auto blocks = v.unitBlocks(u);
+    EXPECT_FALSE(v.recheck(u, blocks, v.pickSamples(static_cast<int>(blocks.size()), rng), r.blockSums).isEmpty());
+
+    r.value += 1.0;
+    EXPECT_FALSE(v.checkConsistency(u, r).isEmpty());
+}
+
+TEST(ResultVerifier, SamplesAreDistinct) {
+    const netproj::ResultVerifier v(16, 5);
+    QRandomGenerator rng(42);
+    const auto samples = v.pickSamples(16, rng);
+    ASSERT_EQ(samples.size(), 5u);
+    EXPECT_EQ(std::set<int>(samples.begin(), samples.end()).size(), 5u);
+}
@@ -0,0 +1,22 @@
+#include "../src/harness/scaling.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+TEST(Scaling, StrongScalingMatchesAmdahl) {
+    // Amdahl with serial fraction 0.1 on 8 units: S = 1 / (0.1 + 0.9 / 8).
+    const double s = 1.0 / (0.1 + 0.9 / 8.0);
+    const netproj::ScalingMetrics m = netproj::strongScaling(100.0, 100.0 / s, 8);
+    EXPECT_NEAR(m.speedup, s, 1e-9);
+    EXPECT_NEAR(m.efficiency, s / 8.0, 1e-9);
+    EXPECT_NEAR(m.serialFraction, 0.1, 1e-9);
+    EXPECT_TRUE(std::isnan(netproj::strongScaling(100.0, 100.0, 1).serialFraction));
+}
+
+TEST(Scaling, PerfectWeakScaling) {
+    const netproj::ScalingMetrics m = netproj::weakScaling(50.0, 50.0, 4);
+    EXPECT_NEAR(m.speedup, 4.0, 1e-12);
+    EXPECT_NEAR(m.efficiency, 1.0, 1e-12);
+    EXPECT_NEAR(m.serialFraction, 0.0, 1e-12);
+}
@@ -0,0 +1,46 @@
+#include "../src/common/framed_socket.h"
+#include "../src/common/message_io.h"
+#include "../src/server/server_app.h"
+
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QTimer>
+
+using netproj::FramedSocket;
+using netproj::MessageType;
+
+TEST(ServerApp, OneShotExitsWithFailureWhenTheJobFails) {
+    int argc = 1;
+    char name[] = "netproj_tests";
+    char *argv[] = {name, nullptr};
+    QCoreApplication app(argc, argv);
+
+    netproj::ServerApp server;
+    server.setTask(2.0, 10.0, 1e-4, netproj::MethodType::Simpson);
+    ASSERT_TRUE(server.start(0, 1));
+
+    // A worker that reports an ERROR for every unit it gets, which fails the job.
+    QTcpSocket socket;
+    FramedSocket worker(&socket);
+    QObject::connect(&socket, &QTcpSocket::connected, [&worker]() {
+        netproj::HelloMsg hello;
+        hello.cores = 1;
+        hello.workerId = "failing";
+        worker.sendFrame(netproj::serializeHello(hello));
+    });
+    QObject::connect(&worker, &FramedSocket::frameReceived, [&worker](const QByteArray &payload) {
+        if (netproj::parseMessage(payload).env.type != MessageType::Task) {
+            return;
+        }
+        netproj::ErrorMsg err;
+        err.text = "integrand overflow";
+        worker.sendFrame(netproj::serializeError(err));
+    });
+    socket.connectToHost(QHostAddress::LocalHost, server.port());
+
+    QTimer::singleShot(10000, &app, []() { QCoreApplication::exit(-1); });
+    EXPECT_EQ(app.exec(), 1);
+}
@@ -0,0 +1,54 @@
+#include "../src/common/session_log.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using netproj::SessionDecoder;
+using netproj::SessionEvent;
+using netproj::SessionLog;
+using netproj::SessionRecord;
+
+TEST(SessionLog, RoundTripsRecords) {
+    const std::vector<SessionRecord> records = {
+        {0, 1, SessionEvent::Open, QByteArray()},
+        {150, 1, SessionEvent::In, QByteArray("hello")},
+        {200000, 7, SessionEvent::Out, QByteArray(300, 'x')},
+        {200000, 1, SessionEvent::Close, QByteArray()},
+    };
+    QByteArray log = SessionLog::header();
+    qint64 lastUs = 0;
+    for (const SessionRecord &r : records) {
+        SessionLog::append(&log, r, &lastUs);
+    }
+    // Small records cost a few bytes besides the payload.
+    EXPECT_LT(log.size(), SessionLog::kHeaderSize + 5 + 300 + 4 * 6);
+
+    SessionDecoder d;
+    ASSERT_TRUE(d.reset(log));
+    SessionRecord r;
+    for (const SessionRecord &expected : records) {
+        ASSERT_TRUE(d.next(&r));
+        EXPECT_EQ(r.timeUs, expected.timeUs);
+        EXPECT_EQ(r.connection, expected.connection);
+        EXPECT_EQ(r.event, expected.event);
+        EXPECT_EQ(r.payload, expected.payload);
+    }
+    EXPECT_FALSE(d.next(&r));
+    EXPECT_TRUE(d.error().isEmpty());
+}
+
+TEST(SessionLog, ReportsTruncationAndForeignFiles) {
+    QByteArray log = SessionLog::header();
+    qint64 lastUs = 0;
+    SessionLog::append(&log, SessionRecord{10, 2, SessionEvent::In, QByteArray("payload")}, &lastUs);
+
+    SessionDecoder d;
+    ASSERT_TRUE(d.reset(log.left(log.size() - 3)));
+    SessionRecord r;
+    EXPECT_FALSE(d.next(&r));
+    EXPECT_FALSE(d.error().isEmpty());
+
+    EXPECT_FALSE(d.reset(QByteArray("GIF89a..")));
+    EXPECT_FALSE(d.error().isEmpty());
+}
@@ -0,0 +1,24 @@
+#include "../src/common/tracing.h"
+
+#include <gtest/gtest.h>
+
+using netproj::ClockSync;
+
+TEST(ClockSync, KeepsSampleWithShortestRoundTrip) {
+    ClockSync sync;
+    EXPECT_FALSE(sync.valid());
+
+    // Remote clock is 5000 us ahead; the first sample has an asymmetric 900/100 us path.
+    sync.addSample(0, 5900, 5910, 1010);
+    EXPECT_EQ(sync.rttUs(), 1000);
+    EXPECT_EQ(sync.offsetUs(), 5400);
+
+    // Symmetric 50 us path wins and is exact.
+    sync.addSample(2000, 7050, 7060, 2110);
+    EXPECT_EQ(sync.rttUs(), 100);
+    EXPECT_EQ(sync.offsetUs(), 5000);
+    EXPECT_EQ(sync.toLocal(8000), 3000);
+
+    sync.addSample(3000, 8500, 8500, 3600);
+    EXPECT_EQ(sync.offsetUs(), 5000);
+}
@@ -0,0 +1,29 @@
+#include "../src/server/worker_profiles.h"
+
+#include <gtest/gtest.h>
+
+TEST(WorkerProfiles, UnknownWorkerHasNoRate) {
+    netproj::WorkerProfileStore store;
+    EXPECT_FALSE(store.rate("w1", netproj::MethodType::Simpson, 1e-4, 0).has_value());
+}
+
+TEST(WorkerProfiles, FallsBackToOtherPrecision) {
+    netproj::WorkerProfileStore store;
+    store.record("w1", netproj::MethodType::Simpson, 1e-4, 1000000, 1.0, 0);
+    const auto r = store.rate("w1", netproj::MethodType::Simpson, 1e-6, 0);
+    ASSERT_TRUE(r.has_value());
+    EXPECT_DOUBLE_EQ(*r, 1e6);
+    EXPECT_FALSE(store.rate("w1", netproj::MethodType::Trapezoids, 1e-4, 0).has_value());
+}
+
+TEST(WorkerProfiles, OldObservationsDecay) {
+    netproj::WorkerProfileStore store(10.0);
+    for (int i = 0; i < 10; ++i) {
+        store.record("w1", netproj::MethodType::Simpson, 1e-4, 1000, 1.0, 0);
+    }
+    // Worker got 10x slower; after a few half-lives the new observation dominates.
+    store.record("w1", netproj::MethodType::Simpson, 1e-4, 100, 1.0, 200000);
+    const auto r = store.rate("w1", netproj::MethodType::Simpson, 1e-4, 200000);
+    ASSERT_TRUE(r.has_value());
+    EXPECT_NEAR(*r, 100.0, 1.0);
+}